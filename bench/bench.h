@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------------
+/**
+ * @file bench.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief lib_weather benchmark 공통 함수.
+ * @version 2.0
+ * @date 2025-05-14
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+//------------------------------------------------------------------------------
+// monotonic 시간 (ns)
+//------------------------------------------------------------------------------
+static inline uint64_t bench_now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int bench_cmp_u64 (const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+//------------------------------------------------------------------------------
+// 결과 출력 (Go benchmark 형식, benchstat 으로 release 간 비교 가능)
+//   Benchmark{name} {n} {ns/op} [{B/op} {allocs/op}] {p50-ns} {p99-ns} {max-ns}
+// samples 는 per 번 실행한 시간 (정렬됨), bytes_op/allocs_op < 0 이면 출력안함
+// 설명 등 다른 출력은 '#' 으로 시작함.
+//------------------------------------------------------------------------------
+static inline void bench_report_ex (const char *name, uint64_t *samples, size_t cnt,
+                                    unsigned int per, double bytes_op, double allocs_op)
+{
+    uint64_t sum = 0;
+
+    printf ("Benchmark");
+    for (const char *p = name; *p; p++)
+        putchar ((*p == ' ' || *p == '\t') ? '_' : *p);
+
+    if (!cnt || !per) {
+        printf ("\t0\n");
+        return;
+    }
+    qsort (samples, cnt, sizeof(samples[0]), bench_cmp_u64);
+
+    for (size_t i = 0; i < cnt; i++)
+        sum += samples[i];
+
+    printf ("\t%zu\t%.1f ns/op", cnt * per, (double)sum / cnt / per);
+    if (bytes_op >= 0 && allocs_op >= 0)
+        printf ("\t%.0f B/op\t%.1f allocs/op", bytes_op, allocs_op);
+    printf ("\t%.1f p50-ns\t%.1f p99-ns\t%.1f max-ns\n",
+        (double)samples[cnt / 2] / per,
+        (double)samples[(cnt * 99) / 100] / per,
+        (double)samples[cnt - 1] / per);
+    fflush (stdout);
+}
+
+static inline void bench_report (const char *name, uint64_t *samples, size_t cnt)
+{
+    bench_report_ex (name, samples, cnt, 1, -1, -1);
+}
+
+//------------------------------------------------------------------------------
+// fixture 파일 읽기 (반환값은 free 필요, '\0' 로 끝남)
+//------------------------------------------------------------------------------
+static inline char *bench_load_file (const char *path, size_t *len)
+{
+    FILE *fp = fopen (path, "rb");
+    char *buf = NULL;
+    long size;
+
+    if (!fp) return NULL;
+
+    if (!fseek (fp, 0, SEEK_END) && (size = ftell (fp)) > 0 && !fseek (fp, 0, SEEK_SET) &&
+        (buf = malloc (size + 1)) != NULL) {
+        *len = fread (buf, 1, size, fp);
+        buf[*len] = '\0';
+    }
+    fclose (fp);
+    return buf;
+}
+
+//------------------------------------------------------------------------------
+#endif  // __BENCH_H__
+//------------------------------------------------------------------------------
@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------
+/**
+ * @file bench_alloc.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief benchmark 용 heap 사용량 측정 (malloc/free 대체).
+ * @version 2.0
+ * @date 2025-05-14
+ *
+ * 실행파일에서 malloc 계열 함수를 재정의하면 공유 라이브러리(cJSON, cURL)의
+ * 할당도 함께 측정됨. benchmark 파일 하나에서만 include 해야 함.
+ * 정렬 할당(memalign 계열)도 재정의해야 free 에서 사용량이 음수가 되지 않음.
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __BENCH_ALLOC_H__
+#define __BENCH_ALLOC_H__
+
+#include <stddef.h>
+#include <errno.h>
+#include <malloc.h>
+
+extern void *__libc_malloc   (size_t size);
+extern void *__libc_calloc   (size_t nmemb, size_t size);
+extern void *__libc_realloc  (void *ptr, size_t size);
+extern void  __libc_free     (void *ptr);
+extern void *__libc_memalign (size_t align, size_t size);
+extern void *__libc_valloc   (size_t size);
+extern void *__libc_pvalloc  (size_t size);
+
+static size_t BenchAllocCount = 0;      /* 할당 횟수 */
+static size_t BenchAllocTotal = 0;      /* 할당한 크기 합 */
+static size_t BenchAllocBytes = 0;      /* 현재 사용중인 heap */
+static size_t BenchAllocPeak  = 0;      /* 최대 사용 heap */
+
+static inline void bench_alloc_add (void *ptr)
+{
+    size_t cur, size, peak;
+
+    if (!ptr)   return;
+
+    size = malloc_usable_size (ptr);
+
+    __atomic_add_fetch (&BenchAllocCount, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch (&BenchAllocTotal, size, __ATOMIC_RELAXED);
+    cur = __atomic_add_fetch (&BenchAllocBytes, size, __ATOMIC_RELAXED);
+
+    /* 여러 thread 가 동시에 갱신해도 최대값이 줄어들지 않도록 CAS */
+    peak = __atomic_load_n (&BenchAllocPeak, __ATOMIC_RELAXED);
+    while (cur > peak &&
+           !__atomic_compare_exchange_n (&BenchAllocPeak, &peak, cur, 1,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static inline void bench_alloc_sub (void *ptr)
+{
+    if (ptr)    __atomic_sub_fetch (&BenchAllocBytes, malloc_usable_size (ptr), __ATOMIC_RELAXED);
+}
+
+void *malloc (size_t size)
+{
+    void *ptr = __libc_malloc (size);
+    bench_alloc_add (ptr);
+    return ptr;
+}
+
+void *calloc (size_t nmemb, size_t size)
+{
+    void *ptr = __libc_calloc (nmemb, size);
+    bench_alloc_add (ptr);
+    return ptr;
+}
+
+void *realloc (void *ptr, size_t size)
+{
+    bench_alloc_sub (ptr);
+    ptr = __libc_realloc (ptr, size);
+    bench_alloc_add (ptr);
+    return ptr;
+}
+
+void free (void *ptr)
+{
+    bench_alloc_sub (ptr);
+    __libc_free (ptr);
+}
+
+void *memalign (size_t align, size_t size)
+{
+    void *ptr = __libc_memalign (align, size);
+    bench_alloc_add (ptr);
+    return ptr;
+}
+
+void *aligned_alloc (size_t align, size_t size)
+{
+    return memalign (align, size);
+}
+
+int posix_memalign (void **memptr, size_t align, size_t size)
+{
+    void *ptr;
+
+    /* 2의 거듭제곱이면서 sizeof(void *) 의 배수만 허용 (POSIX) */
+    if (!align || (align & (align - 1)) || (align % sizeof (void *)))
+        return EINVAL;
+
+    if (!(ptr = memalign (align, size)))
+        return ENOMEM;
+
+    *memptr = ptr;
+    return 0;
+}
+
+void *valloc (size_t size)
+{
+    void *ptr = __libc_valloc (size);
+    bench_alloc_add (ptr);
+    return ptr;
+}
+
+void *pvalloc (size_t size)
+{
+    void *ptr = __libc_pvalloc (size);
+    bench_alloc_add (ptr);
+    return ptr;
+}
+
+//------------------------------------------------------------------------------
+// 측정 구간 시작, 반환값은 peak 의 기준값
+//------------------------------------------------------------------------------
+static inline size_t bench_alloc_reset (void)
+{
+    size_t cur = __atomic_load_n (&BenchAllocBytes, __ATOMIC_RELAXED);
+
+    __atomic_store_n (&BenchAllocCount, 0, __ATOMIC_RELAXED);
+    __atomic_store_n (&BenchAllocTotal, 0, __ATOMIC_RELAXED);
+    __atomic_store_n (&BenchAllocPeak,  cur, __ATOMIC_RELAXED);
+    return cur;
+}
+
+//------------------------------------------------------------------------------
+#endif  // __BENCH_ALLOC_H__
+//------------------------------------------------------------------------------
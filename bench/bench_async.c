@@ -0,0 +1,189 @@
+//------------------------------------------------------------------------------
+/**
+ * @file bench_async.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief 비동기 API (wttr_async_*) 측정, 하나의 thread/epoll loop 에서 동시 요청.
+ * @version 2.0
+ * @date 2025-05-14
+ *
+ * bench/wttr_stub 을 먼저 실행해야 함. (make bench-run 은 자동으로 실행함)
+ * 한 round 에 count 개의 요청을 한번에 보내고 모두 완료될 때까지의 시간을 측정함.
+ * ns/op = round 시간 / count (bench_e2e 의 순차 요청과 비교)
+ *
+ * usage : bench_async [count] [stub url] (기본값 256, http://127.0.0.1:18080)
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include "lib_weather.h"
+#include "bench.h"
+
+//------------------------------------------------------------------------------
+#define STUB_URL    "http://127.0.0.1:18080"
+#define ROUNDS      5
+#define EVENT_MAX   64
+
+static const char *Locations[] = { "suwon", "sapporo" };
+
+static int      Epoll;
+static uint64_t Deadline;       /* timer 만료 시간 (ns), 0 = 없음 */
+static int      Done, Ok;
+
+//------------------------------------------------------------------------------
+// host event loop (epoll)
+//------------------------------------------------------------------------------
+static void on_socket (int fd, int what, void *userp)
+{
+    struct epoll_event ev;
+
+    (void)userp;
+    if (what == WTTR_POLL_REMOVE) {
+        epoll_ctl (Epoll, EPOLL_CTL_DEL, fd, NULL);
+        return;
+    }
+    memset (&ev, 0, sizeof(ev));
+    ev.events  = ((what & WTTR_POLL_IN) ? EPOLLIN : 0) | ((what & WTTR_POLL_OUT) ? EPOLLOUT : 0);
+    ev.data.fd = fd;
+    if (epoll_ctl (Epoll, EPOLL_CTL_MOD, fd, &ev))
+        epoll_ctl (Epoll, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void on_timer (long timeout_ms, void *userp)
+{
+    (void)userp;
+    Deadline = (timeout_ms < 0) ? 0 : bench_now_ns () + (uint64_t)timeout_ms * 1000000ULL;
+}
+
+static void loop_run (wttr_async_t *as)
+{
+    struct epoll_event ev [EVENT_MAX];
+
+    while (wttr_async_pending (as)) {
+        uint64_t now = bench_now_ns ();
+        int wait = -1, n;
+
+        if (Deadline)
+            wait = (Deadline <= now) ? 0 : (int)((Deadline - now + 999999) / 1000000);
+
+        n = epoll_wait (Epoll, ev, EVENT_MAX, wait);
+        for (int i = 0; i < n; i++) {
+            int events = ((ev[i].events & EPOLLIN)  ? WTTR_POLL_IN  : 0) |
+                         ((ev[i].events & EPOLLOUT) ? WTTR_POLL_OUT : 0) |
+                         ((ev[i].events & (EPOLLERR | EPOLLHUP)) ? WTTR_POLL_ERR : 0);
+
+            wttr_async_action (as, ev[i].data.fd, events);
+        }
+        if (Deadline && Deadline <= bench_now_ns ()) {
+            Deadline = 0;
+            wttr_async_action (as, WTTR_ASYNC_TIMEOUT, 0);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+static void on_weather (wttr_ctx_t *ctx, const char *location, int result, void *userp)
+{
+    (void)ctx; (void)location; (void)userp;
+    Done++;
+    if (result) Ok++;
+}
+
+static void on_location (double lat, double lon, const char *city, const char *country,
+                         int ok, void *userp)
+{
+    (void)lat; (void)lon; (void)country; (void)userp;
+    Done++;
+    if (ok && city[0]) Ok++;
+}
+
+//------------------------------------------------------------------------------
+// type = 0 : 날씨 업데이트, 1 : 위치 요청 (매번 cache 에 없는 좌표)
+//------------------------------------------------------------------------------
+static void bench_async (const char *name, wttr_async_t *as, wttr_ctx_t **ctx, int type,
+                         int cnt, uint64_t *samples)
+{
+    char label[128];
+    int ok = 0;
+
+    for (int r = 0; r < ROUNDS; r++) {
+        uint64_t start = bench_now_ns ();
+
+        Done = Ok = 0;
+        for (int i = 0; i < cnt; i++) {
+            if (type == 0)
+                wttr_async_update (as, ctx[i], Locations[i % 2], on_weather, NULL);
+            else
+                wttr_async_location (as, 37.266 + i * 0.02, 127.048 + r * 0.5, 1,
+                                     on_location, NULL);
+        }
+        loop_run (as);
+        samples[r] = bench_now_ns () - start;
+        ok += Ok;
+    }
+    snprintf (label, sizeof(label), "%s/%d", name, cnt);
+    bench_report_ex (label, samples, ROUNDS, cnt, -1, -1);
+    if (ok != cnt * ROUNDS)
+        printf ("# %s : %d/%d failed\n", label, cnt * ROUNDS - ok, cnt * ROUNDS);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+    int cnt = (argc > 1) ? atoi (argv[1]) : 256;
+    const char *url = (argc > 2) ? argv[2] : STUB_URL;
+    uint64_t samples [ROUNDS];
+    wttr_ctx_t **ctx;
+    wttr_async_t *as;
+
+    if (cnt <= 0 || !(ctx = calloc (cnt, sizeof(wttr_ctx_t *))))
+        return 1;
+
+    wttr_set_endpoint (eWTTR_EP_WEATHER,  url);
+    wttr_set_endpoint (eWTTR_EP_LOCATION, url);
+    /* local stub 이므로 nominatim 요청 제한(초당 1회)을 사용하지 않음 */
+    wttr_rate_config  (eWTTR_EP_LOCATION, 0, 1, 0);
+
+    if ((Epoll = epoll_create1 (0)) < 0 || !(as = wttr_async_create (on_socket, on_timer, NULL))) {
+        fprintf (stderr, "epoll/async create error\n");
+        return 1;
+    }
+    for (int i = 0; i < cnt; i++)
+        if (!(ctx[i] = wttr_ctx_create ()))
+            return 1;
+
+    /* 연결이 되는지 먼저 확인 */
+    Done = Ok = 0;
+    wttr_async_update (as, ctx[0], Locations[0], on_weather, NULL);
+    loop_run (as);
+    if (!Ok) {
+        fprintf (stderr, "%s : stub server is not running (make stub; ./bench/wttr_stub &)\n", url);
+        return 1;
+    }
+    printf ("# endpoint %s\n", url);
+
+    wttr_set_parse_mode (eWTTR_PARSE_CJSON);
+    bench_async ("Async/UpdateWeatherData/cjson",  as, ctx, 0, cnt, samples);
+    wttr_set_parse_mode (eWTTR_PARSE_STREAM);
+    bench_async ("Async/UpdateWeatherData/stream", as, ctx, 0, cnt, samples);
+    wttr_set_parse_mode (eWTTR_PARSE_CJSON);
+    bench_async ("Async/GetLocationJson/ko/miss",  as, ctx, 1, cnt, samples);
+
+    wttr_async_destroy (as);
+    for (int i = 0; i < cnt; i++)
+        wttr_ctx_destroy (ctx[i]);
+    free (ctx);
+    close (Epoll);
+    wttr_http_cleanup ();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
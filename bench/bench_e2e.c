@@ -0,0 +1,197 @@
+//------------------------------------------------------------------------------
+/**
+ * @file bench_e2e.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief update_weather_data / get_location_json / wttr_geo_batch 전체 경로 측정 (local stub 서버 사용).
+ * @version 2.0
+ * @date 2025-05-14
+ *
+ * bench/wttr_stub 을 먼저 실행해야 함. (make bench-run 은 자동으로 실행함)
+ * 응답 cache, 위치 cache 를 사용하지 않는 경우와 사용하는 경우를 각각 측정함.
+ * unchanged = 같은 지역을 반복 요청 (응답 hash 가 같으므로 파싱 생략,
+ *             stub 을 -t 로 실행하면 304 응답)
+ * open-meteo = 주 provider 를 WttrProviderOpenMeteo 로 바꾸어 요청 (provider base URL 확인)
+ *
+ * usage : bench_e2e [count] [stub url] (기본값 http://127.0.0.1:18080)
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lib_weather.h"
+#include "bench.h"
+#include "bench_alloc.h"
+
+//------------------------------------------------------------------------------
+#define STUB_URL    "http://127.0.0.1:18080"
+
+static const char *Locations[] = { "suwon", "sapporo" };
+
+//------------------------------------------------------------------------------
+static void bench_update (const char *name, int nloc, int cnt, uint64_t *samples)
+{
+    size_t allocs = 0, bytes = 0, n = 0;
+
+    for (int i = 0; i < cnt; i++) {
+        uint64_t start;
+        int ok;
+
+        bench_alloc_reset ();
+        start = bench_now_ns ();
+        ok = update_weather_data (Locations[i % nloc]);
+        if (ok) {
+            samples[n++] = bench_now_ns () - start;
+            allocs += BenchAllocCount;
+            bytes  += BenchAllocTotal;
+        }
+    }
+    bench_report_ex (name, samples, n, 1,
+                     n ? (double)bytes / n : 0, n ? (double)allocs / n : 0);
+    if (n != (size_t)cnt)
+        printf ("# %s : %zu/%d failed\n", name, cnt - n, cnt);
+}
+
+//------------------------------------------------------------------------------
+// 주 provider 를 open-meteo 로 바꾸어 요청 ("위도,경도" 지역만 지원)
+// 날씨 endpoint 는 기본값(wttr.in)으로 되돌리고 provider 의 base 를 stub 으로 설정하므로
+// provider 의 base 로 요청하지 않으면 실패함.
+//------------------------------------------------------------------------------
+static void bench_openmeteo (const char *name, const char *url, int cnt, uint64_t *samples)
+{
+    wttr_provider_t om = WttrProviderOpenMeteo;
+    size_t n = 0;
+
+    om.base = url;
+    wttr_set_endpoint (eWTTR_EP_WEATHER, NULL);
+    wttr_set_provider (eWTTR_EP_WEATHER, &om);
+
+    if (!update_weather_data ("37.2636,127.0286"))
+        printf ("# %s : request error (provider base %s)\n", name, url);
+    else {
+        for (int i = 0; i < cnt; i++) {
+            uint64_t start = bench_now_ns ();
+
+            if (update_weather_data ("37.2636,127.0286"))
+                samples[n++] = bench_now_ns () - start;
+        }
+        bench_report (name, samples, n);
+        if (n != (size_t)cnt)
+            printf ("# %s : %zu/%d failed\n", name, cnt - n, cnt);
+    }
+
+    wttr_set_provider (eWTTR_EP_WEATHER, NULL);
+    wttr_set_endpoint (eWTTR_EP_WEATHER, url);
+}
+
+//------------------------------------------------------------------------------
+// miss = 1 이면 위치 cache 에 없는 좌표(grid 보다 크게 이동)로 요청
+//------------------------------------------------------------------------------
+static void bench_location (const char *name, int cnt, int is_kor, int miss, uint64_t *samples)
+{
+    char city[256], country[256];
+    size_t allocs = 0, bytes = 0, n = 0;
+
+    for (int i = 0; i < cnt; i++) {
+        double lat = 37.266 + (miss ? i * 0.05 : 0), lon = 127.048;
+        uint64_t start;
+
+        city[0] = '\0';
+        bench_alloc_reset ();
+        start = bench_now_ns ();
+        get_location_json (lat, lon, city, country, is_kor);
+        if (city[0]) {
+            samples[n++] = bench_now_ns () - start;
+            allocs += BenchAllocCount;
+            bytes  += BenchAllocTotal;
+        }
+    }
+    bench_report_ex (name, samples, n, 1,
+                     n ? (double)bytes / n : 0, n ? (double)allocs / n : 0);
+    if (n != (size_t)cnt)
+        printf ("# %s : %zu/%d failed\n", name, cnt - n, cnt);
+}
+
+//------------------------------------------------------------------------------
+// 여러 좌표 위치 요청 (wttr_geo_batch), 8 곳 주변(약 300m 안)의 점 GEO_BATCH 개
+// 매번 위치 cache 를 비우므로 8 번만 요청하고 나머지는 공간 index 에서 찾음 (ns/op = 점 1개)
+//------------------------------------------------------------------------------
+#define GEO_BATCH   256
+
+static void bench_geo_batch (const char *name, int cnt, uint64_t *samples)
+{
+    wttr_geo_point_t *pt = calloc (GEO_BATCH, sizeof(wttr_geo_point_t));
+    size_t n = 0;
+
+    for (int i = 0; pt && i < GEO_BATCH; i++) {
+        pt[i].lat = 37.266 + (i % 8) * 0.1 + (i % 7) * 0.0004;
+        pt[i].lon = 127.048 + (i % 8) * 0.1 + (i % 5) * 0.0005;
+    }
+    for (int i = 0; pt && i < cnt; i++) {
+        uint64_t start;
+
+        wttr_geo_cache_config (0, NULL);
+        start = bench_now_ns ();
+        if (wttr_geo_batch (pt, GEO_BATCH, 1, 0) == GEO_BATCH)
+            samples[n++] = bench_now_ns () - start;
+    }
+    bench_report_ex (name, samples, n, GEO_BATCH, -1, -1);
+    if (n != (size_t)cnt)
+        printf ("# %s : %zu/%d failed\n", name, cnt - n, cnt);
+    free (pt);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+    int cnt = (argc > 1) ? atoi (argv[1]) : 200;
+    const char *url = (argc > 2) ? argv[2] : STUB_URL;
+    uint64_t *samples;
+
+    if (cnt <= 0 || !(samples = malloc (sizeof(uint64_t) * cnt)))
+        return 1;
+
+    wttr_set_endpoint (eWTTR_EP_WEATHER,  url);
+    wttr_set_endpoint (eWTTR_EP_LOCATION, url);
+    /* local stub 이므로 nominatim 요청 제한(초당 1회)을 사용하지 않음 */
+    wttr_rate_config  (eWTTR_EP_LOCATION, 0, 1, 0);
+
+    /* 연결이 되는지 먼저 확인 */
+    if (!update_weather_data (Locations[0])) {
+        fprintf (stderr, "%s : stub server is not running (make stub; ./bench/wttr_stub &)\n", url);
+        free (samples);
+        return 1;
+    }
+    printf ("# endpoint %s\n", url);
+
+    wttr_set_parse_mode (eWTTR_PARSE_CJSON);
+    bench_update ("UpdateWeatherData/cjson",            2, cnt, samples);
+    bench_update ("UpdateWeatherData/cjson/unchanged",  1, cnt, samples);
+    wttr_set_parse_mode (eWTTR_PARSE_STREAM);
+    bench_update ("UpdateWeatherData/stream",           2, cnt, samples);
+    bench_update ("UpdateWeatherData/stream/unchanged", 1, cnt, samples);
+
+    /* 응답 cache (TTL 안의 요청은 네트워크를 사용하지 않음) */
+    wttr_cache_config (60, 0);
+    bench_update ("UpdateWeatherData/cached",           2, cnt, samples);
+    wttr_cache_config (0, 0);
+    wttr_set_parse_mode (eWTTR_PARSE_CJSON);
+
+    bench_openmeteo ("UpdateWeatherData/open-meteo",    url, cnt, samples);
+
+    bench_location ("GetLocationJson/ko/miss",  cnt, 1, 1, samples);
+    bench_location ("GetLocationJson/en/miss",  cnt, 0, 1, samples);
+    bench_location ("GetLocationJson/ko/hit",   cnt, 1, 0, samples);
+    bench_geo_batch ("GeoBatch/ko/clustered",   cnt, samples);
+
+    wttr_http_cleanup ();
+    free (samples);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
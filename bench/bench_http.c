@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------
+/**
+ * @file bench_http.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief HTTP 요청 지연시간 비교 (cold cache / warm cache).
+ * @version 2.0
+ * @date 2025-05-14
+ *
+ * cold : 매 요청마다 handle pool, DNS/TLS/connection cache 를 해제
+ * warm : pool 및 공유 cache 를 재사용 (keep-alive)
+ *
+ * usage : bench_http [count] [location]
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lib_weather.h"
+#include "bench.h"
+
+//------------------------------------------------------------------------------
+static size_t run_weather (const char *location, int cnt, int cold, uint64_t *samples)
+{
+    size_t n = 0;
+
+    for (int i = 0; i < cnt; i++) {
+        uint64_t start;
+        char *json;
+
+        if (cold)   wttr_http_cleanup ();
+
+        start = bench_now_ns ();
+        json  = get_weather_json (location);
+        if (json) {
+            samples[n++] = bench_now_ns () - start;
+            free (json);
+        }
+    }
+    return n;
+}
+
+//------------------------------------------------------------------------------
+static size_t run_location (double lat, double lon, int cnt, int cold, uint64_t *samples)
+{
+    char city[256], country[256];
+    size_t n = 0;
+
+    for (int i = 0; i < cnt; i++) {
+        uint64_t start;
+
+        if (cold)   wttr_http_cleanup ();
+        /* 요청 제한(초당 1회) token 대기는 측정하지 않음 */
+        sleep (1);
+
+        city[0] = 0;
+        start = bench_now_ns ();
+        get_location_json (lat, lon, city, country, 0);
+        if (city[0])
+            samples[n++] = bench_now_ns () - start;
+    }
+    return n;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+    int cnt = (argc > 1) ? atoi (argv[1]) : 10;
+    const char *location = (argc > 2) ? argv[2] : "Seoul";
+    uint64_t *samples;
+    size_t n;
+
+    if (cnt <= 0 || !(samples = malloc (sizeof(uint64_t) * cnt)))
+        return 1;
+
+    n = run_weather (location, cnt, 1, samples);
+    bench_report ("Http/wttr/cold", samples, n);
+
+    /* 첫 요청으로 cache 를 채운 뒤 측정 */
+    wttr_http_cleanup ();
+    free (get_weather_json (location));
+    n = run_weather (location, cnt, 0, samples);
+    bench_report ("Http/wttr/warm", samples, n);
+
+    /* nominatim 정책 (1 req/sec) 을 고려하여 횟수를 제한 */
+    cnt = (cnt > 5) ? 5 : cnt;
+
+    /* 위치 cache 를 사용하면 두번째 요청부터 network 를 사용하지 않으므로 끔 */
+    wttr_geo_cache_config (-1, NULL);
+
+    n = run_location (37.5665, 126.9780, cnt, 1, samples);
+    bench_report ("Http/nominatim/cold", samples, n);
+
+    wttr_http_cleanup ();
+    n = run_location (37.5665, 126.9780, 1, 0, samples);
+    n = run_location (37.5665, 126.9780, cnt, 0, samples);
+    bench_report ("Http/nominatim/warm", samples, n);
+
+    wttr_http_cleanup ();
+    free (samples);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+/**
+ * @file bench_kor.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief 숫자 → 한글 변환 비교 (이전 int_to_kor_buf / wttr_int_to_kor).
+ * @version 2.0
+ * @date 2025-05-14
+ *
+ * 이전 구현은 만 자리까지만 처리하므로 0 ~ 99999 범위에서 비교하고
+ * 새 구현은 음수(기온) 범위와 int 전체 범위도 측정함.
+ *
+ * usage : bench_kor [count]
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "lib_weather.h"
+#include "bench.h"
+
+//------------------------------------------------------------------------------
+// 이전 int_to_kor_buf (비교용 복사본)
+//------------------------------------------------------------------------------
+static void legacy_int_to_kor_buf (int num, char* output) {
+    const char *digits[] = { "영", "일", "이", "삼", "사", "오", "육", "칠", "팔", "구" };
+    char buffer[64] = "", temp[8];
+    int digit, pos;
+
+    sprintf(buffer, "%d", num);
+    if (output) memset (output, 0, WTTR_DATA_SIZE);
+
+    if (!num)   {
+        sprintf (output, "%s", digits[0]);
+        return;
+    }
+
+    for (size_t i = 0, place = strlen(buffer); i < strlen(buffer); i++, place--) {
+        digit = buffer[i] - '0';
+        temp[0] = '\0';
+
+        if (digit) {
+            pos = (digit == 1) ? 0 : sprintf(temp, "%s", digits[digit]);
+            switch (place) {
+                case 5: sprintf(&temp[pos], "%s", "만");  break;
+                case 4: sprintf(&temp[pos], "%s", "천");  break;
+                case 3: sprintf(&temp[pos], "%s", "백");  break;
+                case 2: sprintf(&temp[pos], "%s", "십");  break;
+            }
+            strcat(output, temp);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+static volatile char Sink;
+
+static void run_legacy (const char *name, const int *val, int cnt, int loop, uint64_t *samples)
+{
+    char buf [WTTR_DATA_SIZE];
+
+    for (int l = 0; l < loop; l++) {
+        uint64_t start = bench_now_ns ();
+
+        for (int i = 0; i < cnt; i++) {
+            legacy_int_to_kor_buf (val[i], buf);
+            Sink = buf[0];
+        }
+        samples[l] = bench_now_ns () - start;
+    }
+    bench_report_ex (name, samples, loop, cnt, -1, -1);
+}
+
+static void run_new (const char *name, const int *val, int cnt, int loop, uint64_t *samples)
+{
+    char buf [WTTR_KOR_NUM_SIZE];
+
+    for (int l = 0; l < loop; l++) {
+        uint64_t start = bench_now_ns ();
+
+        for (int i = 0; i < cnt; i++) {
+            wttr_int_to_kor (val[i], buf, sizeof(buf));
+            Sink = buf[0];
+        }
+        samples[l] = bench_now_ns () - start;
+    }
+    bench_report_ex (name, samples, loop, cnt, -1, -1);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+    int loop = (argc > 1) ? atoi (argv[1]) : 20;
+    int *val = malloc (sizeof(int) * 100000);
+    uint64_t *samples = malloc (sizeof(uint64_t) * (loop > 0 ? loop : 1));
+
+    if (loop <= 0 || !val || !samples)
+        return 1;
+
+    /* 0 ~ 99999 */
+    for (int i = 0; i < 100000; i++)
+        val[i] = i;
+    run_legacy ("Kor/legacy/0-99999",     val, 100000, loop, samples);
+    run_new    ("Kor/table/0-99999",      val, 100000, loop, samples);
+
+    /* 기온 범위 -40 ~ 45 (이전 구현은 음수 처리 불가) */
+    for (int i = 0; i < 100000; i++)
+        val[i] = i % 86 - 40;
+    run_new    ("Kor/table/temp",         val, 100000, loop, samples);
+
+    /* int 전체 범위 */
+    srand (1);
+    for (int i = 0; i < 100000; i++)
+        val[i] = (int)((unsigned int)rand () * 2u + (unsigned int)(rand () & 1));
+    run_new    ("Kor/table/int",          val, 100000, loop, samples);
+
+    free (samples);
+    free (val);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,234 @@
+//------------------------------------------------------------------------------
+/**
+ * @file bench_micro.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief 라이브러리 함수 microbenchmark (저장된 응답 corpus 사용).
+ * @version 2.0
+ * @date 2025-05-14
+ *
+ * 응답 파싱, 날씨코드/풍향 변환, 숫자/날짜 한글 변환, url_encode, 지역 registry 조회를 측정함.
+ * 변환 함수의 입력값은 corpus 파일(bench/data/j1_*.json)에서 추출함.
+ * 결과는 bench.h 의 Go benchmark 형식으로 출력됨.
+ *
+ * usage : bench_micro [count] [j1 file ...]
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lib_weather.h"
+#include "bench.h"
+#include "bench_alloc.h"
+
+//------------------------------------------------------------------------------
+#define CORPUS_MAX      4096
+#define BATCH           1000        /* 짧은 함수는 BATCH 번 실행시간을 한 sample 로 기록 */
+
+typedef struct corpus__t {
+    const char  *str [CORPUS_MAX];  /* corpus 문자열 (json buffer 안을 가리킴, '\0' 로 끝남) */
+    int         cnt;
+}   corpus_t;
+
+static corpus_t Codes, Winds, Temps;
+static volatile size_t Sink;
+
+//------------------------------------------------------------------------------
+// json 안의 "key": "value" 값을 모두 corpus 에 추가 (json buffer 를 수정함)
+// 값을 '\0' 로 끝내기 위해 닫는 따옴표를 지우므로 parse 용 복사본과 따로 사용함.
+//------------------------------------------------------------------------------
+static void corpus_add (corpus_t *c, char *json, size_t len, const char *key)
+{
+    size_t klen = strlen (key);
+    char *p = json, *q, *end = json + len;
+
+    /* 앞에서 추가한 값의 끝이 '\0' 이므로 strstr 대신 memmem 사용 */
+    while (c->cnt < CORPUS_MAX && (p = memmem (p, end - p, key, klen)) != NULL) {
+        p += klen;
+        if ((p = memchr (p, ':', end - p)) == NULL || (p = memchr (p, '"', end - p)) == NULL)
+            break;
+        p++;
+        if ((q = memchr (p, '"', end - p)) == NULL)
+            break;
+        *q = '\0';
+        c->str[c->cnt++] = p;
+        p = q + 1;
+    }
+}
+
+//------------------------------------------------------------------------------
+// 응답 파싱 (sample = 1회)
+//------------------------------------------------------------------------------
+static void bench_parse (const char *name, const char *json, size_t len,
+                         enum eWttrParse mode, int cnt, uint64_t *samples)
+{
+    wttr_ctx_t *ctx = wttr_ctx_create ();
+    size_t allocs = 0, bytes = 0;
+    char label[128];
+
+    for (int i = 0; i < cnt; i++) {
+        uint64_t start;
+
+        bench_alloc_reset ();
+        start = bench_now_ns ();
+        wttr_ctx_parse (ctx, json, len, mode);
+        samples[i] = bench_now_ns () - start;
+        allocs += BenchAllocCount;
+        bytes  += BenchAllocTotal;
+    }
+    snprintf (label, sizeof(label), "ParseWeather/%s/%s", name,
+              mode == eWTTR_PARSE_CJSON ? "cjson" : "stream");
+    bench_report_ex (label, samples, cnt, 1, (double)bytes / cnt, (double)allocs / cnt);
+    wttr_ctx_destroy (ctx);
+}
+
+//------------------------------------------------------------------------------
+// 짧은 함수 측정 (sample = corpus 를 돌며 BATCH 번 실행)
+//------------------------------------------------------------------------------
+enum {
+    eOP_WEATHER_CODE,
+    eOP_WIND_DEGREE,
+    eOP_INT_TO_KOR,
+    eOP_DATE_TO_KOR,
+    eOP_DATE_STR,
+    eOP_URL_ENCODE,
+    eOP_LOC_INTERN,
+};
+
+static const char *Locations[] = {
+    "수원시", "서울특별시 강남구", "Sapporo", "New York", "37.266,127.048", "",
+};
+
+static size_t op_run (int op, int i, int is_kor)
+{
+    char buf [WTTR_DATE_STR_SIZE];
+    struct tm t;
+    size_t ret = 0;
+
+    switch (op) {
+        case eOP_WEATHER_CODE:
+            return (size_t)translate_weather_code (Codes.str[i % Codes.cnt], is_kor);
+        case eOP_WIND_DEGREE:
+            return (size_t)translate_wind_degree (Winds.str[i % Winds.cnt], is_kor);
+        case eOP_INT_TO_KOR:
+            int_to_kor_buf (atoi (Temps.str[i % Temps.cnt]), buf);
+            return buf[0];
+        case eOP_DATE_TO_KOR:
+        case eOP_DATE_STR:
+            /* 1년 동안의 시간 (시간 단위) */
+            memset (&t, 0, sizeof(t));
+            t.tm_year = 125;
+            t.tm_mon  = (i / 720) % 12;
+            t.tm_mday = (i / 24) % 28 + 1;
+            t.tm_wday = (i / 24) % 7;
+            t.tm_hour = i % 24;
+            t.tm_min  = i % 60;
+            if (op == eOP_DATE_STR)
+                return wttr_date_str (&t, is_kor ? eWTTR_LANG_KO : eWTTR_LANG_EN, buf, sizeof(buf));
+            /* 이전 방식 : 항목별로 7번 호출 */
+            for (int d = eDAY_MIN; d < eDAY_END; d++) {
+                date_to_kor_buf (d, &t, buf);
+                ret += buf[0];
+            }
+            date_to_kor_buf (eDAY_AM_PM, &t, buf);
+            return ret + buf[0];
+        case eOP_URL_ENCODE: {
+            char *enc = url_encode (Locations[i % (sizeof(Locations) / sizeof(Locations[0]))]);
+            ret = enc ? (size_t)enc[0] : 0;
+            free (enc);
+            return ret;
+        }
+        case eOP_LOC_INTERN:
+            /* 이미 등록된 지역 : 정규화 + hash 조회 (인코딩/할당 없음) */
+            return (size_t)wttr_loc_intern (Locations[i % (sizeof(Locations) / sizeof(Locations[0]))]);
+    }
+    return 0;
+}
+
+static void bench_op (const char *name, int op, int is_kor, int cnt, uint64_t *samples)
+{
+    size_t allocs = 0, bytes = 0;
+
+    for (int s = 0; s < cnt; s++) {
+        uint64_t start;
+
+        bench_alloc_reset ();
+        start = bench_now_ns ();
+        for (int i = 0; i < BATCH; i++)
+            Sink += op_run (op, s * BATCH + i, is_kor);
+        samples[s] = bench_now_ns () - start;
+        allocs += BenchAllocCount;
+        bytes  += BenchAllocTotal;
+    }
+    bench_report_ex (name, samples, cnt, BATCH,
+                     (double)bytes / ((double)cnt * BATCH), (double)allocs / ((double)cnt * BATCH));
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+    const char *def_files[] = { "bench/data/j1_suwon.json", "bench/data/j1_sapporo.json" };
+    const char **files = def_files;
+    int nfiles = sizeof(def_files) / sizeof(def_files[0]);
+    int cnt = (argc > 1) ? atoi (argv[1]) : 200;
+    uint64_t *samples;
+
+    if (argc > 2) {
+        files  = (const char **)&argv[2];
+        nfiles = argc - 2;
+    }
+    if (cnt <= 0 || !(samples = malloc (sizeof(uint64_t) * cnt)))
+        return 1;
+
+    for (int f = 0; f < nfiles; f++) {
+        const char *name = strrchr (files[f], '/') ? strrchr (files[f], '/') + 1 : files[f];
+        size_t len = 0, clen = 0;
+        char *json = bench_load_file (files[f], &len);
+        /* corpus 추출용 복사본 (프로그램 종료까지 유지) */
+        char *corpus = bench_load_file (files[f], &clen);
+
+        if (!json || !corpus) {
+            fprintf (stderr, "%s : file open error\n", files[f]);
+            free (json);
+            free (corpus);
+            continue;
+        }
+        printf ("# %s (%zu bytes)\n", files[f], len);
+        bench_parse (name, json, len, eWTTR_PARSE_CJSON,  cnt, samples);
+        bench_parse (name, json, len, eWTTR_PARSE_STREAM, cnt, samples);
+        free (json);
+
+        corpus_add (&Codes, corpus, clen, "\"weatherCode\"");
+        corpus_add (&Winds, corpus, clen, "\"winddirDegree\"");
+        corpus_add (&Temps, corpus, clen, "\"tempC\"");
+        corpus_add (&Temps, corpus, clen, "\"FeelsLikeC\"");
+    }
+
+    if (!Codes.cnt || !Winds.cnt || !Temps.cnt) {
+        fprintf (stderr, "corpus is empty\n");
+        return 1;
+    }
+    printf ("# corpus : %d weather codes, %d wind degrees, %d temperatures\n",
+        Codes.cnt, Winds.cnt, Temps.cnt);
+
+    bench_op ("TranslateWeatherCode/ko",    eOP_WEATHER_CODE, 1, cnt, samples);
+    bench_op ("TranslateWeatherCode/en",    eOP_WEATHER_CODE, 0, cnt, samples);
+    bench_op ("TranslateWindDegree/ko",     eOP_WIND_DEGREE,  1, cnt, samples);
+    bench_op ("TranslateWindDegree/en",     eOP_WIND_DEGREE,  0, cnt, samples);
+    bench_op ("IntToKorBuf",                eOP_INT_TO_KOR,   1, cnt, samples);
+    bench_op ("DateToKorBuf/7fields",       eOP_DATE_TO_KOR,  1, cnt, samples);
+    bench_op ("DateStr/ko",                 eOP_DATE_STR,     1, cnt, samples);
+    bench_op ("DateStr/en",                 eOP_DATE_STR,     0, cnt, samples);
+    bench_op ("UrlEncode",                  eOP_URL_ENCODE,   1, cnt, samples);
+    bench_op ("LocIntern",                  eOP_LOC_INTERN,   1, cnt, samples);
+
+    free (samples);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
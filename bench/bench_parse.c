@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------------
+/**
+ * @file bench_parse.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief j1 응답 파싱 비교 (cJSON tree / streaming 추출).
+ * @version 2.0
+ * @date 2025-05-14
+ *
+ * 파싱 시간과 최대 heap 사용량을 측정함.
+ * cJSON 방식은 cURL 수신 buffer(응답 전체)도 heap 사용량에 포함함.
+ *
+ * usage : bench_parse [count] [j1 file ...] (기본값 bench/data/j1_*.json)
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lib_weather.h"
+#include "bench.h"
+#include "bench_alloc.h"
+
+//------------------------------------------------------------------------------
+static void run (const char *name, wttr_ctx_t *ctx, const char *json, size_t len,
+                 enum eWttrParse mode, int cnt, uint64_t *samples)
+{
+    size_t base, peak = 0, allocs = 0, bytes = 0;
+    char label[64];
+
+    for (int i = 0; i < cnt; i++) {
+        uint64_t start;
+        char *buf = NULL;
+
+        base  = bench_alloc_reset ();
+        start = bench_now_ns ();
+
+        if (mode == eWTTR_PARSE_CJSON) {
+            /* cURL 수신 buffer 와 동일하게 응답 전체를 heap 에 복사 */
+            if ((buf = malloc (len + 1)) != NULL) {
+                memcpy (buf, json, len + 1);
+                wttr_ctx_parse (ctx, buf, len, mode);
+                free (buf);
+            }
+        } else {
+            wttr_ctx_parse (ctx, json, len, mode);
+        }
+        samples[i] = bench_now_ns () - start;
+
+        if (BenchAllocPeak - base > peak)   peak = BenchAllocPeak - base;
+        allocs += BenchAllocCount;
+        bytes  += BenchAllocTotal;
+    }
+    snprintf (label, sizeof(label), "Parse/%s/%s", name, mode == eWTTR_PARSE_CJSON ? "cjson" : "stream");
+    bench_report_ex (label, samples, cnt, 1, (double)bytes / cnt, (double)allocs / cnt);
+    printf ("# %s peak heap=%zu bytes\n", label, peak);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+    const char *def_files[] = { "bench/data/j1_suwon.json", "bench/data/j1_sapporo.json" };
+    const char **files = def_files;
+    int nfiles = sizeof(def_files) / sizeof(def_files[0]);
+    int cnt = (argc > 1) ? atoi (argv[1]) : 2000;
+    wttr_ctx_t *ctx = wttr_ctx_create ();
+    uint64_t *samples;
+
+    if (argc > 2) {
+        files  = (const char **)&argv[2];
+        nfiles = argc - 2;
+    }
+    if (cnt <= 0 || !ctx || !(samples = malloc (sizeof(uint64_t) * cnt)))
+        return 1;
+
+    for (int f = 0; f < nfiles; f++) {
+        const char *name = strrchr (files[f], '/') ? strrchr (files[f], '/') + 1 : files[f];
+        size_t len = 0;
+        char *json = bench_load_file (files[f], &len);
+
+        if (!json) {
+            fprintf (stderr, "%s : file open error\n", files[f]);
+            continue;
+        }
+        printf ("# %s (%zu bytes)\n", files[f], len);
+        run (name, ctx, json, len, eWTTR_PARSE_CJSON,  cnt, samples);
+        run (name, ctx, json, len, eWTTR_PARSE_STREAM, cnt, samples);
+        free (json);
+    }
+    wttr_ctx_destroy (ctx);
+    free (samples);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,182 @@
+//------------------------------------------------------------------------------
+/**
+ * @file bench_seqlock.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief snapshot 교체중 reader latency 및 torn read 검사 (stress test).
+ * @version 2.0
+ * @date 2025-05-14
+ *
+ * writer thread 는 두 fixture 를 번갈아 파싱하여 snapshot 을 계속 교체하고,
+ * reader thread 들은 getter 를 호출하며 latency 를 측정함.
+ * 읽은 값은 반드시 두 fixture 중 하나의 값과 같아야 함 (다르면 torn read).
+ *
+ * usage : bench_seqlock [seconds] [readers]
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "lib_weather.h"
+#include "bench.h"
+
+//------------------------------------------------------------------------------
+#define READER_MAX      16
+#define SAMPLE_MAX      (1 << 20)
+
+static const char *Files[2] = { "bench/data/j1_suwon.json", "bench/data/j1_sapporo.json" };
+
+static char             *Json   [2];
+static size_t           JsonLen [2];
+static char             Expect  [2][WTTR_DATA_SIZE];    /* eWTTR_AREA_NAME */
+static int              ExpectT [2];                    /* eWTTR_TEMP */
+static wttr_forecast_t  ExpectFc[2];
+
+static wttr_ctx_t       *Ctx;
+static volatile int     Running = 1;
+
+struct reader {
+    pthread_t   tid;
+    uint64_t    *samples;
+    size_t      cnt;
+    size_t      torn;
+};
+
+//------------------------------------------------------------------------------
+static int fc_equal (const wttr_forecast_t *a, const wttr_forecast_t *b)
+{
+    if (a->cnt != b->cnt ||
+        memcmp (a->time, b->time, sizeof(a->time[0]) * a->cnt) ||
+        memcmp (a->code, b->code, sizeof(a->code[0]) * a->cnt))
+        return 0;
+
+    for (int c = 0; c < eWTTR_FC_COL_END; c++)
+        if (memcmp (a->col[c], b->col[c], sizeof(a->col[c][0]) * a->cnt))
+            return 0;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static void *writer_thread (void *arg)
+{
+    unsigned long *swaps = (unsigned long *)arg;
+
+    for (int i = 0; Running; i ^= 1) {
+        wttr_ctx_parse (Ctx, Json[i], JsonLen[i], eWTTR_PARSE_STREAM);
+        (*swaps)++;
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void *reader_thread (void *arg)
+{
+    struct reader *r = (struct reader *)arg;
+    wttr_forecast_t fc;
+
+    while (Running && r->cnt < SAMPLE_MAX) {
+        uint64_t start = bench_now_ns ();
+        const char *area = wttr_ctx_get_data (Ctx, eWTTR_AREA_NAME);
+        int temp = wttr_ctx_get_int (Ctx, eWTTR_TEMP);
+
+        r->samples[r->cnt++] = bench_now_ns () - start;
+
+        if (strcmp (area, Expect[0]) && strcmp (area, Expect[1]))
+            r->torn++;
+        if (temp != ExpectT[0] && temp != ExpectT[1])
+            r->torn++;
+
+        /* 예보 전체(약 2KB)도 한번에 같은 snapshot 에서 복사되어야 함 */
+        if ((r->cnt & 63) == 0) {
+            wttr_ctx_get_forecast (Ctx, &fc);
+            if (!fc_equal (&fc, &ExpectFc[0]) && !fc_equal (&fc, &ExpectFc[1]))
+                r->torn++;
+        }
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+    int sec     = (argc > 1) ? atoi (argv[1]) : 3;
+    int readers = (argc > 2) ? atoi (argv[2]) : 4;
+    struct reader r[READER_MAX];
+    pthread_t writer;
+    unsigned long swaps = 0;
+    uint64_t *all;
+    size_t total = 0, torn = 0;
+
+    if (sec <= 0 || readers <= 0 || readers > READER_MAX)
+        return 1;
+
+    /* fixture 별 기대값 */
+    for (int i = 0; i < 2; i++) {
+        wttr_ctx_t *ctx = wttr_ctx_create ();
+
+        if (!(Json[i] = bench_load_file (Files[i], &JsonLen[i])) || !ctx ||
+            !wttr_ctx_parse (ctx, Json[i], JsonLen[i], eWTTR_PARSE_STREAM)) {
+            fprintf (stderr, "%s : fixture error\n", Files[i]);
+            return 1;
+        }
+        wttr_ctx_get_data_buf (ctx, eWTTR_AREA_NAME, Expect[i], sizeof(Expect[i]));
+        ExpectT[i] = wttr_ctx_get_int (ctx, eWTTR_TEMP);
+        wttr_ctx_get_forecast (ctx, &ExpectFc[i]);
+        wttr_ctx_destroy (ctx);
+    }
+
+    Ctx = wttr_ctx_create ();
+    wttr_ctx_parse (Ctx, Json[0], JsonLen[0], eWTTR_PARSE_STREAM);
+
+    /* writer 없이 reader 1개 기준값 */
+    {
+        uint64_t *s = malloc (sizeof(uint64_t) * 100000);
+
+        for (int i = 0; s && i < 100000; i++) {
+            uint64_t start = bench_now_ns ();
+            wttr_ctx_get_data (Ctx, eWTTR_AREA_NAME);
+            wttr_ctx_get_int  (Ctx, eWTTR_TEMP);
+            s[i] = bench_now_ns () - start;
+        }
+        if (s) bench_report ("Seqlock/idle", s, 100000);
+        free (s);
+    }
+
+    pthread_create (&writer, NULL, writer_thread, &swaps);
+    for (int i = 0; i < readers; i++) {
+        memset (&r[i], 0, sizeof(r[i]));
+        r[i].samples = malloc (sizeof(uint64_t) * SAMPLE_MAX);
+        pthread_create (&r[i].tid, NULL, reader_thread, &r[i]);
+    }
+
+    sleep (sec);
+    Running = 0;
+
+    pthread_join (writer, NULL);
+    all = malloc (sizeof(uint64_t) * SAMPLE_MAX * readers);
+    for (int i = 0; i < readers; i++) {
+        pthread_join (r[i].tid, NULL);
+        memcpy (&all[total], r[i].samples, sizeof(uint64_t) * r[i].cnt);
+        total += r[i].cnt;
+        torn  += r[i].torn;
+        free (r[i].samples);
+    }
+
+    bench_report ("Seqlock/refresh", all, total);
+    printf ("# %lu snapshots published, %zu torn reads\n", swaps, torn);
+
+    free (all);
+    wttr_ctx_destroy (Ctx);
+    free (Json[0]);
+    free (Json[1]);
+    return torn ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,26 @@
+#!/bin/sh
+#
+# lib_weather benchmark 실행 (make bench-run)
+# local stub 서버를 띄우고 모든 benchmark 를 실행함. 결과는 Go benchmark 형식.
+#
+# usage : bench/run.sh [port] > result.txt
+#         benchstat old.txt new.txt (release 간 비교)
+#
+PORT=${1:-18080}
+URL=http://127.0.0.1:$PORT
+DIR=$(dirname "$0")
+
+"$DIR"/wttr_stub -p "$PORT" -q 2>/dev/null &
+STUB=$!
+trap 'kill $STUB 2>/dev/null' EXIT INT TERM
+sleep 0.5
+
+echo "# lib_weather $(git describe --always --dirty 2>/dev/null) $(date '+%Y-%m-%d %H:%M:%S')"
+echo "# $(uname -srm)"
+
+"$DIR"/bench_micro
+"$DIR"/bench_parse
+"$DIR"/bench_kor
+"$DIR"/bench_seqlock 2
+"$DIR"/bench_e2e 200 "$URL"
+"$DIR"/bench_async 256 "$URL"
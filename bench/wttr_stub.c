@@ -0,0 +1,346 @@
+//------------------------------------------------------------------------------
+/**
+ * @file wttr_stub.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief wttr.in / nominatim 대체 local HTTP 서버 (저장된 응답 재생).
+ * @version 2.0
+ * @date 2025-05-14
+ *
+ * 요청 경로에 따라 fixture 파일을 응답함. (HTTP/1.1 keep-alive 지원)
+ *   /reverse?...accept-language=xx  → {dir}/nominatim_xx.json
+ *   /{location}?format=j1 (j2)      → {dir}/j1_{location}.json, 없으면 -j 파일
+ *   /v1/forecast?...                → {dir}/om_suwon.json (open-meteo 형식, 보조 provider)
+ *
+ * 응답 지연(-l, -J)과 오류(-e : HTTP 503, -x : 응답없이 연결 종료)를 지정할 수 있음.
+ * -t 는 ETag(body hash)를 보내고 If-None-Match 가 같으면 304 로 응답함.
+ * 라이브러리는 WTTR_WEATHER_URL, WTTR_LOCATION_URL, WTTR_FALLBACK_URL 환경변수 또는
+ * wttr_set_endpoint() 로 이 서버를 사용함.
+ *
+ * usage : wttr_stub [-p port] [-d dir] [-j j1 file] [-l latency ms] [-J jitter ms]
+ *                   [-e error %] [-x drop %] [-t] [-q]
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+//------------------------------------------------------------------------------
+#define STUB_PORT       18080
+#define STUB_REQ_SIZE   8192
+#define STUB_PATH_SIZE  1024
+
+static const char   *DataDir    = "bench/data";
+static const char   *DefaultJ1  = "bench/data/j1_suwon.json";
+static int          LatencyMs   = 0;
+static int          JitterMs    = 0;
+static int          ErrorPct    = 0;
+static int          DropPct     = 0;
+static int          UseETag     = 0;
+static int          Quiet       = 0;
+
+static unsigned long Served, Errors, Drops, NotModified;
+static pthread_mutex_t StatLock = PTHREAD_MUTEX_INITIALIZER;
+
+//------------------------------------------------------------------------------
+static char *load_file (const char *path, size_t *len)
+{
+    FILE *fp = fopen (path, "rb");
+    char *buf = NULL;
+    long size;
+
+    if (!fp) return NULL;
+
+    if (!fseek (fp, 0, SEEK_END) && (size = ftell (fp)) > 0 && !fseek (fp, 0, SEEK_SET) &&
+        (buf = malloc (size)) != NULL)
+        *len = fread (buf, 1, size, fp);
+    fclose (fp);
+    return buf;
+}
+
+//------------------------------------------------------------------------------
+// %XX decode 및 파일명으로 사용할 수 없는 문자 제거, 소문자 변환
+//------------------------------------------------------------------------------
+static void path_to_name (const char *src, size_t len, char *dst, size_t size)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < len && n + 1 < size; i++) {
+        unsigned int c = (unsigned char)src[i];
+
+        if (c == '%' && i + 2 < len && sscanf (&src[i + 1], "%2x", &c) == 1)
+            i += 2;
+        if (c == '/' || c == '.' || c == '\\' || c < 0x20)
+            continue;
+        dst[n++] = (c < 0x80) ? tolower (c) : c;
+    }
+    dst[n] = '\0';
+}
+
+//------------------------------------------------------------------------------
+// 요청 경로 → fixture 파일
+//------------------------------------------------------------------------------
+static char *route (const char *target, size_t *len)
+{
+    char name[256], path[STUB_PATH_SIZE];
+    const char *q = strchr (target, '?');
+    char *body;
+
+    if (!strncmp (target, "/reverse", 8)) {
+        const char *lang = q ? strstr (q, "accept-language=") : NULL;
+
+        path_to_name (lang ? lang + 16 : "en", lang ? strcspn (lang + 16, "& ") : 2,
+                      name, sizeof(name));
+        snprintf (path, sizeof(path), "%s/nominatim_%s.json", DataDir, name);
+        return load_file (path, len);
+    }
+    if (!strncmp (target, "/v1/forecast", 12)) {
+        snprintf (path, sizeof(path), "%s/om_suwon.json", DataDir);
+        return load_file (path, len);
+    }
+
+    path_to_name (target + 1, q ? (size_t)(q - target - 1) : strlen (target + 1),
+                  name, sizeof(name));
+    snprintf (path, sizeof(path), "%s/j1_%s.json", DataDir, name);
+
+    if (!name[0] || (body = load_file (path, len)) == NULL)
+        body = load_file (DefaultJ1, len);
+    return body;
+}
+
+//------------------------------------------------------------------------------
+static void stub_delay (void)
+{
+    int ms = LatencyMs + (JitterMs ? rand () % (JitterMs + 1) : 0);
+
+    if (ms > 0) {
+        struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+        nanosleep (&ts, NULL);
+    }
+}
+
+static void stat_add (unsigned long *counter)
+{
+    pthread_mutex_lock   (&StatLock);
+    (*counter)++;
+    pthread_mutex_unlock (&StatLock);
+}
+
+//------------------------------------------------------------------------------
+// ETag = body 의 FNV-1a 64bit hash
+//------------------------------------------------------------------------------
+static void make_etag (const char *body, size_t len, char *etag, size_t size)
+{
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)body[i];
+        hash *= 0x100000001b3ULL;
+    }
+    snprintf (etag, size, "\"%016llx\"", hash);
+}
+
+//------------------------------------------------------------------------------
+// 요청 header 의 If-None-Match 가 etag 와 같은지 확인
+//------------------------------------------------------------------------------
+static int etag_match (const char *req, const char *etag)
+{
+    const char *p = strcasestr (req, "\r\nIf-None-Match:");
+
+    if (!p) return 0;
+    for (p += 16; *p == ' '; p++)
+        ;
+    return !strncmp (p, etag, strlen (etag));
+}
+
+static int send_all (int fd, const char *buf, size_t len)
+{
+    while (len) {
+        ssize_t n = send (fd, buf, len, MSG_NOSIGNAL);
+
+        if (n <= 0) return 0;
+        buf += n;
+        len -= n;
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 연결 하나 처리 (keep-alive, 요청 body 는 없다고 가정)
+//------------------------------------------------------------------------------
+static void *conn_thread (void *arg)
+{
+    int fd = (int)(long)arg;
+    char req[STUB_REQ_SIZE], target[STUB_PATH_SIZE], hdr[256], etag[24];
+    size_t have = 0;
+
+    for (;;) {
+        char *end, *body;
+        size_t len = 0;
+        int close_conn, hlen;
+        ssize_t n;
+
+        while ((end = memmem (req, have, "\r\n\r\n", 4)) == NULL) {
+            if (have == sizeof(req) ||
+                (n = recv (fd, req + have, sizeof(req) - have, 0)) <= 0)
+                goto out;
+            have += n;
+        }
+        *end = '\0';
+
+        if (sscanf (req, "%*s %1023s", target) != 1)
+            goto out;
+        close_conn = strcasestr (req, "Connection: close") != NULL;
+
+        stub_delay ();
+
+        if (DropPct && rand () % 100 < DropPct) {
+            stat_add (&Drops);
+            goto out;
+        }
+
+        if (ErrorPct && rand () % 100 < ErrorPct) {
+            static const char msg[] = "service unavailable\n";
+
+            stat_add (&Errors);
+            hlen = snprintf (hdr, sizeof(hdr),
+                "HTTP/1.1 503 Service Unavailable\r\nContent-Type: text/plain\r\n"
+                "Content-Length: %zu\r\n\r\n", sizeof(msg) - 1);
+            if (!send_all (fd, hdr, hlen) || !send_all (fd, msg, sizeof(msg) - 1))
+                goto out;
+        } else if ((body = route (target, &len)) != NULL) {
+            etag[0] = '\0';
+            if (UseETag)
+                make_etag (body, len, etag, sizeof(etag));
+
+            if (etag[0] && etag_match (req, etag)) {
+                stat_add (&NotModified);
+                hlen = snprintf (hdr, sizeof(hdr),
+                    "HTTP/1.1 304 Not Modified\r\nETag: %s\r\n\r\n", etag);
+                n = send_all (fd, hdr, hlen);
+            } else {
+                stat_add (&Served);
+                hlen = snprintf (hdr, sizeof(hdr),
+                    "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                    "%s%s%sContent-Length: %zu\r\n\r\n",
+                    etag[0] ? "ETag: " : "", etag, etag[0] ? "\r\n" : "", len);
+                n = send_all (fd, hdr, hlen) && send_all (fd, body, len);
+            }
+            free (body);
+            if (!n) goto out;
+        } else {
+            static const char msg[] = "not found\n";
+
+            hlen = snprintf (hdr, sizeof(hdr),
+                "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n"
+                "Content-Length: %zu\r\n\r\n", sizeof(msg) - 1);
+            if (!send_all (fd, hdr, hlen) || !send_all (fd, msg, sizeof(msg) - 1))
+                goto out;
+        }
+
+        if (!Quiet)
+            fprintf (stderr, "%s\n", target);
+        if (close_conn)
+            goto out;
+
+        /* pipelining 된 다음 요청 */
+        end += 4;
+        have -= end - req;
+        memmove (req, end, have);
+    }
+out:
+    close (fd);
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void usage (const char *name)
+{
+    fprintf (stderr,
+        "usage : %s [-p port] [-d dir] [-j j1 file] [-l latency ms] [-J jitter ms]\n"
+        "          [-e error %%] [-x drop %%] [-t] [-q]\n", name);
+}
+
+static void on_signal (int sig)
+{
+    (void)sig;
+    fprintf (stderr, "served=%lu not_modified=%lu errors=%lu drops=%lu\n",
+             Served, NotModified, Errors, Drops);
+    _exit (0);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+    struct sockaddr_in addr;
+    pthread_attr_t attr;
+    int port = STUB_PORT, opt, fd, on = 1;
+
+    while ((opt = getopt (argc, argv, "p:d:j:l:J:e:x:tqh")) != -1) {
+        switch (opt) {
+            case 'p':   port      = atoi (optarg);  break;
+            case 'd':   DataDir   = optarg;         break;
+            case 'j':   DefaultJ1 = optarg;         break;
+            case 'l':   LatencyMs = atoi (optarg);  break;
+            case 'J':   JitterMs  = atoi (optarg);  break;
+            case 'e':   ErrorPct  = atoi (optarg);  break;
+            case 'x':   DropPct   = atoi (optarg);  break;
+            case 't':   UseETag   = 1;              break;
+            case 'q':   Quiet     = 1;              break;
+            default :   usage (argv[0]);            return 1;
+        }
+    }
+
+    if ((fd = socket (AF_INET, SOCK_STREAM, 0)) < 0) {
+        perror ("socket");
+        return 1;
+    }
+    setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    memset (&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons (port);
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+    if (bind (fd, (struct sockaddr *)&addr, sizeof(addr)) || listen (fd, 128)) {
+        perror ("bind/listen");
+        return 1;
+    }
+
+    signal (SIGINT,  on_signal);
+    signal (SIGTERM, on_signal);
+    srand (time (NULL));
+
+    fprintf (stderr, "listening on http://127.0.0.1:%d (dir=%s, latency=%d+%dms, error=%d%%, drop=%d%%%s)\n",
+        port, DataDir, LatencyMs, JitterMs, ErrorPct, DropPct, UseETag ? ", etag" : "");
+
+    pthread_attr_init (&attr);
+    pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+
+    for (;;) {
+        pthread_t tid;
+        int cfd = accept (fd, NULL, NULL);
+
+        if (cfd < 0) continue;
+        setsockopt (cfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        if (pthread_create (&tid, &attr, conn_thread, (void *)(long)cfd))
+            close (cfd);
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -15,19 +15,31 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <stdarg.h>
 #include <ctype.h>
 #include <curl/curl.h>
 #include <cjson/cJSON.h>
 #include <locale.h>
 #include <math.h>
 #include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <limits.h>
+#include <signal.h>
 
 //------------------------------------------------------------------------------
 #include "lib_weather.h"
 
-//------------------------------------------------------------------------------
-char KorString [WTTR_DATA_SIZE];
-
 //------------------------------------------------------------------------------
 // wttr.in data 구조
 //------------------------------------------------------------------------------
@@ -38,7 +50,7 @@ const char *SubClass[] = {
     "weather",
 };
 
-/* wttr.in request data struct */
+/* wttr.in request data struct (각 context 의 초기값으로 사용, eWttrItem 순서와 동일해야 함) */
 wttr_data_t WttrData [] = {
     /* SubClass : current_condition */
     { eWTTR_TEMP_FEEL,  &SubClass[0], "FeelsLikeC",      "0" },  /* 체감온도: "FeelsLikeC": "29" */
@@ -55,97 +67,445 @@ wttr_data_t WttrData [] = {
     { eWTTR_WIND_SPEED, &SubClass[0], "windspeedKmph",   "0" },  /* 풍속: "windspeedKmph": "15" */
 
     /* SubClass : nearest_area */
-    { eWTTR_LATITUDE,   &SubClass[1], "latitude",    "0" },  /* 위도: "latitude": "37.266" */
-    { eWTTR_LONGITUDE,  &SubClass[1], "longitude",   "0" },  /* 경도: "longitude": "127.048" */
     { eWTTR_AREA_NAME,  &SubClass[1], "areaName",    "0" },  /* 지역이름: "areaName": [ { "value": "Seryudong" } ] */
     { eWTTR_COUNTRY,    &SubClass[1], "country",     "0" },  /* 국가: "country": [ { "value": "South Korea" } ] */
+    { eWTTR_LATITUDE,   &SubClass[1], "latitude",    "0" },  /* 위도: "latitude": "37.266" */
+    { eWTTR_LONGITUDE,  &SubClass[1], "longitude",   "0" },  /* 경도: "longitude": "127.048" */
 };
 
+#define WTTR_ITEM_CNT   (sizeof (WttrData) / sizeof (WttrData[0]))
+#define WTTR_CC_CNT     (eWTTR_WIND_SPEED - eWTTR_TEMP_FEEL + 1)    /* current_condition 항목 수 */
+
 //------------------------------------------------------------------------------
+// eWttrItem → WttrData index (-1 = 없는 항목)
 //------------------------------------------------------------------------------
-// 풍향 Degree → 한글
+static inline int wttr_item_index (enum eWttrItem id)
+{
+    if (id >= eWTTR_TEMP_FEEL && id <= eWTTR_WIND_SPEED)
+        return id - eWTTR_TEMP_FEEL;
+    if (id >= eWTTR_AREA_NAME && id <= eWTTR_LONGITUDE)
+        return WTTR_CC_CNT + id - eWTTR_AREA_NAME;
+    return -1;
+}
+
 //------------------------------------------------------------------------------
-const char* translate_wind_degree (const char *degree, int is_kor) {
-    const char* directions[] = {
-        "북", "북북동", "북동", "동북동", "동", "동남동", "남동", "남남동",
-        "남", "남남서", "남서", "서남서", "서", "서북서", "북서", "북북서"
-    };
-    const char* directions_en[] = {
+// 지역 snapshot : 문자열 값과 update 시점에 한번 변환된 숫자 값
+//------------------------------------------------------------------------------
+typedef struct wttr_snap__t {
+    wttr_data_t     data [WTTR_ITEM_CNT];
+    int             ival [WTTR_ITEM_CNT];
+    double          fval [WTTR_ITEM_CNT];
+    struct tm       obs_tm;                 /* eWTTR_LOBS_DATE */
+    wttr_forecast_t fc;                     /* weather (시간별 예보) */
+}   wttr_snap_t;
+
+//------------------------------------------------------------------------------
+// 응답 파싱 결과 (cache, batch 에서 사용)
+//------------------------------------------------------------------------------
+typedef struct wttr_result__t {
+    wttr_data_t         data [WTTR_ITEM_CNT];
+    wttr_forecast_t     fc;
+    unsigned long long  hash;       /* 응답 body hash (0 = 알 수 없음) */
+}   wttr_result_t;
+
+/* 응답에 예보가 없음 (j2, streaming 파싱) : 같은 지역의 이전 예보를 유지함 */
+#define FC_NONE     (-1)
+
+static void wttr_result_init (wttr_result_t *res)
+{
+    memcpy (res->data, WttrData, sizeof(res->data));
+    res->fc.cnt = FC_NONE;
+    res->hash   = 0;
+}
+
+//------------------------------------------------------------------------------
+// 조건부 요청 (If-None-Match / If-Modified-Since)
+// 요청시 이전 응답의 validator 를 보내고 응답의 validator 로 갱신됨.
+// 서버가 validator 를 보내지 않으면 body hash 로 변경 여부를 확인함.
+//------------------------------------------------------------------------------
+#define WTTR_VALIDATOR_SIZE 128
+
+typedef struct wttr_cond__t {
+    char                etag     [WTTR_VALIDATOR_SIZE];
+    char                last_mod [WTTR_VALIDATOR_SIZE];
+    unsigned long long  hash;           /* 이전 응답 body hash (0 = 없음) */
+    int                 not_modified;   /* 304 응답 */
+}   wttr_cond_t;
+
+/* FNV-1a 64bit */
+#define PAYLOAD_HASH_INIT   0xcbf29ce484222325ULL
+
+static unsigned long long payload_hash (unsigned long long hash, const void *data, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)data;
+
+    while (len--) {
+        hash ^= *p++;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+// 문자열 복사 (size 를 넘으면 UTF-8 글자 경계에서 자름), 반환값 = 복사한 길이
+//------------------------------------------------------------------------------
+static size_t str_copy (char *dst, size_t size, const char *src)
+{
+    size_t len;
+
+    if (!size)  return 0;
+
+    if ((len = strnlen (src, size)) >= size) {
+        len = size - 1;
+        /* 잘리는 첫 byte 가 글자 중간(10xxxxxx)이면 그 글자 전체를 버림 */
+        while (len && ((unsigned char)src[len] & 0xC0) == 0x80)
+            len--;
+    }
+    memmove (dst, src, len);
+    dst[len] = '\0';
+    return len;
+}
+
+//------------------------------------------------------------------------------
+// 지역별 날씨 context (하나의 지역 snapshot 을 소유)
+//------------------------------------------------------------------------------
+// snap 은 seqlock 으로 게시함 : writer 는 mutex 로 직렬화하고 seq 를 홀수로 만든 뒤 교체,
+// reader 는 lock 없이 복사하고 seq 가 바뀌었으면 다시 읽음 (reader 는 block 되지 않음).
+//------------------------------------------------------------------------------
+struct wttr_ctx__t {
+    pthread_mutex_t mutex;          /* writer 직렬화 */
+    unsigned int    seq;            /* seqlock (홀수 = 교체중) */
+    wttr_snap_t     snap;
+
+    /* snap 을 만든 응답의 validator (mutex 로 보호, cond_loc = 지역 registry handle) */
+    wttr_loc_t      cond_loc;
+    wttr_cond_t     cond;
+
+    /* snapshot 파일 (mutex 로 보호), stale = 파일에서 읽은 뒤 아직 업데이트 안됨 */
+    char            *snap_path;
+    time_t          snap_saved;
+    int             stale;
+
+    /* 파일 쓰기는 mutex 밖에서 save_lock 으로 직렬화, 오래된 내용이 덮어쓰지 않도록
+       snap_gen(mutex 로 보호) 순서로 쓰고 snap_done(save_lock 으로 보호)은 마지막 저장 */
+    pthread_mutex_t save_lock;
+    unsigned int    snap_gen;
+    unsigned int    snap_done;
+
+    /* 공유 메모리 snapshot (daemon), NULL = 사용안함 */
+    struct shm_seg  *shm;
+    int             shm_fd;
+
+    /* background refresher */
+    pthread_mutex_t refresh_lock;
+    pthread_cond_t  refresh_cond;
+    pthread_t       refresh_tid;
+    int             refresh_run;
+    int             refresh_sec;
+    wttr_loc_t      refresh_loc;
+
+    /* wttr_ctx_get_data 반환 buffer (context 별, thread 별), tls_list 는 tls_lock 으로 보호 */
+    pthread_key_t   tls_key;
+    int             tls_ok;
+    pthread_mutex_t tls_lock;
+    struct data_tls *tls_list;
+};
+
+/* context 별 thread buffer, thread 종료 또는 context 삭제시 해제 */
+struct data_tls {
+    wttr_ctx_t      *ctx;
+    struct data_tls *prev, *next;
+    char            data [WTTR_ITEM_CNT][WTTR_DATA_SIZE];
+};
+
+/* context 별 buffer 를 만들 수 없을 때 사용하는 thread 공용 buffer */
+static __thread char    DataTls [WTTR_ITEM_CNT][WTTR_DATA_SIZE];
+
+/* 기존 API(update_weather_data, get_wttr_data)에서 사용하는 process 기본 context */
+static wttr_ctx_t       DefaultCtx;
+static pthread_once_t   DefaultCtxOnce = PTHREAD_ONCE_INIT;
+static pthread_once_t   CurlInitOnce   = PTHREAD_ONCE_INIT;
+
+/* 응답 파싱 방식 (cJSON tree / streaming 추출), 다른 thread 에서 바꿀 수 있으므로 atomic 으로 접근 */
+static enum eWttrParse  ParseMode = eWTTR_PARSE_CJSON;
+
+static inline enum eWttrParse parse_mode_get (void)
+{
+    return __atomic_load_n (&ParseMode, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// 날씨 코드/풍향/자외선 변환 table
+// 날씨 코드는 WeatherCodeIndex[] 로 언어 pack 의 index 를 바로 얻음 (0 = 알 수 없음).
+//------------------------------------------------------------------------------
+static const unsigned char WeatherCodeIndex [WTTR_WCODE_MAX] = {
+    [113] =  1, [116] =  2, [119] =  3, [122] =  4, [143] =  5, [176] =  6,
+    [179] =  7, [182] =  8, [185] =  9, [200] = 10, [227] = 11, [230] = 12,
+    [248] = 13, [260] = 14, [263] = 15, [266] = 16, [281] = 17, [284] = 18,
+    [293] = 19, [296] = 20, [299] = 21, [302] = 22, [305] = 23, [308] = 24,
+    [311] = 25, [314] = 26, [317] = 27, [320] = 28, [323] = 29, [326] = 30,
+    [329] = 31, [332] = 32, [335] = 33, [338] = 34, [350] = 35, [353] = 36,
+    [356] = 37, [359] = 38, [362] = 39, [365] = 40, [368] = 41, [371] = 42,
+    [374] = 43, [377] = 44, [386] = 45, [389] = 46, [392] = 47, [395] = 48,
+};
+
+/* 자외선 지수 → 단계 (11 이상은 마지막 단계) */
+static const unsigned char UvLevel [] = { 0, 0, 0, 1, 1, 1, 2, 2, 3, 3, 3 };
+
+static const wttr_lang_t LangEn = {
+    "en",
+    {
+        "Unknown",
+        /* 113 */ "Clear",
+        /* 116 */ "Partly Cloudy",
+        /* 119 */ "Cloudy",
+        /* 122 */ "Overcast",
+        /* 143 */ "Mist",
+        /* 176 */ "Patchy rain",
+        /* 179 */ "Patchy snow",
+        /* 182 */ "Patchy sleet",
+        /* 185 */ "Patchy freezing drizzle",
+        /* 200 */ "Thundery outbreaks",
+        /* 227 */ "Blowing snow",
+        /* 230 */ "Blizzard",
+        /* 248 */ "Fog",
+        /* 260 */ "Freezing fog",
+        /* 263 */ "Patchy light drizzle",
+        /* 266 */ "Light drizzle",
+        /* 281 */ "Freezing drizzle",
+        /* 284 */ "Heavy freezing drizzle",
+        /* 293 */ "Patchy light rain",
+        /* 296 */ "Light rain",
+        /* 299 */ "Moderate rain at times",
+        /* 302 */ "Moderate rain",
+        /* 305 */ "Heavy rain at times",
+        /* 308 */ "Heavy rain",
+        /* 311 */ "Light freezing rain",
+        /* 314 */ "Moderate or Heavy freezing rain",
+        /* 317 */ "Light sleet",
+        /* 320 */ "Moderate or Heavy sleet",
+        /* 323 */ "Patchy light snow",
+        /* 326 */ "Light snow",
+        /* 329 */ "Patchy moderate snow",
+        /* 332 */ "Moderate snow",
+        /* 335 */ "Patchy heavy snow",
+        /* 338 */ "Heavy snow",
+        /* 350 */ "Ice pellets",
+        /* 353 */ "Light rain shower",
+        /* 356 */ "Moderate or heavy rain shower",
+        /* 359 */ "Torrential rain shower",
+        /* 362 */ "Light sleet showers",
+        /* 365 */ "Moderate or heavy sleet showers",
+        /* 368 */ "Light snow showers",
+        /* 371 */ "Moderate or heavy snow showers",
+        /* 374 */ "Light showers of ice pellets",
+        /* 377 */ "Showers of ice pellets",
+        /* 386 */ "Patchy light rain with thunder",
+        /* 389 */ "Moderate or heavy rain with thunder",
+        /* 392 */ "Patchy light snow with thunder",
+        /* 395 */ "Moderate or heavy snow with thunder",
+    },
+    {
         "N", "NNE", "NE", "ENE", "E", "ESE", "SE", "SSE",
         "S", "SSW", "SW", "WSW", "W", "WNW", "NW", "NNW"
-    };
-    int i_degree = atoi(degree);
+    },
+    { "Low", "Moderate", "High", " Very High", "Extreme" },
+};
+
+static const wttr_lang_t LangKo = {
+    "ko",
+    {
+        "알 수 없음",
+        /* 113 */ "맑음",
+        /* 116 */ "부분적으로 흐림",
+        /* 119 */ "흐림",
+        /* 122 */ "매우 흐림",
+        /* 143 */ "안개",
+        /* 176 */ "가벼운 비",
+        /* 179 */ "가벼운 눈비",
+        /* 182 */ "가벼운 비와 눈",
+        /* 185 */ "얕은 비",
+        /* 200 */ "천둥",
+        /* 227 */ "가벼운 눈",
+        /* 230 */ "강한 눈",
+        /* 248 */ "안개",
+        /* 260 */ "서리 낀 안개",
+        /* 263 */ "가벼운 이슬비",
+        /* 266 */ "약한 이슬비",
+        /* 281 */ "얕은 이슬비",
+        /* 284 */ "강한 이슬비",
+        /* 293 */ "가벼운 비",
+        /* 296 */ "약한 비",
+        /* 299 */ "가벼운 비",
+        /* 302 */ "강한 비",
+        /* 305 */ "소나기",
+        /* 308 */ "강한 소나기",
+        /* 311 */ "가벼운 비와 눈",
+        /* 314 */ "강한 비와 눈",
+        /* 317 */ "비와 진눈깨비",
+        /* 320 */ "가벼운 진눈깨비",
+        /* 323 */ "가벼운 눈",
+        /* 326 */ "가끔 눈",
+        /* 329 */ "많은 눈",
+        /* 332 */ "강한 눈",
+        /* 335 */ "눈보라",
+        /* 338 */ "강한 눈보라",
+        /* 350 */ "우박",
+        /* 353 */ "약한 소나기",
+        /* 356 */ "강한 소나기",
+        /* 359 */ "매우 강한 소나기",
+        /* 362 */ "소나기와 눈",
+        /* 365 */ "강한 소나기와 눈",
+        /* 368 */ "가끔 눈",
+        /* 371 */ "강한 눈",
+        /* 374 */ "눈 소나기",
+        /* 377 */ "진눈깨비",
+        /* 386 */ "약한 천둥",
+        /* 389 */ "천둥과 비",
+        /* 392 */ "천둥과 눈",
+        /* 395 */ "강한 천둥과 눈",
+    },
+    {
+        "북", "북북동", "북동", "동북동", "동", "동남동", "남동", "남남동",
+        "남", "남남서", "남서", "서남서", "서", "서북서", "북서", "북북서"
+    },
+    { "낮음", "보통", "높음", "매우 높음", "매우 위험함" },
+};
+
+//------------------------------------------------------------------------------
+// 언어 pack 목록 (eWTTR_LANG_EN, eWTTR_LANG_KO 는 기본 등록)
+// 등록은 LangLock 으로 직렬화, 조회는 lock 없이 atomic load 로 읽음.
+// Langs[id] 를 먼저 기록한 뒤 LangCnt 를 release 로 게시하므로
+// acquire 로 읽은 LangCnt 범위 안의 slot 은 항상 유효함.
+//------------------------------------------------------------------------------
+static pthread_mutex_t      LangLock = PTHREAD_MUTEX_INITIALIZER;
+static const wttr_lang_t    *Langs [WTTR_LANG_MAX] = { &LangEn, &LangKo };
+static int                  LangCnt = eWTTR_LANG_BUILTIN;
+
+static inline const wttr_lang_t *lang_get (int lang)
+{
+    if (lang < 0 || lang >= __atomic_load_n (&LangCnt, __ATOMIC_ACQUIRE))
+        return &LangEn;
+    return __atomic_load_n (&Langs[lang], __ATOMIC_ACQUIRE);
+}
+
+//------------------------------------------------------------------------------
+// 언어 pack 등록, 반환값 = 언어 id (-1 = 등록 실패)
+// 같은 code 가 있으면 교체함. lang 은 계속 유효한 메모리여야 함.
+//------------------------------------------------------------------------------
+int wttr_lang_register (const wttr_lang_t *lang)
+{
+    int id;
+
+    if (!lang || !lang->code) return -1;
+
+    pthread_mutex_lock (&LangLock);
+    for (id = 0; id < LangCnt; id++)
+        if (!strcmp (Langs[id]->code, lang->code)) break;
+
+    if (id < WTTR_LANG_MAX) {
+        __atomic_store_n (&Langs[id], lang, __ATOMIC_RELEASE);
+        if (id == LangCnt)
+            __atomic_store_n (&LangCnt, LangCnt + 1, __ATOMIC_RELEASE);
+    } else {
+        id = -1;
+    }
+    pthread_mutex_unlock (&LangLock);
+    return id;
+}
+
+//------------------------------------------------------------------------------
+// 언어 code("ko", "en" ...) 로 언어 id 검색 (-1 = 없음)
+//------------------------------------------------------------------------------
+int wttr_lang_find (const char *code)
+{
+    int cnt = __atomic_load_n (&LangCnt, __ATOMIC_ACQUIRE);
+
+    for (int id = 0; code && id < cnt; id++)
+        if (!strcmp (__atomic_load_n (&Langs[id], __ATOMIC_ACQUIRE)->code, code))
+            return id;
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+// 날씨 코드 문자열 변환 (-1 = 코드 형식 아님)
+// 이전 strcmp 비교와 같이 "113" 처럼 정확한 숫자열만 허용함.
+// (앞뒤 공백, 부호, "0113" 같은 앞자리 0 은 알 수 없는 코드로 처리)
+//------------------------------------------------------------------------------
+static inline int code_to_int (const char *str)
+{
+    int val = 0, len = 0;
+
+    if (!str || (str[0] == '0' && str[1])) return -1;
+    for (; *str; str++, len++) {
+        if (*str < '0' || *str > '9' || len >= 4) return -1;
+        val = val * 10 + (*str - '0');
+    }
+    return len ? val : -1;
+}
+
+//------------------------------------------------------------------------------
+// 날씨 코드 변환
+//------------------------------------------------------------------------------
+const char *wttr_weather_code_str (int code, int lang)
+{
+    int index = (code >= 0 && code < WTTR_WCODE_MAX) ? WeatherCodeIndex[code] : 0;
+
+    return lang_get (lang)->weather[index];
+}
+
+//------------------------------------------------------------------------------
+// 풍향 Degree → 16방위 (360도를 16방위로 나누면 22.5도씩)
+//------------------------------------------------------------------------------
+const char *wttr_wind_degree_str (int degree, int lang)
+{
+    degree %= 360;
+    if (degree < 0) degree += 360;
+
+    return lang_get (lang)->wind[((degree * 100 + 1125) / 2250) % 16];
+}
+
+//------------------------------------------------------------------------------
+// 자외선 지수 변환
+//------------------------------------------------------------------------------
+const char *wttr_uv_index_str (int index, int lang)
+{
+    int level = (index < 0) ? 0 : (index < (int)sizeof(UvLevel)) ? UvLevel[index] : 4;
+
+    return lang_get (lang)->uv[level];
+}
+
+//------------------------------------------------------------------------------
+// 풍향 Degree → 한글
+//------------------------------------------------------------------------------
+const char* translate_wind_degree (const char *degree, int is_kor) {
+    int index;
+
+    if (!degree) degree = "0";
+
+    // 이전 구현과 동일한 계산 (-33도 까지는 "북", 360도 이상은 나머지 방위)
+    index = (int)((atoi (degree) + 11.25) / 22.5) % 16;
+    // 이전 구현은 더 작은 음수에서 배열 밖을 읽었음. 16방위 안으로 wrap.
+    if (index < 0) index += 16;
 
-    // 360도를 16방위로 나누면 22.5도씩
-    int index = (int)((i_degree + 11.25) / 22.5) % 16;
-    return is_kor ? directions[index] : directions_en[index];
+    return lang_get (is_kor ? eWTTR_LANG_KO : eWTTR_LANG_EN)->wind[index];
 }
 
 //------------------------------------------------------------------------------
 // 날씨 코드 변환
 //------------------------------------------------------------------------------
 const char* translate_weather_code(const char* code, int is_kor) {
-    if (strcmp(code, "113") == 0) return is_kor ? "맑음" : "Clear";
-    if (strcmp(code, "116") == 0) return is_kor ? "부분적으로 흐림" : "Partly Cloudy";
-    if (strcmp(code, "119") == 0) return is_kor ? "흐림" : "Cloudy";
-    if (strcmp(code, "122") == 0) return is_kor ? "매우 흐림" : "Overcast";
-    if (strcmp(code, "143") == 0) return is_kor ? "안개" : "Mist";
-    if (strcmp(code, "176") == 0) return is_kor ? "가벼운 비" : "Patchy rain";
-    if (strcmp(code, "179") == 0) return is_kor ? "가벼운 눈비" : "Patchy snow";
-    if (strcmp(code, "182") == 0) return is_kor ? "가벼운 비와 눈" : "Patchy sleet";
-    if (strcmp(code, "185") == 0) return is_kor ? "얕은 비" : "Patchy freezing drizzle";
-    if (strcmp(code, "200") == 0) return is_kor ? "천둥" : "Thundery outbreaks";
-    if (strcmp(code, "227") == 0) return is_kor ? "가벼운 눈" : "Blowing snow";
-    if (strcmp(code, "230") == 0) return is_kor ? "강한 눈" : "Blizzard";
-    if (strcmp(code, "248") == 0) return is_kor ? "안개" : "Fog";
-    if (strcmp(code, "260") == 0) return is_kor ? "서리 낀 안개" : "Freezing fog";
-    if (strcmp(code, "263") == 0) return is_kor ? "가벼운 이슬비" : "Patchy light drizzle";
-    if (strcmp(code, "266") == 0) return is_kor ? "약한 이슬비" : "Light drizzle";
-    if (strcmp(code, "281") == 0) return is_kor ? "얕은 이슬비" : "Freezing drizzle";
-    if (strcmp(code, "284") == 0) return is_kor ? "강한 이슬비" : "Heavy freezing drizzle";
-    if (strcmp(code, "293") == 0) return is_kor ? "가벼운 비" : "Patchy light rain";
-    if (strcmp(code, "296") == 0) return is_kor ? "약한 비" : "Light rain";
-    if (strcmp(code, "299") == 0) return is_kor ? "가벼운 비" : "Moderate rain at times";
-    if (strcmp(code, "302") == 0) return is_kor ? "강한 비" : "Moderate rain";
-    if (strcmp(code, "305") == 0) return is_kor ? "소나기" : "Heavy rain at times";
-    if (strcmp(code, "308") == 0) return is_kor ? "강한 소나기" : "Heavy rain";
-    if (strcmp(code, "311") == 0) return is_kor ? "가벼운 비와 눈" : "Light freezing rain";
-    if (strcmp(code, "314") == 0) return is_kor ? "강한 비와 눈" : "Moderate or Heavy freezing rain";
-    if (strcmp(code, "317") == 0) return is_kor ? "비와 진눈깨비" : "Light sleet";
-    if (strcmp(code, "320") == 0) return is_kor ? "가벼운 진눈깨비" : "Moderate or Heavy sleet";
-    if (strcmp(code, "323") == 0) return is_kor ? "가벼운 눈" : "Patchy light snow";
-    if (strcmp(code, "326") == 0) return is_kor ? "가끔 눈" : "Light snow";
-    if (strcmp(code, "329") == 0) return is_kor ? "많은 눈" : "Patchy moderate snow";
-    if (strcmp(code, "332") == 0) return is_kor ? "강한 눈" : "Moderate snow";
-    if (strcmp(code, "335") == 0) return is_kor ? "눈보라" : "Patchy heavy snow";
-    if (strcmp(code, "338") == 0) return is_kor ? "강한 눈보라" : "Heavy snow";
-    if (strcmp(code, "350") == 0) return is_kor ? "우박" : "Ice pellets";
-    if (strcmp(code, "353") == 0) return is_kor ? "약한 소나기" : "Light rain shower";
-    if (strcmp(code, "356") == 0) return is_kor ? "강한 소나기" : "Moderate or heavy rain shower";
-    if (strcmp(code, "359") == 0) return is_kor ? "매우 강한 소나기" : "Torrential rain shower";
-    if (strcmp(code, "362") == 0) return is_kor ? "소나기와 눈" : "Light sleet showers";
-    if (strcmp(code, "365") == 0) return is_kor ? "강한 소나기와 눈" : "Moderate or heavy sleet showers";
-    if (strcmp(code, "368") == 0) return is_kor ? "가끔 눈" : "Light snow showers";
-    if (strcmp(code, "371") == 0) return is_kor ? "강한 눈" : "Moderate or heavy snow showers";
-    if (strcmp(code, "374") == 0) return is_kor ? "눈 소나기" : "Light showers of ice pellets";
-    if (strcmp(code, "377") == 0) return is_kor ? "진눈깨비" : "Showers of ice pellets";
-    if (strcmp(code, "386") == 0) return is_kor ? "약한 천둥" : "Patchy light rain with thunder";
-    if (strcmp(code, "389") == 0) return is_kor ? "천둥과 비" : "Moderate or heavy rain with thunder";
-    if (strcmp(code, "392") == 0) return is_kor ? "천둥과 눈" : "Patchy light snow with thunder";
-    if (strcmp(code, "395") == 0) return is_kor ? "강한 천둥과 눈" : "Moderate or heavy snow with thunder";
-    return is_kor ? "알 수 없음" : "Unknown";
+    return wttr_weather_code_str (code_to_int (code), is_kor ? eWTTR_LANG_KO : eWTTR_LANG_EN);
 }
 
 //------------------------------------------------------------------------------
 const char* translate_uv_index (const char* index, int is_kor) {
-    int i_index = atoi(index);
-    switch (i_index) {
-        case 0 ... 2:   return is_kor ? "낮음" : "Low";
-        case 3 ... 5:   return is_kor ? "보통" : "Moderate";
-        case 6 ... 7:   return is_kor ? "높음" : "High";
-        case 8 ... 10:  return is_kor ? "매우 높음" : " Very High";
-        default:        return is_kor ? "매우 위험함" : "Extreme";
-    }
+    int i_index = index ? atoi (index) : 0;
+
+    // 이전 구현과 같이 음수는 "Extreme" (switch 의 default)
+    return wttr_uv_index_str (i_index < 0 ? INT_MAX : i_index,
+                                is_kor ? eWTTR_LANG_KO : eWTTR_LANG_EN);
 }
 
 //------------------------------------------------------------------------------
@@ -173,83 +533,246 @@ char *url_encode (const char *str) {
 
 //------------------------------------------------------------------------------
 // 숫자를 한글로 출력
+// 한글 숫자/자리 이름은 모두 UTF-8 3byte 글자이므로 table 에서 바로 복사함.
+// 4자리 단위(만, 억)로 나누어 앞에서부터 한번에 씀 (int 전체 범위, 음수 = "마이너스").
 //------------------------------------------------------------------------------
-void int_to_kor_buf (int num, char* output) {
-    const char *digits[] = { "영", "일", "이", "삼", "사", "오", "육", "칠", "팔", "구" };
-    char buffer[64] = "", temp[8];
-    int digit, pos;
+#define KOR_CHAR_SIZE   3
+
+static const char KorDigit [10][KOR_CHAR_SIZE + 1] = {
+    "영", "일", "이", "삼", "사", "오", "육", "칠", "팔", "구"
+};
+/* 4자리 안의 자리 이름 (천, 백, 십, 일의 자리) */
+static const char KorPlace [4][KOR_CHAR_SIZE + 1] = { "천", "백", "십", "" };
+/* 4자리 단위 이름 */
+static const char KorUnit  [3][KOR_CHAR_SIZE + 1] = { "", "만", "억" };
+static const unsigned short KorPow [4] = { 1000, 100, 10, 1 };
 
-    sprintf(buffer, "%d", num);
-    if (output) memset (output, 0, WTTR_DATA_SIZE);
+#define KOR_MINUS       "마이너스"
 
-    if (!num)   {
-        sprintf (output, "%s", digits[0]);
-        return;
+static inline char *kor_put (char *p, const char *end, const char *str, size_t len)
+{
+    if (p + len > end)  return NULL;
+    memcpy (p, str, len);
+    return p + len;
+}
+
+int wttr_int_to_kor (int num, char *buf, size_t size)
+{
+    unsigned int val = (num < 0) ? 0u - (unsigned int)num : (unsigned int)num;
+    unsigned short group [3];
+    char *p = buf, *end;
+    int g;
+
+    if (!buf || !size)  return -1;
+
+    /* 마지막 '\0' 자리 */
+    end = buf + size - 1;
+
+    if (!val) {
+        if ((p = kor_put (p, end, KorDigit[0], KOR_CHAR_SIZE)) == NULL)
+            goto truncated;
+        *p = '\0';
+        return KOR_CHAR_SIZE;
     }
 
-    for (size_t i = 0, place = strlen(buffer); i < strlen(buffer); i++, place--) {
-        digit = buffer[i] - '0';
-        temp[0] = '\0';
+    if (num < 0 && (p = kor_put (p, end, KOR_MINUS, sizeof(KOR_MINUS) - 1)) == NULL)
+        goto truncated;
+
+    group[0] = val % 10000;
+    group[1] = (val / 10000) % 10000;
+    group[2] = val / 100000000;
+
+    for (g = 2; g >= 0; g--) {
+        unsigned int n = group[g];
+
+        if (!n) continue;
 
-        if (digit) {
-            pos = (digit == 1) ? 0 : sprintf(temp, "%s", digits[digit]);
-            switch (place) {
-                case 5: sprintf(&temp[pos], "%s", "만");  break;
-                case 4: sprintf(&temp[pos], "%s", "천");  break;
-                case 3: sprintf(&temp[pos], "%s", "백");  break;
-                case 2: sprintf(&temp[pos], "%s", "십");  break;
+        /* 맨 앞의 10000 = "만" (일만 이 아님), 100010000 = "일억일만" */
+        if (!(n == 1 && g == 1 && !group[2])) {
+            for (int i = 0; i < 4; i++) {
+                unsigned int d = (n / KorPow[i]) % 10;
+
+                if (!d) continue;
+                /* 십/백/천 앞의 "일" 은 생략 */
+                if ((d != 1 || i == 3) &&
+                    (p = kor_put (p, end, KorDigit[d], KOR_CHAR_SIZE)) == NULL)
+                    goto truncated;
+                if (i != 3 &&
+                    (p = kor_put (p, end, KorPlace[i], KOR_CHAR_SIZE)) == NULL)
+                    goto truncated;
             }
-            strcat(output, temp);
         }
+        if (g && (p = kor_put (p, end, KorUnit[g], KOR_CHAR_SIZE)) == NULL)
+            goto truncated;
     }
+    *p = '\0';
+    return (int)(p - buf);
+
+truncated:
+    /* 일부만 쓴 숫자는 다른 값으로 읽히므로 빈 문자열로 반환 */
+    buf[0] = '\0';
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+// output 은 WTTR_DATA_SIZE 크기 buffer (넘치는 경우 빈 문자열)
+//------------------------------------------------------------------------------
+void int_to_kor_buf (int num, char* output) {
+    wttr_int_to_kor (num, output, WTTR_DATA_SIZE);
 }
 
 const char *int_to_kor (int num)
 {
-    memset (KorString, 0, WTTR_DATA_SIZE);
+    static __thread char str [WTTR_KOR_NUM_SIZE];
+
+    wttr_int_to_kor (num, str, sizeof(str));
+
+    return str;
+}
+
+//------------------------------------------------------------------------------
+// 날짜/시간 한글, 영어 변환 table
+//------------------------------------------------------------------------------
+static const char *KorWeekDay [7] = { "일", "월", "화", "수", "목", "금", "토" };
+/* 6월 = 유월, 10월 = 시월 */
+static const char *KorMonth  [12] = {
+    "일", "이", "삼", "사", "오", "유", "칠", "팔", "구", "시", "십일", "십이"
+};
+static const char *KorHour   [13] = {
+    "영", "한", "두", "세", "네", "다섯", "여섯", "일곱", "여덟", "아홉", "열", "열한", "열두"
+};
+static const char *EngWeekDay [7] = {
+    "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"
+};
+static const char *EngMonth  [12] = {
+    "January", "February", "March", "April", "May", "June",
+    "July", "August", "September", "October", "November", "December"
+};
+
+//------------------------------------------------------------------------------
+// 시간대(WTTR_TIMEZONE)는 처음 한번만 설정
+//------------------------------------------------------------------------------
+static pthread_once_t   TzOnce = PTHREAD_ONCE_INIT;
+
+static void tz_init (void)
+{
+    setenv ("TZ", WTTR_TIMEZONE, 1);
+    tzset ();
+}
+
+//------------------------------------------------------------------------------
+// i_time == NULL 이면 현재시간을 lt 에 변환하여 반환
+//------------------------------------------------------------------------------
+static const struct tm *local_tm (const struct tm *i_time, struct tm *lt)
+{
+    time_t t;
+
+    if (i_time) return i_time;
+
+    pthread_once (&TzOnce, tz_init);
+    t = time (NULL);
+    return localtime_r (&t, lt);
+}
+
+static inline int hour_12 (int hour)
+{
+    return (hour % 12) ? hour % 12 : 12;
+}
+
+//------------------------------------------------------------------------------
+// 날짜/시간 문장 (t == NULL 이면 현재시간), buf 가 작으면 빈 문자열 및 -1
+// 한글 : "이천이십오년 오월 십사일 수요일 오후 세시 오분" (0분은 생략)
+// 영어 : "Wednesday, May 14, 2025, 3:05 PM"
+//------------------------------------------------------------------------------
+static int kor_num (char **p, const char *end, int num, const char *unit)
+{
+    int len = wttr_int_to_kor (num, *p, end - *p + 1);
+
+    if (len < 0 || !(*p = kor_put (*p + len, end, unit, strlen (unit))))
+        return 0;
+    return 1;
+}
+
+static int kor_str (char **p, const char *end, const char *str, const char *unit)
+{
+    if (!(*p = kor_put (*p, end, str, strlen (str))) ||
+        !(*p = kor_put (*p, end, unit, strlen (unit))))
+        return 0;
+    return 1;
+}
+
+int wttr_date_str (const struct tm *t, int lang, char *buf, size_t size)
+{
+    const struct tm *lt;
+    struct tm now;
+    char *p = buf, *end;
+    int len;
 
-    int_to_kor_buf (num, KorString) ;
+    if (!buf || !size)  return -1;
 
-    return (const char *)&KorString[0];
+    if (!(lt = local_tm (t, &now))) {
+        buf[0] = '\0';
+        return -1;
+    }
+
+    if (lang != eWTTR_LANG_KO) {
+        len = snprintf (buf, size, "%s, %s %d, %d, %d:%02d %s",
+                EngWeekDay[lt->tm_wday % 7], EngMonth[lt->tm_mon % 12],
+                lt->tm_mday, lt->tm_year + 1900,
+                hour_12 (lt->tm_hour), lt->tm_min, (lt->tm_hour < 12) ? "AM" : "PM");
+        if (len < 0 || (size_t)len >= size) {
+            buf[0] = '\0';
+            return -1;
+        }
+        return len;
+    }
+
+    end = buf + size - 1;
+
+    if (!kor_num (&p, end, lt->tm_year + 1900, "년 ")                                   ||
+        !kor_str (&p, end, KorMonth[lt->tm_mon % 12], "월 ")                            ||
+        !kor_num (&p, end, lt->tm_mday, "일 ")                                          ||
+        !kor_str (&p, end, KorWeekDay[lt->tm_wday % 7], "요일 ")                        ||
+        !kor_str (&p, end, (lt->tm_hour < 12) ? "오전" : "오후", " ")                   ||
+        !kor_str (&p, end, KorHour[hour_12 (lt->tm_hour)], lt->tm_min ? "시 " : "시")   ||
+        (lt->tm_min && !kor_num (&p, end, lt->tm_min, "분"))) {
+        buf[0] = '\0';
+        return -1;
+    }
+    *p = '\0';
+    return (int)(p - buf);
 }
 
 //------------------------------------------------------------------------------
 // 현재시간이나 입력되어진 시간중 원하는 필드의 한글 값을 얻어온다.
+// k_str 은 WTTR_DATA_SIZE 크기 buffer
 //------------------------------------------------------------------------------
 void date_to_kor_buf (enum eDayItem d_item, void *i_time, char *k_str)
 {
-    struct tm *lt;
-    time_t t = time(NULL);
-    const char *weekday_korean[] = { "일", "월", "화", "수", "목", "금", "토" };
-    const char *hour_korean[] = {"영", "한", "두", "세", "네", "다섯", "여섯", "일곱", "여덟", "아홉", "열", "열한", "열두"};
-
-    setenv("TZ", "Asia/Seoul", 1);  // 타임존 설정
+    const struct tm *lt;
+    struct tm now;
 
-    if (i_time == NULL) lt = localtime(&t);
-    else                lt = (struct tm *)i_time;
+    if (!k_str) return;
 
-    if (k_str)  memset (k_str, 0, WTTR_DATA_SIZE);
+    k_str[0] = '\0';
+    if (!(lt = local_tm ((const struct tm *)i_time, &now)))
+        return;
 
     switch (d_item) {
         case eDAY_AM_PM:
-            strncpy (k_str, (lt->tm_hour < 12) ? "오전" : "오후", strlen ("오전"));
+            snprintf (k_str, WTTR_DATA_SIZE, "%s", (lt->tm_hour < 12) ? "오전" : "오후");
             break;
-
-        case eDAY_SEC:      int_to_kor_buf (lt->tm_sec, k_str);           break;
-        case eDAY_MIN:      int_to_kor_buf (lt->tm_min, k_str);           break;
-
+        case eDAY_SEC:      int_to_kor_buf (lt->tm_sec, k_str);                         break;
+        case eDAY_MIN:      int_to_kor_buf (lt->tm_min, k_str);                         break;
         case eDAY_HOUR:
-            int hour = (lt->tm_hour == 12) ? 12 : lt->tm_hour % 12;
-            strncpy (k_str, hour_korean[hour], strlen (hour_korean[hour]));
+            snprintf (k_str, WTTR_DATA_SIZE, "%s", KorHour[hour_12 (lt->tm_hour)]);
             break;
-
         case eDAY_W_DAY:
-            strncpy (k_str, weekday_korean[lt->tm_wday], strlen (weekday_korean[lt->tm_wday]));
+            snprintf (k_str, WTTR_DATA_SIZE, "%s", KorWeekDay[lt->tm_wday % 7]);
             break;
-
-        case eDAY_DAY:      int_to_kor_buf (lt->tm_mday, k_str);          break;
-        case eDAY_MONTH:    int_to_kor_buf (lt->tm_mon  + 1,    k_str);   break;
-        case eDAY_YEAR:     int_to_kor_buf (lt->tm_year + 1900, k_str);   break;
+        case eDAY_DAY:      int_to_kor_buf (lt->tm_mday, k_str);                        break;
+        case eDAY_MONTH:    int_to_kor_buf (lt->tm_mon  + 1,    k_str);                 break;
+        case eDAY_YEAR:     int_to_kor_buf (lt->tm_year + 1900, k_str);                 break;
         default :
             break;
     }
@@ -257,11 +780,11 @@ void date_to_kor_buf (enum eDayItem d_item, void *i_time, char *k_str)
 
 const char *date_to_kor (enum eDayItem d_item, void *i_time)
 {
-    memset (KorString, 0, WTTR_DATA_SIZE);
+    static __thread char str [WTTR_DATA_SIZE];
 
-    date_to_kor_buf (d_item, i_time, KorString);
+    date_to_kor_buf (d_item, i_time, str);
 
-    return (const char *)&KorString[0];
+    return str;
 }
 
 //------------------------------------------------------------------------------
@@ -292,210 +815,5597 @@ static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, voi
 }
 
 //------------------------------------------------------------------------------
-// 위,경도에 위치한 도시/지역 요청
 //------------------------------------------------------------------------------
-void get_location_json (double lat, double lon, char *g_city, char *g_country, int is_kor)
-{
-    CURL *curl;
-    CURLcode res;
-    struct MemoryStruct chunk = {malloc(1), 0};
-    char url[512];
-
-    #if defined (__LIB_WEATHER_DEBUG__)
-        printf("lat = %f, lon = %f, is_kor = %d\n", lat, lon, is_kor);
-    #endif
-
-    snprintf (url, sizeof(url), is_kor ? LOCATION_URL_FORMAT_KR : LOCATION_URL_FORMAT_EN, lat, lon);
-
-    curl_global_init(CURL_GLOBAL_ALL);
-    if (!(curl = curl_easy_init())) return;
-
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "C-Geocoder/1.0");
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+// Streaming field 추출기
+// cURL 에서 받은 데이터를 바로 scan 하여 wttr_data_t table 의 항목만 추출함.
+// 전체 응답 buffer 나 cJSON tree 를 만들지 않으며 모든 항목을 찾은 뒤의
+// 데이터("weather" 예보 등)는 scan 하지 않고 버림.
+//
+// 추출 대상 경로 : root.{sub_class}[0].{item_str}
+//                  root.{sub_class}[0].{item_str}[0].value  (areaName, country)
+//------------------------------------------------------------------------------
+#define STREAM_DEPTH        8
+#define STREAM_KEY_SIZE     24
 
-    if ((res = curl_easy_perform(curl)) != CURLE_OK) {
-        fprintf(stderr, "curl 요청 실패: %s\n", curl_easy_strerror(res));
-    } else {
-        cJSON *json = cJSON_Parse(chunk.memory);
-        if (json) {
-            cJSON *address = cJSON_GetObjectItemCaseSensitive(json, "address");
-            if (address) {
-                const char *city = NULL, *country = NULL;
-
-                cJSON *fields_city[] = {
-                    cJSON_GetObjectItemCaseSensitive(address, "city"),
-                    cJSON_GetObjectItemCaseSensitive(address, "town"),
-                    cJSON_GetObjectItemCaseSensitive(address, "village"),
-                    cJSON_GetObjectItemCaseSensitive(address, "county")
-                };
-                for (int i = 0; i < 4; i++) {
-                    if (fields_city[i]) {
-                        city = fields_city[i]->valuestring;
-                        break;
-                    }
-                }
+enum {
+    ST_VALUE = 0,   /* 값 대기 */
+    ST_ARRAY,       /* '[' 직후 (값 또는 ']') */
+    ST_KEY,         /* object key 또는 '}' 대기 */
+    ST_COLON,
+    ST_NEXT,        /* ',' 또는 닫는 괄호 대기 */
+    ST_STRING,
+    ST_LITERAL,     /* number, true, false, null */
+    ST_END,
+    ST_ERROR,
+};
 
-                country = cJSON_GetObjectItemCaseSensitive(address, "country") ?
-                          cJSON_GetObjectItemCaseSensitive(address, "country")->valuestring : NULL;
+struct stream_level {
+    char    type;                   /* '{' or '[' */
+    int     index;                  /* array index */
+    char    key [STREAM_KEY_SIZE];  /* object 의 현재 key */
+};
 
-                #if defined (__LIB_WEATHER_DEBUG__)
-                    const char *state = NULL;
+typedef struct wttr_stream__t {
+    wttr_data_t         *data;
+    size_t              cnt;
+    unsigned int        found;
+    int                 complete;
 
-                    state = cJSON_GetObjectItemCaseSensitive(address, "state") ?
-                            cJSON_GetObjectItemCaseSensitive(address, "state")->valuestring : NULL;
+    int                 state;
+    int                 depth;
+    struct stream_level level [STREAM_DEPTH];
 
-                    printf("\n[위치 정보]\n");
-                    printf("도시:   %s\n", city ? city : "(정보 없음)");
-                    printf("지역:   %s\n", state ? state : "(정보 없음)");
-                    printf("국가:   %s\n", country ? country : "(정보 없음)");
-                #endif
+    /* string / literal */
+    int                 is_key, escape, hex_cnt, target;
+    unsigned int        ucode, usurr;
+    char                buf [WTTR_DATA_SIZE];
+    size_t              len;
 
-                memset  (g_city,       0,    strlen(city)+1);
-                strncpy (g_city,    city,    strlen(city));
-                memset  (g_country,    0,    strlen(country)+1);
-                strncpy (g_country, country, strlen(country));
+    size_t              bytes;      /* 수신된 데이터 (압축 해제 후) */
+    unsigned long long  hash;       /* 수신된 데이터 hash (payload_hash) */
+}   wttr_stream_t;
 
-            } else {
-                fprintf(stderr, "주소 정보 없음\n");
-                memset  (g_city,       0,    1);
-                memset  (g_country,    0,    1);
-            }
-            cJSON_Delete(json);
-        } else {
-            fprintf(stderr, "JSON 파싱 실패\n");
-        }
-    }
-    free(chunk.memory);
-    curl_easy_cleanup(curl);
+static void stream_init (wttr_stream_t *st, wttr_data_t *data, size_t cnt)
+{
+    memset (st, 0, sizeof(wttr_stream_t));
+    st->data   = data;
+    st->cnt    = cnt;
+    st->hash   = PAYLOAD_HASH_INIT;
+    st->state  = ST_VALUE;
+    st->target = -1;
 }
 
 //------------------------------------------------------------------------------
-// HTTP 요청 (location = 지역명(한글/영어), "위도,경도")
+// 현재 위치의 값이 추출 대상인지 확인, 대상이면 data index 반환
 //------------------------------------------------------------------------------
-char *get_weather_json (const char *location)
+static int stream_target (wttr_stream_t *st)
 {
-    CURL *curl;
-    CURLcode res;
-    struct MemoryStruct chunk = {malloc(1), 0};
-
-    #if defined (__LIB_WEATHER_DEBUG__)
-        printf("입력지역: %s\n", location[0] ? location : "현위치");
-    #endif
+    struct stream_level *lv = st->level;
 
-    // location 인코딩 (한글/영문 지역 사용가능)
-    char *encoded_location = url_encode(location && strlen(location) > 0 ? location : "");
-
-    char url[512];
-    snprintf(url, sizeof(url), WEATHER_URL_FORMAT, encoded_location);
-    free(encoded_location);
+    if (st->depth != 3 && st->depth != 5)                       return -1;
+    if (lv[0].type != '{' || lv[1].type != '[' || lv[1].index)  return -1;
+    if (lv[2].type != '{')                                      return -1;
+    if (st->depth == 5 &&
+        (lv[3].type != '[' || lv[3].index || lv[4].type != '{' || strcmp (lv[4].key, "value")))
+        return -1;
 
-    curl_global_init(CURL_GLOBAL_ALL);
-    if (!(curl = curl_easy_init())) return NULL;
+    for (size_t i = 0; i < st->cnt; i++) {
+        if (st->found & (1u << i)) continue;
+        if (!strcmp (st->data[i].item_str, lv[2].key) && !strcmp (*st->data[i].sub_class, lv[0].key))
+            return (int)i;
+    }
+    return -1;
+}
 
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0");
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+static void stream_putc (wttr_stream_t *st, char c)
+{
+    size_t size = st->is_key ? STREAM_KEY_SIZE : WTTR_DATA_SIZE;
 
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    if (st->len < size - 1) st->buf[st->len++] = c;
+}
 
-    if ((res = curl_easy_perform(curl)) != CURLE_OK) {
-        free(chunk.memory);
-        curl_easy_cleanup(curl);
-        return NULL;
+static void stream_put_utf8 (wttr_stream_t *st, unsigned int u)
+{
+    if (u < 0x80) {
+        stream_putc (st, u);
+    } else if (u < 0x800) {
+        stream_putc (st, 0xC0 | (u >> 6));
+        stream_putc (st, 0x80 | (u & 0x3F));
+    } else if (u < 0x10000) {
+        stream_putc (st, 0xE0 | (u >> 12));
+        stream_putc (st, 0x80 | ((u >> 6) & 0x3F));
+        stream_putc (st, 0x80 | (u & 0x3F));
+    } else {
+        stream_putc (st, 0xF0 | (u >> 18));
+        stream_putc (st, 0x80 | ((u >> 12) & 0x3F));
+        stream_putc (st, 0x80 | ((u >> 6) & 0x3F));
+        stream_putc (st, 0x80 | (u & 0x3F));
     }
-
-    curl_easy_cleanup(curl);
-    return chunk.memory;
 }
 
 //------------------------------------------------------------------------------
+// 값 하나가 끝났을 때 (string / literal)
 //------------------------------------------------------------------------------
-// Json 날씨데이터 파싱 및 저장(WttrData Struct)
+static void stream_value_end (wttr_stream_t *st)
+{
+    if (st->target >= 0) {
+        st->buf[st->len] = '\0';
+        memcpy (st->data[st->target].data_str, st->buf, st->len + 1);
+        st->found |= (1u << st->target);
+
+        if (st->found == (1u << st->cnt) - 1)
+            st->complete = 1;
+    }
+    st->target = -1;
+    st->state  = st->depth ? ST_NEXT : ST_END;
+}
+
+static void stream_value_start (wttr_stream_t *st, int state)
+{
+    st->is_key = 0;
+    st->len    = 0;
+    st->target = stream_target (st);
+    st->state  = state;
+}
+
+static int stream_push (wttr_stream_t *st, char type)
+{
+    if (st->depth < STREAM_DEPTH) {
+        st->level[st->depth].type   = type;
+        st->level[st->depth].index  = 0;
+        st->level[st->depth].key[0] = '\0';
+    }
+    st->depth++;
+    return (type == '{') ? ST_KEY : ST_ARRAY;
+}
+
+static int stream_pop (wttr_stream_t *st, char type)
+{
+    if (!st->depth) return ST_ERROR;
+    if (st->depth <= STREAM_DEPTH && st->level[st->depth - 1].type != type)
+        return ST_ERROR;
+
+    return --st->depth ? ST_NEXT : ST_END;
+}
+
+//------------------------------------------------------------------------------
+// 수신된 데이터 scan, 반환값 0 = JSON 형식 오류
+//------------------------------------------------------------------------------
+static int stream_feed (wttr_stream_t *st, const char *p, size_t len)
+{
+    for (const char *end = p + len; p < end && !st->complete; p++) {
+        unsigned char c = (unsigned char)*p;
+
+        switch (st->state) {
+        case ST_STRING:
+            if (st->hex_cnt) {
+                int v = isdigit (c) ? c - '0' : (isxdigit (c) ? (tolower (c) - 'a' + 10) : -1);
+
+                if (v < 0) return (st->state = ST_ERROR), 0;
+                st->ucode = (st->ucode << 4) | v;
+                if (--st->hex_cnt) break;
+
+                if (st->ucode >= 0xD800 && st->ucode < 0xDC00) {
+                    st->usurr = st->ucode;          /* high surrogate, 다음 \u 대기 */
+                } else if (st->ucode >= 0xDC00 && st->ucode < 0xE000 && st->usurr) {
+                    stream_put_utf8 (st, 0x10000 + ((st->usurr - 0xD800) << 10) + (st->ucode - 0xDC00));
+                    st->usurr = 0;
+                } else {
+                    stream_put_utf8 (st, st->ucode);
+                    st->usurr = 0;
+                }
+            } else if (st->escape) {
+                st->escape = 0;
+                switch (c) {
+                    case 'b':   stream_putc (st, '\b');     break;
+                    case 'f':   stream_putc (st, '\f');     break;
+                    case 'n':   stream_putc (st, '\n');     break;
+                    case 'r':   stream_putc (st, '\r');     break;
+                    case 't':   stream_putc (st, '\t');     break;
+                    case 'u':   st->hex_cnt = 4; st->ucode = 0; break;
+                    default:    stream_putc (st, c);        break;
+                }
+            } else if (c == '\\') {
+                st->escape = 1;
+            } else if (c == '"') {
+                if (st->is_key) {
+                    if (st->depth <= STREAM_DEPTH) {
+                        memcpy (st->level[st->depth - 1].key, st->buf, st->len);
+                        st->level[st->depth - 1].key[st->len] = '\0';
+                    }
+                    st->state = ST_COLON;
+                } else {
+                    stream_value_end (st);
+                }
+            } else if (st->target >= 0 || st->is_key) {
+                stream_putc (st, c);
+            }
+            break;
+
+        case ST_LITERAL:
+            if (c == ',' || c == '}' || c == ']' || isspace (c)) {
+                stream_value_end (st);
+                p--;                        /* 구분자는 ST_NEXT 에서 처리 */
+            } else if (st->target >= 0) {
+                stream_putc (st, c);
+            }
+            break;
+
+        case ST_ARRAY:
+            if (isspace (c))    break;
+            if (c == ']') {
+                st->state = stream_pop (st, '[');
+                break;
+            }
+            /* fall through */
+        case ST_VALUE:
+            if (isspace (c))    break;
+            if      (c == '{')  st->state = stream_push (st, '{');
+            else if (c == '[')  st->state = stream_push (st, '[');
+            else if (c == '"')  stream_value_start (st, ST_STRING);
+            else if (c == '-' || isalnum (c)) {
+                stream_value_start (st, ST_LITERAL);
+                if (st->target >= 0) stream_putc (st, c);
+            }
+            else                st->state = ST_ERROR;
+            break;
+
+        case ST_KEY:
+            if (isspace (c))    break;
+            if (c == '"') {
+                st->is_key = 1;
+                st->len    = 0;
+                st->state  = ST_STRING;
+            }
+            else if (c == '}')  st->state = stream_pop (st, '{');
+            else                st->state = ST_ERROR;
+            break;
+
+        case ST_COLON:
+            if (isspace (c))    break;
+            st->state = (c == ':') ? ST_VALUE : ST_ERROR;
+            break;
+
+        case ST_NEXT:
+            if (isspace (c))    break;
+            if (c == ',') {
+                struct stream_level *lv;
+
+                /* 저장하지 않는 깊이는 level 을 참조하지 않음 */
+                if (st->depth > STREAM_DEPTH) {
+                    st->state = ST_VALUE;
+                    break;
+                }
+                lv = &st->level[st->depth - 1];
+                if (lv->type == '{')    st->state = ST_KEY;
+                else                    { lv->index++; st->state = ST_VALUE; }
+            }
+            else if (c == '}')  st->state = stream_pop (st, '{');
+            else if (c == ']')  st->state = stream_pop (st, '[');
+            else                st->state = ST_ERROR;
+            break;
+
+        case ST_END:
+            if (!isspace (c))   st->state = ST_ERROR;
+            break;
+
+        default:
+            break;
+        }
+        if (st->state == ST_ERROR) {
+            fprintf(stderr, "JSON 파싱 실패\n");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 모든 항목을 찾았는지 확인
+//------------------------------------------------------------------------------
+static int stream_finish (wttr_stream_t *st)
+{
+    if (!st->complete && st->state != ST_ERROR)
+        fprintf(stderr, "날씨 정보 없음\n");
+    return st->complete;
+}
+
+//------------------------------------------------------------------------------
+// cURL 콜백 (streaming 추출)
+//------------------------------------------------------------------------------
+static size_t WriteStreamCallback(void *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsize = size * nmemb;
+    wttr_stream_t *st = (wttr_stream_t *)userp;
+
+    st->bytes += realsize;
+    st->hash   = payload_hash (st->hash, contents, realsize);
+
+    /* 모든 항목을 찾은 경우 나머지 데이터는 버림 (연결은 계속 재사용) */
+    if (st->complete)   return realsize;
+
+    return stream_feed (st, (const char *)contents, realsize) ? realsize : 0;
+}
+
+//------------------------------------------------------------------------------
+// HTTP handle pool 및 공유 cache (DNS, TLS session, connection)
+// 모든 요청이 keep-alive 된 연결과 handshake 결과를 재사용함.
+//------------------------------------------------------------------------------
+#define HTTP_POOL_SIZE  8
+
+static pthread_mutex_t  HttpLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t  ShareLock [CURL_LOCK_DATA_LAST];
+static CURLSH           *HttpShare = NULL;
+static CURL             *HttpPool [HTTP_POOL_SIZE];
+static int              HttpPoolCnt = 0;
+
+static void share_lock (CURL *curl, curl_lock_data data, curl_lock_access access, void *userp)
+{
+    (void)curl; (void)access; (void)userp;
+    pthread_mutex_lock (&ShareLock[data]);
+}
+
+static void share_unlock (CURL *curl, curl_lock_data data, void *userp)
+{
+    (void)curl; (void)userp;
+    pthread_mutex_unlock (&ShareLock[data]);
+}
+
+//------------------------------------------------------------------------------
+// curl_global_init 는 thread-safe 하지 않으므로 process 에서 한번만 호출
+//------------------------------------------------------------------------------
+static void curl_init_once (void)
+{
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++)
+        pthread_mutex_init (&ShareLock[i], NULL);
+
+    curl_global_init(CURL_GLOBAL_ALL);
+}
+
+//------------------------------------------------------------------------------
+// pool 에서 handle 을 얻어옴 (없으면 새로 생성)
+//------------------------------------------------------------------------------
+static CURL *http_handle_get (void)
+{
+    CURL *curl = NULL;
+
+    pthread_once (&CurlInitOnce, curl_init_once);
+
+    pthread_mutex_lock (&HttpLock);
+    if (!HttpShare && (HttpShare = curl_share_init()) != NULL) {
+        curl_share_setopt(HttpShare, CURLSHOPT_LOCKFUNC,   share_lock);
+        curl_share_setopt(HttpShare, CURLSHOPT_UNLOCKFUNC, share_unlock);
+        curl_share_setopt(HttpShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(HttpShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(HttpShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+    if (HttpPoolCnt)
+        curl = HttpPool[--HttpPoolCnt];
+    pthread_mutex_unlock (&HttpLock);
+
+    if (!curl && !(curl = curl_easy_init()))
+        return NULL;
+
+    if (HttpShare)
+        curl_easy_setopt(curl, CURLOPT_SHARE, HttpShare);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+
+    return curl;
+}
+
+//------------------------------------------------------------------------------
+// 사용한 handle 을 pool 에 반환 (pool 이 가득 찬 경우 해제)
+//------------------------------------------------------------------------------
+static void http_handle_put (CURL *curl)
+{
+    curl_easy_reset (curl);
+
+    pthread_mutex_lock (&HttpLock);
+    if (HttpPoolCnt < HTTP_POOL_SIZE) {
+        HttpPool[HttpPoolCnt++] = curl;
+        curl = NULL;
+    }
+    pthread_mutex_unlock (&HttpLock);
+
+    if (curl)   curl_easy_cleanup (curl);
+}
+
+//------------------------------------------------------------------------------
+// pool 및 공유 cache 해제 (진행중인 요청이 없을 때 호출)
+//------------------------------------------------------------------------------
+void wttr_http_cleanup (void)
+{
+    pthread_mutex_lock (&HttpLock);
+    while (HttpPoolCnt)
+        curl_easy_cleanup (HttpPool[--HttpPoolCnt]);
+
+    if (HttpShare) {
+        curl_share_cleanup (HttpShare);
+        HttpShare = NULL;
+    }
+    pthread_mutex_unlock (&HttpLock);
+}
+
+//------------------------------------------------------------------------------
+// 요청 base URL (기본값 → 환경변수 → wttr_set_endpoint 순서로 적용)
+//------------------------------------------------------------------------------
+static pthread_mutex_t  EndpointLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t   EndpointOnce = PTHREAD_ONCE_INIT;
+static char             Endpoint [eWTTR_EP_END][WTTR_URL_BASE_SIZE];
+static int              EndpointSet [eWTTR_EP_END];    /* 1 = 환경변수 또는 wttr_set_endpoint 로 설정 */
+
+static const char *EndpointDefault [eWTTR_EP_END] = { WEATHER_URL_BASE, LOCATION_URL_BASE, FALLBACK_URL_BASE };
+static const char *EndpointEnv     [eWTTR_EP_END] = { WEATHER_URL_ENV,  LOCATION_URL_ENV,  FALLBACK_URL_ENV  };
+
+static int endpoint_copy (int ep, const char *base_url)
+{
+    size_t len = strlen (base_url);
+
+    /* path 가 '/' 로 시작하므로 끝의 '/' 는 제거 */
+    while (len && base_url[len - 1] == '/')
+        len--;
+    if (!len || len >= WTTR_URL_BASE_SIZE)
+        return 0;
+
+    memcpy (Endpoint[ep], base_url, len);
+    Endpoint[ep][len] = '\0';
+    return 1;
+}
+
+static void endpoint_init (void)
+{
+    for (int ep = 0; ep < eWTTR_EP_END; ep++) {
+        const char *env = getenv (EndpointEnv[ep]);
+
+        if (!(EndpointSet[ep] = (env && endpoint_copy (ep, env))))
+            endpoint_copy (ep, EndpointDefault[ep]);
+    }
+}
+
+int wttr_set_endpoint (enum eWttrEndpoint ep, const char *base_url)
+{
+    int ret;
+
+    if ((int)ep < 0 || ep >= eWTTR_EP_END) return 0;
+
+    pthread_once (&EndpointOnce, endpoint_init);
+
+    pthread_mutex_lock (&EndpointLock);
+    if ((ret = endpoint_copy (ep, base_url ? base_url : EndpointDefault[ep])))
+        EndpointSet[ep] = (base_url != NULL);
+    pthread_mutex_unlock (&EndpointLock);
+    return ret;
+}
+
+int wttr_get_endpoint (enum eWttrEndpoint ep, char *buf, size_t size)
+{
+    if ((int)ep < 0 || ep >= eWTTR_EP_END || !buf || !size) return 0;
+
+    pthread_once (&EndpointOnce, endpoint_init);
+
+    pthread_mutex_lock (&EndpointLock);
+    snprintf (buf, size, "%s", Endpoint[ep]);
+    pthread_mutex_unlock (&EndpointLock);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// provider 요청 base URL : endpoint 를 설정하지 않았으면 provider 의 기본 base
+// (주 provider 를 open-meteo 로 바꾸면 wttr.in 이 아닌 open-meteo 로 요청)
+//------------------------------------------------------------------------------
+static int provider_base (enum eWttrEndpoint ep, const wttr_provider_t *prov, char *buf, size_t size)
+{
+    const char *base;
+    size_t len;
+
+    pthread_once (&EndpointOnce, endpoint_init);
+
+    pthread_mutex_lock (&EndpointLock);
+    base = (!EndpointSet[ep] && prov && prov->base) ? prov->base : Endpoint[ep];
+    for (len = strlen (base); len && base[len - 1] == '/'; len--)
+        ;
+    if (len < size) {
+        memcpy (buf, base, len);
+        buf[len] = '\0';
+    }
+    pthread_mutex_unlock (&EndpointLock);
+    return (len && len < size);
+}
+
+//------------------------------------------------------------------------------
+// wttr.in 요청 방식 (WTTR_FETCH_COMPRESS, WTTR_FETCH_LIGHT) 및 수신량 통계
+//------------------------------------------------------------------------------
+static pthread_mutex_t      FetchLock = PTHREAD_MUTEX_INITIALIZER;
+static int                  FetchMode = 0;      /* atomic 으로 접근 (fetch_mode_get) */
+static wttr_fetch_stats_t   FetchStats [WTTR_FETCH_MODE_CNT];
+
+static inline int fetch_mode_get (void)
+{
+    return __atomic_load_n (&FetchMode, __ATOMIC_RELAXED);
+}
+
+void wttr_set_fetch_mode (int mode)
+{
+    __atomic_store_n (&FetchMode, mode & (WTTR_FETCH_MODE_CNT - 1), __ATOMIC_RELAXED);
+}
+
+int wttr_get_fetch_mode (void)
+{
+    return fetch_mode_get ();
+}
+
+void wttr_fetch_get_stats (int mode, wttr_fetch_stats_t *stats)
+{
+    if (!stats || mode < 0 || mode >= WTTR_FETCH_MODE_CNT) return;
+
+    pthread_mutex_lock (&FetchLock);
+    memcpy (stats, &FetchStats[mode], sizeof(wttr_fetch_stats_t));
+    pthread_mutex_unlock (&FetchLock);
+}
+
+//------------------------------------------------------------------------------
+// 요청 방식에 따른 option 설정 (gzip/deflate 협상)
+//------------------------------------------------------------------------------
+static void fetch_setopt (CURL *curl, int mode)
+{
+    if (mode & WTTR_FETCH_COMPRESS)
+        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "gzip, deflate");
+}
+
+//------------------------------------------------------------------------------
+// 요청 완료 후 수신량 기록 (body = 압축 해제 후 크기)
+//------------------------------------------------------------------------------
+static void fetch_account (CURL *curl, int mode, size_t body)
+{
+    curl_off_t wire = 0;
+    long header = 0;
+
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &wire);
+    curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &header);
+
+    pthread_mutex_lock (&FetchLock);
+    FetchStats[mode].requests++;
+    FetchStats[mode].wire_bytes += (unsigned long long)wire + header;
+    FetchStats[mode].body_bytes += body;
+    pthread_mutex_unlock (&FetchLock);
+}
+
+//------------------------------------------------------------------------------
+// endpoint 별 요청 통계 (단계별 시간 histogram, 결과, 수신량)
+//------------------------------------------------------------------------------
+static pthread_mutex_t      StatsLock = PTHREAD_MUTEX_INITIALIZER;
+static wttr_req_stats_t     Stats [eWTTR_EP_END];
+static const unsigned int   HistBound [WTTR_HIST_CNT] = WTTR_HIST_BOUNDS_US;
+
+static const char *StatsEpName  [eWTTR_EP_END]  = { "weather", "location", "fallback" };
+static const char *StatsPhName  [eWTTR_PH_END]  = { "dns", "connect", "tls", "ttfb", "total", "parse" };
+static const char *StatsOutName [eWTTR_OUT_END] = { "ok", "net_error", "http_error", "parse_error" };
+
+static inline long long now_us (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void hist_add (wttr_hist_t *h, long long us)
+{
+    int i;
+
+    if (us < 0) us = 0;
+    for (i = 0; i < WTTR_HIST_CNT && (unsigned long long)us > HistBound[i]; i++)
+        ;
+    h->cnt++;
+    h->sum_us += us;
+    h->bucket[i]++;
+}
+
+//------------------------------------------------------------------------------
+// 최근 성공한 요청 시간 (endpoint 별 ring), hedge 요청 시점을 정하는 p95 계산용
+//------------------------------------------------------------------------------
+#define LAT_RING_SIZE       64
+#define LAT_MIN_SAMPLES     8       /* 표본이 이보다 적으면 p95 를 사용하지 않음 */
+
+static long long            LatRing [eWTTR_EP_END][LAT_RING_SIZE];
+static unsigned int         LatCnt  [eWTTR_EP_END];
+
+static int latency_cmp (const void *a, const void *b)
+{
+    long long x = *(const long long *)a, y = *(const long long *)b;
+
+    return (x > y) - (x < y);
+}
+
+//------------------------------------------------------------------------------
+// 최근 요청 시간의 p95 (us), 0 = 표본 부족 (StatsLock 상태에서 호출)
+//------------------------------------------------------------------------------
+static long long latency_p95 (int ep)
+{
+    long long s [LAT_RING_SIZE];
+    int n = LatCnt[ep] < LAT_RING_SIZE ? (int)LatCnt[ep] : LAT_RING_SIZE;
+
+    if (n < LAT_MIN_SAMPLES)
+        return 0;
+    memcpy (s, LatRing[ep], sizeof(long long) * n);
+    qsort (s, n, sizeof(long long), latency_cmp);
+    return s[(n * 95 + 99) / 100 - 1];
+}
+
+//------------------------------------------------------------------------------
+// 요청 완료시 기록 (StatsLock 없이 호출), 실패한 요청은 여기서 결과를 기록하고
+// 성공한 요청은 파싱 후 stats_parse 에서 기록함.
+//------------------------------------------------------------------------------
+static void stats_request (CURL *curl, int ep, CURLcode res)
+{
+    curl_off_t dns = 0, conn = 0, tls = 0, ttfb = 0, total = 0, rx = 0;
+    long header = 0, code = 0;
+
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T,    &dns);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T,       &conn);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T,    &tls);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &ttfb);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T,         &total);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T,      &rx);
+    curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE,          &header);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE,        &code);
+
+    pthread_mutex_lock (&StatsLock);
+    Stats[ep].requests++;
+    Stats[ep].rx_bytes += (unsigned long long)rx + header;
+
+    /* 각 시간은 요청 시작부터의 누적값 */
+    hist_add (&Stats[ep].phase[eWTTR_PH_DNS],     dns);
+    hist_add (&Stats[ep].phase[eWTTR_PH_CONNECT], conn > dns ? conn - dns : 0);
+    if (tls > 0)
+        hist_add (&Stats[ep].phase[eWTTR_PH_TLS], tls > conn ? tls - conn : 0);
+    if (res == CURLE_OK || ttfb > 0)
+        hist_add (&Stats[ep].phase[eWTTR_PH_TTFB], ttfb);
+    hist_add (&Stats[ep].phase[eWTTR_PH_TOTAL],   total);
+
+    if (res != CURLE_OK)
+        Stats[ep].outcome[code >= 400 ? eWTTR_OUT_HTTP : eWTTR_OUT_NET]++;
+    else
+        LatRing[ep][LatCnt[ep]++ % LAT_RING_SIZE] = total;
+    pthread_mutex_unlock (&StatsLock);
+}
+
+//------------------------------------------------------------------------------
+// 결과 없이 취소된 요청 (hedge 에서 늦은 요청), 취소할 때까지의 시간을 최근 요청 시간으로
+// 기록함 (실제 시간의 하한, 계속 늦어지는 provider 의 p95 가 낮게 유지되지 않도록)
+//------------------------------------------------------------------------------
+static void stats_cancel (int ep, long long us)
+{
+    pthread_mutex_lock (&StatsLock);
+    Stats[ep].requests++;
+    LatRing[ep][LatCnt[ep]++ % LAT_RING_SIZE] = us;
+    pthread_mutex_unlock (&StatsLock);
+}
+
+//------------------------------------------------------------------------------
+// 파싱 결과 기록 (us < 0 = 파싱 시간 없음)
+//------------------------------------------------------------------------------
+static void stats_parse (int ep, long long us, int ok)
+{
+    pthread_mutex_lock (&StatsLock);
+    if (us >= 0)
+        hist_add (&Stats[ep].phase[eWTTR_PH_PARSE], us);
+    Stats[ep].outcome[ok ? eWTTR_OUT_OK : eWTTR_OUT_PARSE]++;
+    pthread_mutex_unlock (&StatsLock);
+}
+
+void wttr_stats_get (enum eWttrEndpoint ep, wttr_req_stats_t *stats)
+{
+    if (!stats || (int)ep < 0 || ep >= eWTTR_EP_END) return;
+
+    pthread_mutex_lock (&StatsLock);
+    memcpy (stats, &Stats[ep], sizeof(wttr_req_stats_t));
+    stats->recent_p95_us = latency_p95 (ep);
+    pthread_mutex_unlock (&StatsLock);
+}
+
+void wttr_stats_reset (void)
+{
+    pthread_mutex_lock (&StatsLock);
+    memset (Stats,  0, sizeof(Stats));
+    memset (LatCnt, 0, sizeof(LatCnt));
+    pthread_mutex_unlock (&StatsLock);
+}
+
+//------------------------------------------------------------------------------
+// 요청 시간 budget : 호출 단위 만료 시간 (thread 별)
+// 안쪽 호출(update 중의 위치 요청 등)은 바깥 호출의 만료 시간을 넘지 않음.
+//------------------------------------------------------------------------------
+static int                  BudgetMs = WTTR_BUDGET_MS;
+static __thread long long   Deadline;           /* now_us 기준 만료 시간, 0 = 없음 */
+
+void wttr_set_budget (int budget_ms)
+{
+    BudgetMs = (budget_ms > 0) ? budget_ms : WTTR_BUDGET_MS;
+}
+
+//------------------------------------------------------------------------------
+// budget 시작 (budget_ms <= 0 이면 기본값), 반환값 = 이전 만료 시간 (deadline_leave 에 전달)
+//------------------------------------------------------------------------------
+static long long deadline_enter (int budget_ms)
+{
+    long long prev = Deadline;
+    long long end  = now_us () + (long long)(budget_ms > 0 ? budget_ms : BudgetMs) * 1000LL;
+
+    if (!prev || end < prev)
+        Deadline = end;
+    return prev;
+}
+
+static void deadline_leave (long long prev)
+{
+    Deadline = prev;
+}
+
+//------------------------------------------------------------------------------
+// 남은 시간 (us), budget 을 시작하지 않은 호출은 기본 budget
+//------------------------------------------------------------------------------
+static long long deadline_left (void)
+{
+    return Deadline ? Deadline - now_us () : BudgetMs * 1000LL;
+}
+
+//------------------------------------------------------------------------------
+// 남은 시간을 cURL timeout 으로 설정 (연결부터 수신 완료까지)
+//------------------------------------------------------------------------------
+static void deadline_setopt (CURL *curl, long long left_us)
+{
+    long ms = (long)(left_us / 1000);
+
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, ms > 0 ? ms : 1L);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// upstream 보호 : endpoint 별 token bucket, 재시도(backoff), circuit breaker
+// 모든 요청(동기, 비동기, background 갱신)은 보내기 전에 gate_admit 으로 허가를 받고
+// 완료 후 gate_result 로 결과를 알림. 재시도도 다시 허가를 받으므로 요청 제한을 넘지 않음.
+//------------------------------------------------------------------------------
+#define GATE_REJECTED   (-1LL)
+
+struct gate {
+    /* token bucket (rate = 0 이면 제한없음), tokens 가 음수이면 예약된 대기 요청 */
+    double      rate;
+    int         burst, max_wait_ms;
+    double      tokens;
+    long long   last_us;
+    /* 재시도 */
+    int         retries, base_ms, max_ms;
+    /* circuit breaker (threshold = 0 이면 사용안함) */
+    int         threshold, open_ms;
+    int         state, failures;
+    long long   open_until, probe_us;   /* probe_us = half-open 상태에서 보낸 요청 시간 */
+};
+
+static pthread_mutex_t  GateLock = PTHREAD_MUTEX_INITIALIZER;
+static struct gate      Gate [eWTTR_EP_END] = {
+    /* weather  : 요청 제한 없음 */
+    { .rate = 0, .burst = 1, .max_wait_ms = 0,
+      .retries = 2, .base_ms = 200,  .max_ms = 2000, .threshold = 5, .open_ms = 30000 },
+    /* location : nominatim 정책 (초당 1회), token 은 최대 5초 기다림 */
+    { .rate = 1, .burst = 1, .max_wait_ms = 5000,
+      .retries = 2, .base_ms = 1000, .max_ms = 4000, .threshold = 5, .open_ms = 60000 },
+    /* fallback : hedge 요청은 재시도하지 않음 (주 provider 와 동시에 진행) */
+    { .rate = 0, .burst = 1, .max_wait_ms = 0,
+      .retries = 0, .base_ms = 200,  .max_ms = 2000, .threshold = 5, .open_ms = 30000 },
+};
+
+static const char *GateStateName [] = { "closed", "open", "half_open" };
+
+static void sleep_us (long long us)
+{
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000 };
+
+    while (us > 0 && nanosleep (&ts, &ts) && errno == EINTR)
+        ;
+}
+
+//------------------------------------------------------------------------------
+// 요청 허가, 반환값 = 보내기 전에 기다릴 시간 (us), GATE_REJECTED = 보내지 않음
+// circuit 이 열려 있거나 token 을 max_wait_ms 또는 남은 시간(left_us) 안에 받을 수 없으면
+// 거부함.
+//------------------------------------------------------------------------------
+static long long gate_admit (int ep, long long left_us)
+{
+    struct gate *g = &Gate[ep];
+    long long now = now_us (), wait = 0;
+    int reject = 0;
+
+    pthread_mutex_lock (&GateLock);
+    /* open 시간이 지나면 한 요청만 보내 확인 (응답이 없는 probe 는 open_ms 후 다시 보냄) */
+    if (g->state == eWTTR_BREAKER_OPEN && now >= g->open_until) {
+        g->state    = eWTTR_BREAKER_HALF_OPEN;
+        g->probe_us = 0;
+    }
+    if (g->state == eWTTR_BREAKER_OPEN ||
+        (g->state == eWTTR_BREAKER_HALF_OPEN && g->probe_us && now - g->probe_us < g->open_ms * 1000LL)) {
+        reject = eWTTR_BREAKER_OPEN;
+    }
+    else if (left_us <= 0) {
+        reject = -2;
+    }
+    else if (g->rate > 0) {
+        g->tokens  = g->last_us ? fmin (g->burst, g->tokens + (now - g->last_us) * g->rate / 1e6)
+                                : g->burst;
+        g->last_us = now;
+        /* token 이 없으면 먼저 예약하고 채워질 때까지 기다림 (요청 순서대로 보냄) */
+        if (g->tokens < 1)
+            wait = (long long)((1 - g->tokens) * 1e6 / g->rate);
+        if (wait > g->max_wait_ms * 1000LL)
+            reject = -1;
+        else if (wait >= left_us)
+            reject = -2;
+        else
+            g->tokens -= 1;
+    }
+    if (!reject && g->state == eWTTR_BREAKER_HALF_OPEN)
+        g->probe_us = now;
+    pthread_mutex_unlock (&GateLock);
+
+    pthread_mutex_lock (&StatsLock);
+    if (reject > 0)         Stats[ep].breaker_rejected++;
+    else if (reject == -2)  Stats[ep].deadline_exceeded++;
+    else if (reject)        Stats[ep].rate_rejected++;
+    else if (wait) {
+        Stats[ep].queued++;
+        Stats[ep].queue_wait_us += wait;
+    }
+    pthread_mutex_unlock (&StatsLock);
+    return reject ? GATE_REJECTED : wait;
+}
+
+//------------------------------------------------------------------------------
+// upstream 오류 여부 (연결 오류, timeout, 429, 5xx), 4xx 등 요청 자체의 오류는 제외
+//------------------------------------------------------------------------------
+static int gate_failure (CURL *curl, CURLcode res)
+{
+    long code = 0;
+
+    switch (res) {
+        case CURLE_HTTP_RETURNED_ERROR:
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+            return (code == 429 || code >= 500);
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_PARTIAL_FILE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+// 요청 결과, 연속 threshold 번 실패하거나 half-open 확인 요청이 실패하면 open
+//------------------------------------------------------------------------------
+static void gate_result (int ep, int ok)
+{
+    struct gate *g = &Gate[ep];
+    int opened = 0;
+
+    pthread_mutex_lock (&GateLock);
+    g->probe_us = 0;
+    if (ok) {
+        g->failures = 0;
+        g->state    = eWTTR_BREAKER_CLOSED;
+    }
+    else if (g->threshold > 0 &&
+             (g->state == eWTTR_BREAKER_HALF_OPEN || ++g->failures >= g->threshold)) {
+        g->state      = eWTTR_BREAKER_OPEN;
+        g->open_until = now_us () + g->open_ms * 1000LL;
+        g->failures   = 0;
+        opened = 1;
+    }
+    pthread_mutex_unlock (&GateLock);
+
+    if (opened) {
+        pthread_mutex_lock   (&StatsLock);
+        Stats[ep].breaker_opened++;
+        pthread_mutex_unlock (&StatsLock);
+    #if defined (__LIB_WEATHER_DEBUG__)
+        fprintf (stderr, "%s : %s circuit open\n", __func__, StatsEpName[ep]);
+    #endif
+    }
+}
+
+//------------------------------------------------------------------------------
+// 결과 없이 취소된 요청 (hedge 에서 늦은 요청), half-open 확인 요청이었으면 다음 요청이 확인
+//------------------------------------------------------------------------------
+static void gate_cancel (int ep)
+{
+    pthread_mutex_lock   (&GateLock);
+    Gate[ep].probe_us = 0;
+    pthread_mutex_unlock (&GateLock);
+}
+
+//------------------------------------------------------------------------------
+// 재시도 대기 시간 (us), attempt = 지금까지 재시도한 횟수, GATE_REJECTED = 재시도 안함
+// base_ms * 2^attempt (max_ms 까지) 의 50~100% 를 random 으로 기다림 (동시 재시도 분산)
+// 서버가 Retry-After 를 보내면 그 시간 이상 기다리고 max_ms 보다 길면 재시도 안함.
+// 기다린 뒤 남은 시간(left_us)이 없으면 재시도 안함.
+//------------------------------------------------------------------------------
+static long long gate_backoff (int ep, CURL *curl, int attempt, long long left_us)
+{
+    static __thread unsigned int seed;
+    struct gate *g = &Gate[ep];
+    long long delay, wait;
+    int retries, base_ms, max_ms;
+
+    pthread_mutex_lock (&GateLock);
+    retries = g->retries;
+    base_ms = g->base_ms;
+    max_ms  = g->max_ms;
+    pthread_mutex_unlock (&GateLock);
+
+    if (attempt >= retries)
+        return GATE_REJECTED;
+
+    if (!seed)
+        seed = (unsigned int)now_us () ^ (unsigned int)(uintptr_t)&seed;
+
+    delay = (long long)base_ms * 1000LL << (attempt < 16 ? attempt : 16);
+    if (delay > max_ms * 1000LL)
+        delay = max_ms * 1000LL;
+    wait = delay / 2 + rand_r (&seed) % (delay / 2 + 1);
+
+#if LIBCURL_VERSION_NUM >= 0x074200
+    {
+        curl_off_t after = 0;
+
+        if (curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &after) == CURLE_OK && after > 0) {
+            if (after * 1000LL > max_ms)
+                return GATE_REJECTED;
+            if (after * 1000000LL > wait)
+                wait = after * 1000000LL;
+        }
+    }
+#else
+    (void)curl;
+#endif
+
+    pthread_mutex_lock   (&StatsLock);
+    if (wait >= left_us)    Stats[ep].deadline_exceeded++;
+    else                    Stats[ep].retries++;
+    pthread_mutex_unlock (&StatsLock);
+    return (wait >= left_us) ? GATE_REJECTED : wait;
+}
+
+//------------------------------------------------------------------------------
+// 요청 실패시 cache 값으로 응답한 경우
+//------------------------------------------------------------------------------
+static void stats_cached (int ep)
+{
+    pthread_mutex_lock   (&StatsLock);
+    Stats[ep].served_cached++;
+    pthread_mutex_unlock (&StatsLock);
+}
+
+//------------------------------------------------------------------------------
+// 설정 (endpoint 별), 반환값 = 1(성공) / 0(잘못된 값)
+//------------------------------------------------------------------------------
+int wttr_rate_config (enum eWttrEndpoint ep, double rate, int burst, int max_wait_ms)
+{
+    if ((int)ep < 0 || ep >= eWTTR_EP_END || rate < 0)
+        return 0;
+
+    pthread_mutex_lock   (&GateLock);
+    Gate[ep].rate        = rate;
+    Gate[ep].burst       = (burst > 0) ? burst : 1;
+    Gate[ep].max_wait_ms = (max_wait_ms > 0) ? max_wait_ms : 0;
+    Gate[ep].last_us     = 0;
+    pthread_mutex_unlock (&GateLock);
+    return 1;
+}
+
+int wttr_retry_config (enum eWttrEndpoint ep, int retries, int base_ms, int max_ms)
+{
+    if ((int)ep < 0 || ep >= eWTTR_EP_END || retries < 0 || base_ms <= 0 || max_ms < base_ms)
+        return 0;
+
+    pthread_mutex_lock   (&GateLock);
+    Gate[ep].retries = retries;
+    Gate[ep].base_ms = base_ms;
+    Gate[ep].max_ms  = max_ms;
+    pthread_mutex_unlock (&GateLock);
+    return 1;
+}
+
+int wttr_breaker_config (enum eWttrEndpoint ep, int threshold, int open_ms)
+{
+    if ((int)ep < 0 || ep >= eWTTR_EP_END || threshold < 0 || open_ms <= 0)
+        return 0;
+
+    pthread_mutex_lock   (&GateLock);
+    Gate[ep].threshold = threshold;
+    Gate[ep].open_ms   = open_ms;
+    Gate[ep].failures  = 0;
+    Gate[ep].state     = eWTTR_BREAKER_CLOSED;
+    pthread_mutex_unlock (&GateLock);
+    return 1;
+}
+
+int wttr_breaker_state (enum eWttrEndpoint ep)
+{
+    int state;
+
+    if ((int)ep < 0 || ep >= eWTTR_EP_END)
+        return eWTTR_BREAKER_CLOSED;
+
+    pthread_mutex_lock   (&GateLock);
+    state = Gate[ep].state;
+    /* open 시간이 지났으면 다음 요청은 half-open 확인 요청 */
+    if (state == eWTTR_BREAKER_OPEN && now_us () >= Gate[ep].open_until)
+        state = eWTTR_BREAKER_HALF_OPEN;
+    pthread_mutex_unlock (&GateLock);
+    return state;
+}
+
+//------------------------------------------------------------------------------
+// Prometheus text 형식 출력
+//------------------------------------------------------------------------------
+struct dump_buf {
+    char    *buf;
+    size_t  size, len;
+};
+
+static void dump_printf (struct dump_buf *d, const char *fmt, ...)
+    __attribute__ ((format (printf, 2, 3)));
+
+static void dump_printf (struct dump_buf *d, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start (ap, fmt);
+    n = vsnprintf (d->len < d->size ? d->buf + d->len : NULL,
+                   d->len < d->size ? d->size - d->len : 0, fmt, ap);
+    va_end (ap);
+    if (n > 0)  d->len += n;
+}
+
+int wttr_stats_dump (char *buf, size_t size)
+{
+    struct dump_buf d = { buf, buf ? size : 0, 0 };
+    wttr_req_stats_t st [eWTTR_EP_END];
+    wttr_cache_stats_t cs [2];
+    const char *cs_name [2] = { "weather", "location" };
+
+    pthread_mutex_lock (&StatsLock);
+    memcpy (st, Stats, sizeof(st));
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        st[ep].recent_p95_us = latency_p95 (ep);
+    pthread_mutex_unlock (&StatsLock);
+    wttr_cache_get_stats     (&cs[0]);
+    wttr_geo_cache_get_stats (&cs[1]);
+
+    dump_printf (&d, "# HELP wttr_requests_total HTTP requests sent.\n"
+                     "# TYPE wttr_requests_total counter\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        dump_printf (&d, "wttr_requests_total{endpoint=\"%s\"} %llu\n",
+                     StatsEpName[ep], st[ep].requests);
+
+    dump_printf (&d, "# HELP wttr_received_bytes_total Response header and body bytes received.\n"
+                     "# TYPE wttr_received_bytes_total counter\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        dump_printf (&d, "wttr_received_bytes_total{endpoint=\"%s\"} %llu\n",
+                     StatsEpName[ep], st[ep].rx_bytes);
+
+    dump_printf (&d, "# HELP wttr_coalesced_total Calls served by an identical request in flight.\n"
+                     "# TYPE wttr_coalesced_total counter\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        dump_printf (&d, "wttr_coalesced_total{endpoint=\"%s\"} %llu\n",
+                     StatsEpName[ep], st[ep].coalesced);
+
+    dump_printf (&d, "# HELP wttr_retries_total Requests retried after an upstream error.\n"
+                     "# TYPE wttr_retries_total counter\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        dump_printf (&d, "wttr_retries_total{endpoint=\"%s\"} %llu\n",
+                     StatsEpName[ep], st[ep].retries);
+
+    dump_printf (&d, "# HELP wttr_queued_total Requests delayed by the rate limiter.\n"
+                     "# TYPE wttr_queued_total counter\n"
+                     "# HELP wttr_queue_wait_seconds_total Time spent waiting for the rate limiter.\n"
+                     "# TYPE wttr_queue_wait_seconds_total counter\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        dump_printf (&d, "wttr_queued_total{endpoint=\"%s\"} %llu\n"
+                         "wttr_queue_wait_seconds_total{endpoint=\"%s\"} %.6f\n",
+                     StatsEpName[ep], st[ep].queued, StatsEpName[ep], st[ep].queue_wait_us / 1e6);
+
+    dump_printf (&d, "# HELP wttr_rejected_total Requests not sent (rate limit wait too long, circuit open).\n"
+                     "# TYPE wttr_rejected_total counter\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        dump_printf (&d, "wttr_rejected_total{endpoint=\"%s\",reason=\"rate\"} %llu\n"
+                         "wttr_rejected_total{endpoint=\"%s\",reason=\"breaker\"} %llu\n",
+                     StatsEpName[ep], st[ep].rate_rejected, StatsEpName[ep], st[ep].breaker_rejected);
+
+    dump_printf (&d, "# HELP wttr_deadline_exceeded_total Requests or retries skipped for lack of time budget.\n"
+                     "# TYPE wttr_deadline_exceeded_total counter\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        dump_printf (&d, "wttr_deadline_exceeded_total{endpoint=\"%s\"} %llu\n",
+                     StatsEpName[ep], st[ep].deadline_exceeded);
+
+    dump_printf (&d, "# HELP wttr_hedge_wins_total Hedged requests whose response was used.\n"
+                     "# TYPE wttr_hedge_wins_total counter\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        dump_printf (&d, "wttr_hedge_wins_total{endpoint=\"%s\"} %llu\n",
+                     StatsEpName[ep], st[ep].hedge_wins);
+
+    dump_printf (&d, "# HELP wttr_recent_p95_seconds p95 of recent successful request times (hedge delay).\n"
+                     "# TYPE wttr_recent_p95_seconds gauge\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        dump_printf (&d, "wttr_recent_p95_seconds{endpoint=\"%s\"} %.6f\n",
+                     StatsEpName[ep], st[ep].recent_p95_us / 1e6);
+
+    dump_printf (&d, "# HELP wttr_breaker_opened_total Circuit breaker trips.\n"
+                     "# TYPE wttr_breaker_opened_total counter\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        dump_printf (&d, "wttr_breaker_opened_total{endpoint=\"%s\"} %llu\n",
+                     StatsEpName[ep], st[ep].breaker_opened);
+
+    dump_printf (&d, "# HELP wttr_breaker_state Circuit breaker state (1 = current state).\n"
+                     "# TYPE wttr_breaker_state gauge\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++) {
+        int state = wttr_breaker_state (ep);
+
+        for (int b = eWTTR_BREAKER_CLOSED; b <= eWTTR_BREAKER_HALF_OPEN; b++)
+            dump_printf (&d, "wttr_breaker_state{endpoint=\"%s\",state=\"%s\"} %d\n",
+                         StatsEpName[ep], GateStateName[b], state == b);
+    }
+
+    dump_printf (&d, "# HELP wttr_served_cached_total Failed requests answered from cached data.\n"
+                     "# TYPE wttr_served_cached_total counter\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        dump_printf (&d, "wttr_served_cached_total{endpoint=\"%s\"} %llu\n",
+                     StatsEpName[ep], st[ep].served_cached);
+
+    dump_printf (&d, "# HELP wttr_results_total Request results.\n"
+                     "# TYPE wttr_results_total counter\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++)
+        for (int o = 0; o < eWTTR_OUT_END; o++)
+            dump_printf (&d, "wttr_results_total{endpoint=\"%s\",result=\"%s\"} %llu\n",
+                         StatsEpName[ep], StatsOutName[o], st[ep].outcome[o]);
+
+    dump_printf (&d, "# HELP wttr_phase_seconds Request phase durations.\n"
+                     "# TYPE wttr_phase_seconds histogram\n");
+    for (int ep = 0; ep < eWTTR_EP_END; ep++) {
+        for (int ph = 0; ph < eWTTR_PH_END; ph++) {
+            const wttr_hist_t *h = &st[ep].phase[ph];
+            unsigned long long acc = 0;
+
+            for (int i = 0; i < WTTR_HIST_CNT; i++) {
+                acc += h->bucket[i];
+                dump_printf (&d, "wttr_phase_seconds_bucket{endpoint=\"%s\",phase=\"%s\",le=\"%g\"} %llu\n",
+                             StatsEpName[ep], StatsPhName[ph], HistBound[i] / 1e6, acc);
+            }
+            dump_printf (&d, "wttr_phase_seconds_bucket{endpoint=\"%s\",phase=\"%s\",le=\"+Inf\"} %llu\n"
+                             "wttr_phase_seconds_sum{endpoint=\"%s\",phase=\"%s\"} %.6f\n"
+                             "wttr_phase_seconds_count{endpoint=\"%s\",phase=\"%s\"} %llu\n",
+                         StatsEpName[ep], StatsPhName[ph], h->cnt,
+                         StatsEpName[ep], StatsPhName[ph], h->sum_us / 1e6,
+                         StatsEpName[ep], StatsPhName[ph], h->cnt);
+        }
+    }
+
+    dump_printf (&d, "# HELP wttr_cache_lookups_total Response/geocode cache lookups.\n"
+                     "# TYPE wttr_cache_lookups_total counter\n");
+    for (int c = 0; c < 2; c++)
+        dump_printf (&d, "wttr_cache_lookups_total{cache=\"%s\",result=\"hit\"} %lu\n"
+                         "wttr_cache_lookups_total{cache=\"%s\",result=\"miss\"} %lu\n"
+                         "wttr_cache_lookups_total{cache=\"%s\",result=\"stale\"} %lu\n",
+                     cs_name[c], cs[c].hit, cs_name[c], cs[c].miss, cs_name[c], cs[c].stale);
+
+    return (int)d.len;
+}
+
+//------------------------------------------------------------------------------
+// 파일로 저장 (임시 파일에 쓴 뒤 rename, 읽는 쪽에서 중간 상태를 보지 않음)
+//------------------------------------------------------------------------------
+int wttr_stats_dump_file (const char *path)
+{
+    char *buf = NULL, *tmp;
+    size_t size;
+    int len, ret = 0;
+    FILE *fp;
+
+    if (!path || (len = wttr_stats_dump (NULL, 0)) <= 0)
+        return 0;
+
+    /* dump 사이에 늘어날 수 있으므로 여유를 두고, 그래도 잘렸으면 늘려서 다시 dump */
+    do {
+        char *p;
+
+        size = (size_t)len + 1024;
+        if (!(p = realloc (buf, size))) {
+            free (buf);
+            return 0;
+        }
+        buf = p;
+    } while ((len = wttr_stats_dump (buf, size)) >= 0 && (size_t)len >= size);
+
+    if (!(tmp = malloc (strlen (path) + 8))) {
+        free (buf);
+        return 0;
+    }
+    sprintf (tmp, "%s.tmp", path);
+
+    if ((fp = fopen (tmp, "w")) != NULL) {
+        ret = (fwrite (buf, 1, len, fp) == (size_t)len);
+        ret = !fclose (fp) && ret && !rename (tmp, path);
+        if (!ret)   remove (tmp);
+    }
+    free (tmp);
+    free (buf);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// 지역 registry (location interning)
+// 입력 지역을 한번만 정규화하여 등록하고 작은 정수 handle 을 돌려줌 (길이 제한 없음).
+// 등록할 때 url 인코딩된 요청 path 를 미리 만들어 두므로 갱신시에는 base URL 만 붙임.
+// handle 은 요청 합치기, 응답 cache, context validator, snapshot 의 key 로 사용됨.
+// 항목은 page 단위로 할당되어 주소가 바뀌지 않고 삭제하지 않으므로 조회는 lock 없이 가능.
+//------------------------------------------------------------------------------
+#define LOC_PAGE_SIZE   256
+#define LOC_PAGE_MAX    256             /* 최대 65536 지역 */
+#define LOC_HASH_SIZE   4096
+#define LOC_COORD_SCALE 10000           /* "위도,경도" 는 소수점 4자리(약 11m)로 반올림 */
+#define LOC_COORD_SIZE  32
+
+struct loc_entry {
+    int             hnext;              /* hash chain (handle + 1, 0 = 끝) */
+    unsigned int    hash;
+    char            *key;               /* 정규화된 지역 */
+    char            *path     [2];      /* 인코딩된 요청 path (j1, j2) */
+    size_t          path_len  [2];
+};
+
+static pthread_mutex_t  LocLock = PTHREAD_MUTEX_INITIALIZER;
+static struct loc_entry *LocPage [LOC_PAGE_MAX];
+static int              LocHash [LOC_HASH_SIZE];    /* handle + 1, 0 = 없음 */
+static int              LocCnt  = 0;                /* release 로 게시 */
+
+static const struct loc_entry *loc_get (wttr_loc_t loc)
+{
+    if (loc < 0 || loc >= __atomic_load_n (&LocCnt, __ATOMIC_ACQUIRE))
+        return NULL;
+    return &LocPage[loc / LOC_PAGE_SIZE][loc % LOC_PAGE_SIZE];
+}
+
+//------------------------------------------------------------------------------
+// "위도,경도" 이면 반올림한 좌표를 buf 에 저장 (끝의 0 은 제거, 소수점은 항상 '.')
+//------------------------------------------------------------------------------
+static int loc_coord_key (const char *location, char *buf, size_t size)
+{
+    double v[2];
+    char c, *p = buf, *end = buf + size;
+
+    if (!strchr (location, ',') || sscanf (location, "%lf ,%lf %c", &v[0], &v[1], &c) != 2 ||
+        !isfinite (v[0]) || !isfinite (v[1]) || fabs (v[0]) > 90 || fabs (v[1]) > 180)
+        return 0;
+
+    for (int i = 0; i < 2; i++) {
+        long long n = llround (v[i] * LOC_COORD_SCALE);
+        int frac = (int)(llabs (n) % LOC_COORD_SCALE), digits = 4;
+
+        p += snprintf (p, end - p, "%s%s%lld", i ? "," : "", n < 0 ? "-" : "",
+                       llabs (n) / LOC_COORD_SCALE);
+        if (!frac)  continue;
+        while (!(frac % 10)) { frac /= 10; digits--; }
+        p += snprintf (p, end - p, ".%0*d", digits, frac);
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 지역명 정규화 : 앞/뒤 공백 제거, 연속된 공백은 하나로, 영문은 소문자
+// key = strlen(location) + 1 이상의 buffer
+//------------------------------------------------------------------------------
+static void loc_name_key (const char *location, char *key)
+{
+    int space = 0;
+
+    while (isspace ((unsigned char)*location)) location++;
+
+    for (; *location; location++) {
+        unsigned char c = (unsigned char)*location;
+
+        if (isspace (c)) { space = 1; continue; }
+        if (space) { *key++ = ' '; space = 0; }
+        *key++ = (c < 0x80) ? tolower (c) : c;
+    }
+    *key = '\0';
+}
+
+//------------------------------------------------------------------------------
+// 새 항목 등록 (LocLock 상태에서 호출), 요청 path 를 미리 인코딩함
+//------------------------------------------------------------------------------
+static wttr_loc_t loc_insert (const char *key, size_t len, unsigned int hash)
+{
+    const char *fmt [2] = { WEATHER_URL_PATH, WEATHER_URL_PATH_LIGHT };
+    struct loc_entry *e;
+    wttr_loc_t loc = LocCnt;
+    char *enc;
+
+    if (loc >= LOC_PAGE_MAX * LOC_PAGE_SIZE)
+        return WTTR_LOC_INVALID;
+    if (!LocPage[loc / LOC_PAGE_SIZE] &&
+        !(LocPage[loc / LOC_PAGE_SIZE] = calloc (LOC_PAGE_SIZE, sizeof(struct loc_entry))))
+        return WTTR_LOC_INVALID;
+
+    e = &LocPage[loc / LOC_PAGE_SIZE][loc % LOC_PAGE_SIZE];
+    if (!(enc = url_encode (key)) || !(e->key = malloc (len + 1)))
+        goto err;
+    memcpy (e->key, key, len + 1);
+
+    for (int i = 0; i < 2; i++) {
+        int n = snprintf (NULL, 0, fmt[i], enc);
+
+        if (n < 0 || !(e->path[i] = malloc (n + 1)))
+            goto err;
+        snprintf (e->path[i], n + 1, fmt[i], enc);
+        e->path_len[i] = n;
+    }
+    free (enc);
+
+    e->hash  = hash;
+    e->hnext = LocHash[hash % LOC_HASH_SIZE];
+    LocHash[hash % LOC_HASH_SIZE] = loc + 1;
+    __atomic_store_n (&LocCnt, loc + 1, __ATOMIC_RELEASE);
+    return loc;
+err:
+    free (enc);
+    free (e->key);
+    free (e->path[0]);
+    free (e->path[1]);
+    memset (e, 0, sizeof(struct loc_entry));
+    return WTTR_LOC_INVALID;
+}
+
+wttr_loc_t wttr_loc_intern (const char *location)
+{
+    char coord [LOC_COORD_SIZE], sbuf [256], *key = sbuf;
+    unsigned int hash;
+    size_t len;
+    wttr_loc_t loc;
+
+    if (!location) location = "";
+
+    if (loc_coord_key (location, coord, sizeof(coord))) {
+        key = coord;
+    } else {
+        if (strlen (location) >= sizeof(sbuf) && !(key = malloc (strlen (location) + 1)))
+            return WTTR_LOC_INVALID;
+        loc_name_key (location, key);
+    }
+    len  = strlen (key);
+    hash = (unsigned int)payload_hash (PAYLOAD_HASH_INIT, key, len);
+
+    pthread_mutex_lock (&LocLock);
+    for (loc = LocHash[hash % LOC_HASH_SIZE] - 1; loc >= 0; ) {
+        const struct loc_entry *e = &LocPage[loc / LOC_PAGE_SIZE][loc % LOC_PAGE_SIZE];
+
+        if (e->hash == hash && !strcmp (e->key, key))
+            break;
+        loc = e->hnext - 1;
+    }
+    if (loc < 0)
+        loc = loc_insert (key, len, hash);
+    pthread_mutex_unlock (&LocLock);
+
+    if (key != coord && key != sbuf)
+        free (key);
+    return loc;
+}
+
+wttr_loc_t wttr_loc_coord (double lat, double lon)
+{
+    char location [LOC_COORD_SIZE * 2];
+
+    snprintf (location, sizeof(location), "%.6f,%.6f", lat, lon);
+    return wttr_loc_intern (location);
+}
+
+const char *wttr_loc_key (wttr_loc_t loc)
+{
+    const struct loc_entry *e = loc_get (loc);
+
+    return e ? e->key : NULL;
+}
+
+//------------------------------------------------------------------------------
+// 날씨 요청 URL (base URL + 미리 인코딩한 path)
+// url 크기가 부족하면 할당하여 반환 (반환값 != url 이면 호출한 곳에서 free), 실패 = NULL
+//------------------------------------------------------------------------------
+static char *loc_url (const struct loc_entry *e, int fetch_mode, char *url, size_t size)
+{
+    int light = (fetch_mode & WTTR_FETCH_LIGHT) ? 1 : 0;
+    char base [WTTR_URL_BASE_SIZE];
+    size_t blen;
+
+    if (!e || !wttr_get_endpoint (eWTTR_EP_WEATHER, base, sizeof(base)))
+        return NULL;
+
+    blen = strlen (base);
+    if (blen + e->path_len[light] + 1 > size && !(url = malloc (blen + e->path_len[light] + 1)))
+        return NULL;
+    memcpy (url, base, blen);
+    memcpy (url + blen, e->path[light], e->path_len[light] + 1);
+    return url;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// 같은 요청 합치기 (singleflight)
+// 같은 key 의 요청이 진행중이면 새 요청을 보내지 않고 그 결과를 기다림.
+// 결과(result)는 마지막으로 flight_leave 한 caller 가 free_fn 으로 해제함.
+//------------------------------------------------------------------------------
+enum {
+    FLIGHT_WEATHER_JSON = 0,    /* get_weather_json */
+    FLIGHT_WEATHER_DATA,        /* wttr_fetch_data (+ ParseMode) */
+    FLIGHT_LOCATION = FLIGHT_WEATHER_DATA + 2,
+};
+
+struct flight {
+    struct flight   *next;
+    int             kind;
+    char            *key;
+    int             refs;       /* 요청한 caller + 기다리는 caller */
+    int             done;
+    int             ret;
+    void            *result;
+    pthread_cond_t  cond;
+};
+
+static pthread_mutex_t  FlightLock = PTHREAD_MUTEX_INITIALIZER;
+static struct flight    *Flights   = NULL;
+
+static void stats_coalesced (int ep)
+{
+    pthread_mutex_lock (&StatsLock);
+    Stats[ep].coalesced++;
+    pthread_mutex_unlock (&StatsLock);
+}
+
+//------------------------------------------------------------------------------
+// 진행중인 요청이 있으면 끝날때까지 기다린 뒤 반환 (*leader = 0),
+// 없으면 새로 등록하고 반환 (*leader = 1, 요청 후 flight_done 호출).
+// 등록할 메모리가 없으면 NULL (*leader = 1, 합치지 않고 요청).
+//------------------------------------------------------------------------------
+static struct flight *flight_join (int kind, const char *key, int *leader)
+{
+    struct flight *f;
+
+    pthread_mutex_lock (&FlightLock);
+    for (f = Flights; f; f = f->next)
+        if (f->kind == kind && !strcmp (f->key, key))
+            break;
+
+    if (f) {
+        f->refs++;
+        while (!f->done)
+            pthread_cond_wait (&f->cond, &FlightLock);
+        pthread_mutex_unlock (&FlightLock);
+
+        stats_coalesced (kind == FLIGHT_LOCATION ? eWTTR_EP_LOCATION : eWTTR_EP_WEATHER);
+        *leader = 0;
+        return f;
+    }
+
+    *leader = 1;
+    if ((f = calloc (1, sizeof(struct flight))) != NULL) {
+        if ((f->key = strdup (key)) != NULL) {
+            f->kind = kind;
+            f->refs = 1;
+            pthread_cond_init (&f->cond, NULL);
+            f->next = Flights;
+            Flights = f;
+        } else {
+            free (f);
+            f = NULL;
+        }
+    }
+    pthread_mutex_unlock (&FlightLock);
+    return f;
+}
+
+//------------------------------------------------------------------------------
+// 결과 등록 및 기다리는 caller 깨움 (이후 요청은 새 flight 를 시작함)
+//------------------------------------------------------------------------------
+static void flight_done (struct flight *f, int ret, void *result)
+{
+    struct flight **pp;
+
+    pthread_mutex_lock (&FlightLock);
+    for (pp = &Flights; *pp; pp = &(*pp)->next) {
+        if (*pp == f) {
+            *pp = f->next;
+            break;
+        }
+    }
+    f->ret    = ret;
+    f->result = result;
+    f->done   = 1;
+    pthread_cond_broadcast (&f->cond);
+    pthread_mutex_unlock (&FlightLock);
+}
+
+static void flight_leave (struct flight *f, void (*free_fn)(void *))
+{
+    int last;
+
+    pthread_mutex_lock (&FlightLock);
+    last = (--f->refs == 0);
+    pthread_mutex_unlock (&FlightLock);
+
+    if (last) {
+        if (free_fn)    free_fn (f->result);
+        pthread_cond_destroy (&f->cond);
+        free (f->key);
+        free (f);
+    }
+}
+
+//------------------------------------------------------------------------------
+// 공통 요청 option 설정
+//------------------------------------------------------------------------------
+static void http_setopt (CURL *curl, const char *url, const char *agent, long follow,
+                         curl_write_callback write_cb, void *userp)
+{
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, agent);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, userp);
+    deadline_setopt (curl, deadline_left ());
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, follow);
+    /* 4xx/5xx 응답(서버 과부하 안내 문구 등)은 요청 실패로 처리 */
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+}
+
+//------------------------------------------------------------------------------
+// 응답 header 에서 validator 저장 (redirect 된 경우 마지막 응답의 값만 남김)
+//------------------------------------------------------------------------------
+static void header_value (const char *p, size_t len, char *dst, size_t size)
+{
+    while (len && (*p == ' ' || *p == '\t'))               { p++; len--; }
+    while (len && (p[len - 1] == '\r' || p[len - 1] == '\n' || p[len - 1] == ' ')) len--;
+
+    /* 잘린 validator 는 사용할 수 없으므로 저장하지 않음 */
+    if (len >= size)    len = 0;
+    memcpy (dst, p, len);
+    dst[len] = '\0';
+}
+
+static size_t HeaderCallback(char *buffer, size_t size, size_t nitems, void *userp) {
+    size_t realsize = size * nitems;
+    wttr_cond_t *cond = (wttr_cond_t *)userp;
+
+    if (realsize >= 5 && !strncmp (buffer, "HTTP/", 5)) {
+        cond->etag[0] = cond->last_mod[0] = '\0';
+    } else if (realsize > 5 && !strncasecmp (buffer, "ETag:", 5)) {
+        header_value (buffer + 5, realsize - 5, cond->etag, sizeof(cond->etag));
+    } else if (realsize > 14 && !strncasecmp (buffer, "Last-Modified:", 14)) {
+        header_value (buffer + 14, realsize - 14, cond->last_mod, sizeof(cond->last_mod));
+    }
+    return realsize;
+}
+
+//------------------------------------------------------------------------------
+// 조건부 요청 header 설정, 반환된 list 는 요청이 끝난 뒤 curl_slist_free_all
+//------------------------------------------------------------------------------
+static struct curl_slist *cond_setopt (CURL *curl, wttr_cond_t *cond)
+{
+    struct curl_slist *hdr = NULL, *tmp;
+    char line [WTTR_VALIDATOR_SIZE + 32];
+
+    if (cond->etag[0]) {
+        snprintf (line, sizeof(line), "If-None-Match: %s", cond->etag);
+        if ((tmp = curl_slist_append (hdr, line)) != NULL)      hdr = tmp;
+    }
+    if (cond->last_mod[0]) {
+        snprintf (line, sizeof(line), "If-Modified-Since: %s", cond->last_mod);
+        if ((tmp = curl_slist_append (hdr, line)) != NULL)      hdr = tmp;
+    }
+    if (hdr)
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, hdr);
+
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, cond);
+    cond->not_modified = 0;
+    return hdr;
+}
+
+//------------------------------------------------------------------------------
+// 304 확인, 304 응답에 validator 가 없으면 요청에 사용한 값(old)을 유지
+//------------------------------------------------------------------------------
+static void cond_finish (CURL *curl, wttr_cond_t *cond, const wttr_cond_t *old)
+{
+    long code = 0;
+
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+    if ((cond->not_modified = (code == 304)) != 0) {
+        if (!cond->etag[0])     strcpy (cond->etag,     old->etag);
+        if (!cond->last_mod[0]) strcpy (cond->last_mod, old->last_mod);
+    }
+}
+
+//------------------------------------------------------------------------------
+// 요청 실행 (gate 허가 및 재시도), 각 시도는 stats_request 로 기록함
+// rx = 수신된 body 크기 (body 를 받기 시작한 뒤 실패한 요청은 재시도하지 않음)
+// 반환값 = cURL 결과, 허가를 받지 못해 요청하지 않은 경우 HTTP_REJECTED
+//------------------------------------------------------------------------------
+#define HTTP_REJECTED   CURLE_ABORTED_BY_CALLBACK
+
+static const char *http_strerror (CURLcode res)
+{
+    return (res == HTTP_REJECTED) ? "요청 제한 (rate limit, circuit open 또는 시간 budget 부족)"
+                                  : curl_easy_strerror(res);
+}
+
+static CURLcode http_perform (CURL *curl, int ep, const size_t *rx)
+{
+    CURLcode res;
+    long long wait, left;
+    int fail;
+
+    for (int attempt = 0; ; attempt++) {
+        left = deadline_left ();
+        if ((wait = gate_admit (ep, left)) == GATE_REJECTED)
+            return HTTP_REJECTED;
+        sleep_us (wait);
+        deadline_setopt (curl, left - wait);
+
+        res  = curl_easy_perform(curl);
+        fail = gate_failure (curl, res);
+        stats_request (curl, ep, res);
+        gate_result (ep, !fail);
+
+        if (!fail || *rx ||
+            (wait = gate_backoff (ep, curl, attempt, deadline_left ())) == GATE_REJECTED)
+            return res;
+        sleep_us (wait);
+    }
+}
+
+//------------------------------------------------------------------------------
+// HTTP GET 요청, 응답 body 를 반환 (호출한 곳에서 free)
+// fetch_mode = wttr.in 요청 방식 (-1 = wttr.in 요청이 아님)
+// cond != NULL 이면 조건부 요청, 304 응답은 빈 body 와 cond->not_modified = 1
+//------------------------------------------------------------------------------
+static char *http_get (const char *url, const char *agent, long follow, int fetch_mode,
+                       wttr_cond_t *cond)
+{
+    CURL *curl;
+    CURLcode res;
+    struct MemoryStruct chunk = {malloc(1), 0};
+    struct curl_slist *hdr = NULL;
+    wttr_cond_t old;
+
+    if (!chunk.memory) return NULL;
+    chunk.memory[0] = 0;
+
+    if (!(curl = http_handle_get())) {
+        free(chunk.memory);
+        return NULL;
+    }
+
+    http_setopt (curl, url, agent, follow, (curl_write_callback)WriteMemoryCallback, &chunk);
+    if (fetch_mode >= 0)
+        fetch_setopt (curl, fetch_mode);
+    if (cond) {
+        memcpy (&old, cond, sizeof(wttr_cond_t));
+        hdr = cond_setopt (curl, cond);
+    }
+
+    res = http_perform (curl, fetch_mode >= 0 ? eWTTR_EP_WEATHER : eWTTR_EP_LOCATION, &chunk.size);
+    if (fetch_mode >= 0 && res == CURLE_OK)
+        fetch_account (curl, fetch_mode, chunk.size);
+    if (cond && res == CURLE_OK)
+        cond_finish (curl, cond, &old);
+    http_handle_put (curl);
+    curl_slist_free_all (hdr);
+
+    if (res != CURLE_OK) {
+        fprintf(stderr, "curl 요청 실패: %s\n", http_strerror(res));
+        free(chunk.memory);
+        return NULL;
+    }
+    return chunk.memory;
+}
+
+//------------------------------------------------------------------------------
+// HTTP GET 요청, 응답을 streaming 추출기로 바로 전달
+// 반환값 = WTTR_UPDATE_OK, WTTR_UPDATE_FAIL, WTTR_UPDATE_UNCHANGED(304 응답)
+//------------------------------------------------------------------------------
+static int http_get_stream (const char *url, const char *agent, long follow, int fetch_mode,
+                            wttr_stream_t *st, wttr_cond_t *cond)
+{
+    CURL *curl;
+    CURLcode res;
+    struct curl_slist *hdr = NULL;
+    wttr_cond_t old;
+
+    if (!(curl = http_handle_get()))
+        return WTTR_UPDATE_FAIL;
+
+    http_setopt (curl, url, agent, follow, (curl_write_callback)WriteStreamCallback, st);
+    fetch_setopt (curl, fetch_mode);
+    if (cond) {
+        memcpy (&old, cond, sizeof(wttr_cond_t));
+        hdr = cond_setopt (curl, cond);
+    }
+
+    res = http_perform (curl, eWTTR_EP_WEATHER, &st->bytes);
+    if (res == CURLE_OK)
+        fetch_account (curl, fetch_mode, st->bytes);
+    if (cond && res == CURLE_OK)
+        cond_finish (curl, cond, &old);
+    http_handle_put (curl);
+    curl_slist_free_all (hdr);
+
+    if (res != CURLE_OK) {
+        fprintf(stderr, "curl 요청 실패: %s\n", http_strerror(res));
+        return WTTR_UPDATE_FAIL;
+    }
+    /* 수신과 동시에 파싱되므로 파싱 시간은 기록하지 않음 */
+    if (cond && cond->not_modified) {
+        stats_parse (eWTTR_EP_WEATHER, -1, 1);
+        return WTTR_UPDATE_UNCHANGED;
+    }
+    res = stream_finish (st);
+    stats_parse (eWTTR_EP_WEATHER, -1, res);
+    return res ? WTTR_UPDATE_OK : WTTR_UPDATE_FAIL;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// 위치(도시/국가) cache, key = grid 단위로 양자화된 위/경도 + 언어
+// path 가 설정된 경우 새 항목을 파일에 추가하고 시작시 다시 읽어옴.
+//------------------------------------------------------------------------------
+#define GEO_HASH_SIZE       512
+#define GEO_CACHE_MAX       4096
+#define GEO_GRID_DEFAULT    0.01    /* 약 1Km */
+#define GEO_M_PER_DEG       111195.0    /* 위도 1도의 거리 (m) */
+
+struct geo_entry {
+    struct geo_entry    *next;
+    long                lat_q, lon_q;
+    double              lat, lon;       /* 요청한 좌표 (파일에서 읽은 항목은 grid 중심) */
+    char                lang [4];
+    char                *city;
+    char                *country;
+};
+
+static pthread_mutex_t      GeoLock = PTHREAD_MUTEX_INITIALIZER;
+static struct geo_entry     *GeoHash [GEO_HASH_SIZE];
+static double               GeoGrid = GEO_GRID_DEFAULT;
+static int                  GeoOff  = 0;        /* 1 = cache 사용안함 (항목을 추가하지 않음) */
+static char                 *GeoPath = NULL;
+static wttr_cache_stats_t   GeoStats;
+
+static unsigned int geo_hash (long lat_q, long lon_q, const char *lang)
+{
+    unsigned int hash = (unsigned int)(lat_q * 73856093L) ^ (unsigned int)(lon_q * 19349663L);
+
+    while (*lang) hash = hash * 31 + (unsigned char)*lang++;
+    return hash % GEO_HASH_SIZE;
+}
+
+static struct geo_entry *geo_find (long lat_q, long lon_q, const char *lang)
+{
+    struct geo_entry *e = GeoHash[geo_hash (lat_q, lon_q, lang)];
+
+    for (; e; e = e->next)
+        if (e->lat_q == lat_q && e->lon_q == lon_q && !strcmp (e->lang, lang)) return e;
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// 항목 추가 (GeoLock 상태에서 호출)
+//------------------------------------------------------------------------------
+static struct geo_entry *geo_insert (long lat_q, long lon_q, const char *lang,
+                                     const char *city, const char *country)
+{
+    struct geo_entry *e;
+    unsigned int hash;
+
+    if (GeoOff)                                         return NULL;
+    if ((e = geo_find (lat_q, lon_q, lang)) != NULL)   return e;
+    if (GeoStats.entries >= GEO_CACHE_MAX)              return NULL;
+    if (!(e = calloc (1, sizeof(struct geo_entry))))    return NULL;
+
+    e->lat_q   = lat_q;
+    e->lon_q   = lon_q;
+    e->lat     = lat_q * GeoGrid;
+    e->lon     = lon_q * GeoGrid;
+    e->city    = strdup (city);
+    e->country = strdup (country);
+    snprintf (e->lang, sizeof(e->lang), "%s", lang);
+
+    if (!e->city || !e->country) {
+        free (e->city); free (e->country); free (e);
+        return NULL;
+    }
+    hash = geo_hash (lat_q, lon_q, lang);
+    e->next = GeoHash[hash];
+    GeoHash[hash] = e;
+
+    GeoStats.entries++;
+    GeoStats.bytes += sizeof(struct geo_entry) + strlen (city) + strlen (country) + 2;
+    return e;
+}
+
+static void geo_clear (void)
+{
+    for (int i = 0; i < GEO_HASH_SIZE; i++) {
+        while (GeoHash[i]) {
+            struct geo_entry *e = GeoHash[i];
+
+            GeoHash[i] = e->next;
+            free (e->city); free (e->country); free (e);
+        }
+    }
+    GeoStats.entries = 0;
+    GeoStats.bytes   = 0;
+}
+
+//------------------------------------------------------------------------------
+// cache 파일 : 첫줄 "# grid <deg>", 이후 "lat_q lon_q lang\tcity\tcountry"
+// grid 는 %.17g 로 저장 (읽은 값이 GeoGrid 와 정확히 같아야 함).
+// 이름의 역슬래시, tab, 줄바꿈은 C 문자열과 같은 escape (\\ \t \n \r) 로 저장함.
+//------------------------------------------------------------------------------
+static void geo_file_put_name (FILE *fp, const char *str)
+{
+    for (; *str; str++) {
+        switch (*str) {
+            case '\\':  fputs ("\\\\", fp);  break;
+            case '\t':  fputs ("\\t", fp);   break;
+            case '\n':  fputs ("\\n", fp);   break;
+            case '\r':  fputs ("\\r", fp);   break;
+            default:    fputc (*str, fp);    break;
+        }
+    }
+}
+
+/* escape 된 이름을 원래 문자열로 (in-place), 반환값 0 = 잘못된 escape */
+static int geo_file_get_name (char *str)
+{
+    char *d = str;
+
+    for (; *str; str++) {
+        if (*str != '\\') {
+            *d++ = *str;
+            continue;
+        }
+        switch (*++str) {
+            case '\\':  *d++ = '\\';  break;
+            case 't':   *d++ = '\t';  break;
+            case 'n':   *d++ = '\n';  break;
+            case 'r':   *d++ = '\r';  break;
+            default:    return 0;
+        }
+    }
+    *d = '\0';
+    return 1;
+}
+
+static void geo_file_load (const char *path)
+{
+    char *line = NULL, *city, *country;
+    size_t line_size = 0;
+    ssize_t len;
+    long lat_q, lon_q;
+    char lang[4];
+    double grid;
+    FILE *fp;
+
+    if (!(fp = fopen (path, "r")))  return;
+
+    /* grid 가 다르면 양자화 key 가 맞지않으므로 사용하지 않음 */
+    if (getline (&line, &line_size, fp) < 0 ||
+        sscanf (line, "# grid %lf", &grid) != 1 || grid != GeoGrid) {
+        free (line);
+        fclose (fp);
+        return;
+    }
+    /* 한 줄 전체를 읽음 (마지막 줄바꿈이 없는 줄은 쓰다가 중단된 항목이므로 무시) */
+    while ((len = getline (&line, &line_size, fp)) > 0) {
+        if (line[len - 1] != '\n')              continue;
+        line[len - 1] = '\0';
+        if (!(city = strchr (line, '\t')))      continue;
+        *city++ = '\0';
+        if (!(country = strchr (city, '\t')))   continue;
+        *country++ = '\0';
+
+        if (sscanf (line, "%ld %ld %3s", &lat_q, &lon_q, lang) == 3 &&
+            geo_file_get_name (city) && geo_file_get_name (country))
+            geo_insert (lat_q, lon_q, lang, city, country);
+    }
+    free (line);
+    fclose (fp);
+}
+
+static void geo_file_append (const struct geo_entry *e)
+{
+    FILE *fp;
+    int empty;
+
+    if (!GeoPath || !(fp = fopen (GeoPath, "a")))   return;
+
+    fseek (fp, 0, SEEK_END);
+    if ((empty = (ftell (fp) == 0)) != 0)
+        fprintf (fp, "# grid %.17g\n", GeoGrid);
+
+    fprintf (fp, "%ld %ld %s\t", e->lat_q, e->lon_q, e->lang);
+    geo_file_put_name (fp, e->city);
+    fputc ('\t', fp);
+    geo_file_put_name (fp, e->country);
+    fputc ('\n', fp);
+    fclose (fp);
+}
+
+//------------------------------------------------------------------------------
+// 위치 cache 설정, grid_deg = 0 이면 기본값(0.01도), path = NULL 이면 파일 저장 안함
+// grid_deg < 0 이면 cache 를 사용하지 않음 (항상 upstream 요청, path 는 무시).
+// 설정이 바뀌면 기존 항목은 삭제되고 path 파일을 다시 읽어옴.
+//------------------------------------------------------------------------------
+void wttr_geo_cache_config (double grid_deg, const char *path)
+{
+    pthread_mutex_lock (&GeoLock);
+    geo_clear ();
+    free (GeoPath);
+
+    GeoOff  = (grid_deg < 0);
+    GeoGrid = (grid_deg > 0) ? grid_deg : GEO_GRID_DEFAULT;
+    GeoPath = (path && !GeoOff) ? strdup (path) : NULL;
+
+    if (GeoPath) {
+        FILE *fp;
+
+        geo_file_load (GeoPath);
+
+        /* grid 가 다른 파일은 현재 grid 로 다시 작성 */
+        if (!GeoStats.entries && (fp = fopen (GeoPath, "w")) != NULL) {
+            fprintf (fp, "# grid %.17g\n", GeoGrid);
+            fclose (fp);
+        }
+    }
+    pthread_mutex_unlock (&GeoLock);
+}
+
+void wttr_geo_cache_get_stats (wttr_cache_stats_t *stats)
+{
+    if (!stats) return;
+
+    pthread_mutex_lock (&GeoLock);
+    memcpy (stats, &GeoStats, sizeof(wttr_cache_stats_t));
+    pthread_mutex_unlock (&GeoLock);
+}
+
+static void geo_quantize (double lat, double lon, long *lat_q, long *lon_q)
+{
+    *lat_q = lround (lat / GeoGrid);
+    *lon_q = lround (lon / GeoGrid);
+}
+
+//------------------------------------------------------------------------------
+// cache 조회, 있으면 g_city/g_country (각 size byte) 에 복사하고 1 반환
+//------------------------------------------------------------------------------
+static int geo_lookup (double lat, double lon, const char *lang, char *g_city, char *g_country,
+                       size_t size)
+{
+    struct geo_entry *e;
+    long lat_q, lon_q;
+
+    pthread_mutex_lock (&GeoLock);
+    geo_quantize (lat, lon, &lat_q, &lon_q);
+    if ((e = geo_find (lat_q, lon_q, lang)) != NULL) {
+        str_copy (g_city,    size, e->city);
+        str_copy (g_country, size, e->country);
+        GeoStats.hit++;
+    } else {
+        GeoStats.miss++;
+    }
+    pthread_mutex_unlock (&GeoLock);
+    return e ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// cache 조회, 있으면 복사본을 *city/*country 에 저장 (호출한 곳에서 free)
+//------------------------------------------------------------------------------
+static int geo_lookup_dup (double lat, double lon, const char *lang, char **city, char **country)
+{
+    struct geo_entry *e;
+    long lat_q, lon_q;
+    int ret = 0;
+
+    pthread_mutex_lock (&GeoLock);
+    geo_quantize (lat, lon, &lat_q, &lon_q);
+    if ((e = geo_find (lat_q, lon_q, lang)) != NULL) {
+        *city    = strdup (e->city);
+        *country = strdup (e->country);
+        ret = (*city && *country);
+        GeoStats.hit++;
+    } else {
+        GeoStats.miss++;
+    }
+    pthread_mutex_unlock (&GeoLock);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// 주변 grid(3x3) 에서 가장 가까운 항목 (요청 실패시 사용), 복사본은 호출한 곳에서 free
+//------------------------------------------------------------------------------
+static int geo_lookup_near (double lat, double lon, const char *lang, char **city, char **country)
+{
+    const struct geo_entry *e, *near = NULL;
+    double best = 0;
+    long lat_q, lon_q;
+    int ret = 0;
+
+    pthread_mutex_lock (&GeoLock);
+    geo_quantize (lat, lon, &lat_q, &lon_q);
+    for (long dy = -1; dy <= 1; dy++) {
+        for (long dx = -1; dx <= 1; dx++) {
+            double d_lat, d_lon;
+
+            if (!(e = geo_find (lat_q + dy, lon_q + dx, lang)))
+                continue;
+            d_lat = (lat_q + dy) * GeoGrid - lat;
+            d_lon = (lon_q + dx) * GeoGrid - lon;
+            if (!near || d_lat * d_lat + d_lon * d_lon < best) {
+                near = e;
+                best = d_lat * d_lat + d_lon * d_lon;
+            }
+        }
+    }
+    if (near) {
+        *city    = strdup (near->city);
+        *country = strdup (near->country);
+        ret = (*city && *country);
+    }
+    pthread_mutex_unlock (&GeoLock);
+    return ret;
+}
+
+static void geo_store (double lat, double lon, const char *lang, const char *city, const char *country)
+{
+    struct geo_entry *e;
+    long lat_q, lon_q;
+
+    pthread_mutex_lock (&GeoLock);
+    geo_quantize (lat, lon, &lat_q, &lon_q);
+    if (!geo_find (lat_q, lon_q, lang) &&
+        (e = geo_insert (lat_q, lon_q, lang, city, country)) != NULL) {
+        e->lat = lat;
+        e->lon = lon;
+        geo_file_append (e);
+    }
+    pthread_mutex_unlock (&GeoLock);
+}
+
+//------------------------------------------------------------------------------
+// 공간 검색 : radius_m 안에서 가장 가까운 위치 (grid 가 공간 index, 주변 grid 만 검색)
+// 검색할 grid 수가 항목 수보다 많으면 전체 항목을 검색함.
+// 있으면 city/country(size) 에 복사하고 *dist_m = 거리, 반환값 1
+//------------------------------------------------------------------------------
+static double geo_dist_m (double lat1, double lon1, double lat2, double lon2)
+{
+    /* 짧은 거리용 equirectangular 근사 */
+    double d_lat = lat2 - lat1;
+    double d_lon = (lon2 - lon1) * cos ((lat1 + lat2) * M_PI / 360);
+
+    return sqrt (d_lat * d_lat + d_lon * d_lon) * GEO_M_PER_DEG;
+}
+
+static int geo_lookup_radius (double lat, double lon, const char *lang, double radius_m,
+                              char *city, char *country, size_t size, double *dist_m)
+{
+    const struct geo_entry *e, *near = NULL;
+    double best = radius_m, d, r_lat, r_lon;
+    long lat_q, lon_q, ny, nx;
+
+    pthread_mutex_lock (&GeoLock);
+    geo_quantize (lat, lon, &lat_q, &lon_q);
+
+    /* 항목은 자기 grid 안의 좌표이므로 반경 + 1 grid 까지 검색 */
+    r_lat = radius_m / GEO_M_PER_DEG;
+    r_lon = r_lat / fmax (cos (lat * M_PI / 180), 0.01);
+    ny = (long)fmin (r_lat / GeoGrid, GEO_CACHE_MAX) + 1;
+    nx = (long)fmin (r_lon / GeoGrid, GEO_CACHE_MAX) + 1;
+
+    if ((double)(2 * ny + 1) * (2 * nx + 1) > GeoStats.entries) {
+        for (int i = 0; i < GEO_HASH_SIZE; i++)
+            for (e = GeoHash[i]; e; e = e->next)
+                if (!strcmp (e->lang, lang) &&
+                    (d = geo_dist_m (lat, lon, e->lat, e->lon)) <= best) {
+                    near = e;
+                    best = d;
+                }
+    } else {
+        for (long dy = -ny; dy <= ny; dy++)
+            for (long dx = -nx; dx <= nx; dx++)
+                if ((e = geo_find (lat_q + dy, lon_q + dx, lang)) != NULL &&
+                    (d = geo_dist_m (lat, lon, e->lat, e->lon)) <= best) {
+                    near = e;
+                    best = d;
+                }
+    }
+    /* 같은 grid 의 항목은 radius 밖이어도 사용 (get_location_json 의 cache 와 같음) */
+    if (!near && (near = geo_find (lat_q, lon_q, lang)) != NULL)
+        best = geo_dist_m (lat, lon, near->lat, near->lon);
+    if (near) {
+        str_copy (city,    size, near->city);
+        str_copy (country, size, near->country);
+        *dist_m = best;
+        GeoStats.hit++;
+    }
+    pthread_mutex_unlock (&GeoLock);
+    return near ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// 위치 요청 URL 생성
+//------------------------------------------------------------------------------
+static void location_url (double lat, double lon, const char *lang, char *url, size_t size)
+{
+    wttr_get_endpoint (eWTTR_EP_LOCATION, url, size);
+    snprintf (url + strlen (url), size - strlen (url), LOCATION_URL_PATH, lat, lon, lang);
+}
+
+//------------------------------------------------------------------------------
+// 위치 응답(nominatim) 파싱, 위치 cache 에 저장 (cache 에는 잘리지 않은 이름을 저장)
+// 반환값 = 1 (g_city/g_country 에 size byte 까지 저장함) / 0 (파싱 실패)
+//------------------------------------------------------------------------------
+static int location_parse (const char *resp, double lat, double lon, const char *lang,
+                           char *g_city, char *g_country, size_t size)
+{
+    int ret = 0;
+    long long start = now_us ();
+    cJSON *json = cJSON_Parse(resp);
+
+    stats_parse (eWTTR_EP_LOCATION, now_us () - start,
+                 json && cJSON_GetObjectItemCaseSensitive(json, "address"));
+    if (json) {
+        cJSON *address = cJSON_GetObjectItemCaseSensitive(json, "address");
+        if (address) {
+            const char *city = NULL, *country = NULL;
+
+            cJSON *fields_city[] = {
+                cJSON_GetObjectItemCaseSensitive(address, "city"),
+                cJSON_GetObjectItemCaseSensitive(address, "town"),
+                cJSON_GetObjectItemCaseSensitive(address, "village"),
+                cJSON_GetObjectItemCaseSensitive(address, "county")
+            };
+            for (int i = 0; i < 4; i++) {
+                if (fields_city[i]) {
+                    city = fields_city[i]->valuestring;
+                    break;
+                }
+            }
+
+            country = cJSON_GetObjectItemCaseSensitive(address, "country") ?
+                      cJSON_GetObjectItemCaseSensitive(address, "country")->valuestring : NULL;
+
+            #if defined (__LIB_WEATHER_DEBUG__)
+                const char *state = NULL;
+
+                state = cJSON_GetObjectItemCaseSensitive(address, "state") ?
+                        cJSON_GetObjectItemCaseSensitive(address, "state")->valuestring : NULL;
+
+                printf("\n[위치 정보]\n");
+                printf("도시:   %s\n", city ? city : "(정보 없음)");
+                printf("지역:   %s\n", state ? state : "(정보 없음)");
+                printf("국가:   %s\n", country ? country : "(정보 없음)");
+            #endif
+
+            if (!city)      city    = "";
+            if (!country)   country = "";
+
+            str_copy (g_city,    size, city);
+            str_copy (g_country, size, country);
+
+            if (city[0] || country[0])
+                geo_store (lat, lon, lang, city, country);
+
+        } else {
+            fprintf(stderr, "주소 정보 없음\n");
+            str_copy (g_city,    size, "");
+            str_copy (g_country, size, "");
+        }
+        ret = 1;
+        cJSON_Delete(json);
+    } else {
+        fprintf(stderr, "JSON 파싱 실패\n");
+    }
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// 위치 요청 및 파싱
+// 반환값 = 1 (g_city/g_country 에 size byte 까지 저장함) / 0 (요청 또는 파싱 실패)
+//------------------------------------------------------------------------------
+static int location_fetch (double lat, double lon, const char *lang, char *g_city, char *g_country,
+                           size_t size)
+{
+    char url[512], *resp;
+    int ret;
+
+    location_url (lat, lon, lang, url, sizeof(url));
+    if (!(resp = http_get (url, "C-Geocoder/1.0", 0L, -1, NULL))) {
+        char *city = NULL, *country = NULL;
+
+        /* 요청 실패 (upstream 장애, 요청 제한) : 주변 grid 의 cache 값 사용 */
+        if ((ret = geo_lookup_near (lat, lon, lang, &city, &country)) != 0) {
+            str_copy (g_city,    size, city);
+            str_copy (g_country, size, country);
+            stats_cached (eWTTR_EP_LOCATION);
+        }
+        free (city);
+        free (country);
+        return ret;
+    }
+
+    ret = location_parse (resp, lat, lon, lang, g_city, g_country, size);
+    free(resp);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// 위,경도에 위치한 도시/지역 요청
+// 같은 grid/언어의 요청이 진행중이면 그 결과를 사용함.
+// 반환값 = 1 (g_city/g_country 에 size byte 까지 저장함) / 0 (요청 또는 파싱 실패)
+//------------------------------------------------------------------------------
+static int location_get (double lat, double lon, const char *lang, char *g_city, char *g_country,
+                         size_t size)
+{
+    struct flight *f;
+    char key[64], *result;
+    char city [WTTR_GEO_NAME_SIZE], country [WTTR_GEO_NAME_SIZE];
+    long lat_q, lon_q;
+    long long prev;
+    int leader, ret;
+
+    if (geo_lookup (lat, lon, lang, g_city, g_country, size))
+        return 1;
+
+    pthread_mutex_lock (&GeoLock);
+    geo_quantize (lat, lon, &lat_q, &lon_q);
+    pthread_mutex_unlock (&GeoLock);
+    snprintf (key, sizeof(key), "%ld,%ld,%s", lat_q, lon_q, lang);
+
+    f = flight_join (FLIGHT_LOCATION, key, &leader);
+    if (!leader) {
+        /* result = "city\0country\0" */
+        if ((result = (char *)f->result) != NULL) {
+            str_copy (g_city,    size, result);
+            str_copy (g_country, size, result + strlen (result) + 1);
+        }
+        flight_leave (f, free);
+        return result != NULL;
+    }
+
+    /* 기다리는 요청의 buffer 가 더 클 수 있으므로 최대 크기로 받은 뒤 복사 */
+    prev = deadline_enter (0);
+    ret  = location_fetch (lat, lon, lang, city, country, sizeof(city));
+    deadline_leave (prev);
+    if (ret) {
+        str_copy (g_city,    size, city);
+        str_copy (g_country, size, country);
+    }
+    if (f) {
+        size_t clen = ret ? strlen (city)    + 1 : 0;
+        size_t nlen = ret ? strlen (country) + 1 : 0;
+
+        if ((result = ret ? malloc (clen + nlen) : NULL) != NULL) {
+            memcpy (result,        city,    clen);
+            memcpy (result + clen, country, nlen);
+        }
+        flight_done  (f, ret, result);
+        flight_leave (f, free);
+    }
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// g_city/g_country 는 각각 size byte buffer, 긴 이름은 UTF-8 글자 단위로 자름
+// 반환값 = 1 (저장함) / 0 (요청 또는 파싱 실패)
+//------------------------------------------------------------------------------
+int get_location_json_buf (double lat, double lon, char *g_city, char *g_country, size_t size,
+                           int is_kor)
+{
+    #if defined (__LIB_WEATHER_DEBUG__)
+        printf("lat = %f, lon = %f, is_kor = %d\n", lat, lon, is_kor);
+    #endif
+
+    if (!g_city || !g_country || !size)
+        return 0;
+
+    return location_get (lat, lon, is_kor ? "ko" : "en", g_city, g_country, size);
+}
+
+void get_location_json (double lat, double lon, char *g_city, char *g_country, int is_kor)
+{
+    get_location_json_buf (lat, lon, g_city, g_country, WTTR_GEO_NAME_SIZE, is_kor);
+}
+
+//------------------------------------------------------------------------------
+// 여러 좌표의 위치 요청 (batch reverse geocoding)
+// 1) 이미 알고 있는 위치 중 radius_m 안에 있는 점은 요청하지 않고 그 값을 사용 (INDEX)
+// 2) 남은 점은 순서대로 요청, 응답은 공간 index 에 추가되므로 먼저 요청한 점의
+//    radius_m 안에 있는 다음 점들은 요청하지 않음 (DEDUP)
+// upstream 요청은 위치 요청 gate(초당 1회, wttr_rate_config)를 그대로 거침.
+//------------------------------------------------------------------------------
+int wttr_geo_batch (wttr_geo_point_t *pt, int cnt, int is_kor, double radius_m)
+{
+    const char *lang = is_kor ? "ko" : "en";
+    int ok_cnt = 0;
+
+    if (!pt || cnt <= 0) return 0;
+    if (radius_m <= 0)  radius_m = WTTR_GEO_RADIUS_M;
+
+    for (int i = 0; i < cnt; i++) {
+        pt[i].city[0] = pt[i].country[0] = '\0';
+        pt[i].dist_m  = 0;
+        pt[i].source  = geo_lookup_radius (pt[i].lat, pt[i].lon, lang, radius_m,
+                                           pt[i].city, pt[i].country, WTTR_GEO_NAME_SIZE,
+                                           &pt[i].dist_m) ? eWTTR_GEO_INDEX : eWTTR_GEO_FAIL;
+    }
+
+    for (int i = 0; i < cnt; i++) {
+        if (pt[i].source != eWTTR_GEO_FAIL) {
+            ok_cnt++;
+            continue;
+        }
+        if (geo_lookup_radius (pt[i].lat, pt[i].lon, lang, radius_m,
+                               pt[i].city, pt[i].country, WTTR_GEO_NAME_SIZE, &pt[i].dist_m)) {
+            pt[i].source = eWTTR_GEO_DEDUP;
+            ok_cnt++;
+            continue;
+        }
+        if (location_get (pt[i].lat, pt[i].lon, lang, pt[i].city, pt[i].country,
+                          WTTR_GEO_NAME_SIZE)) {
+            pt[i].source = eWTTR_GEO_UPSTREAM;
+            ok_cnt++;
+        } else {
+            pt[i].city[0] = pt[i].country[0] = '\0';
+        }
+    }
+    return ok_cnt;
+}
+
+//------------------------------------------------------------------------------
+// HTTP 요청 (e = 등록된 지역), cond != NULL 이면 조건부 요청
+//------------------------------------------------------------------------------
+static char *weather_get (const struct loc_entry *e, wttr_cond_t *cond)
+{
+    int fetch_mode = fetch_mode_get ();
+    char buf[512], *url, *json;
+
+    #if defined (__LIB_WEATHER_DEBUG__)
+        printf("입력지역: %s\n", e && e->key[0] ? e->key : "현위치");
+    #endif
+
+    if (!(url = loc_url (e, fetch_mode, buf, sizeof(buf))))
+        return NULL;
+
+    json = http_get (url, "Mozilla/5.0", 1L, fetch_mode, cond);
+    if (url != buf) free (url);
+    return json;
+}
+
+//------------------------------------------------------------------------------
+// 같은 지역(registry handle)을 요청중이면 그 응답의 복사본을 반환
+//------------------------------------------------------------------------------
+char *get_weather_json (const char *location)
+{
+    const struct loc_entry *e = loc_get (wttr_loc_intern (location));
+    struct flight *f = NULL;
+    char *json;
+    long long prev;
+    int leader = 1;
+
+    if (!e) return NULL;
+
+    f = flight_join (FLIGHT_WEATHER_JSON, e->key, &leader);
+
+    if (!leader) {
+        json = f->result ? strdup ((const char *)f->result) : NULL;
+        flight_leave (f, free);
+        return json;
+    }
+
+    prev = deadline_enter (0);
+    json = weather_get (e, NULL);
+    deadline_leave (prev);
+    if (f) {
+        /* 기다리는 caller 용 복사본 */
+        flight_done  (f, json != NULL, json ? strdup (json) : NULL);
+        flight_leave (f, free);
+    }
+    return json;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// Json 날씨데이터 파싱 및 저장(wttr_data_t table)
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// 예보(weather) 항목 값 (숫자 문자열)
+//------------------------------------------------------------------------------
+static float forecast_value (const cJSON *hour, const char *item)
+{
+    const cJSON *obj = cJSON_GetObjectItem(hour, item);
+
+    if (cJSON_IsString(obj))    return strtof (obj->valuestring, NULL);
+    if (cJSON_IsNumber(obj))    return (float)obj->valuedouble;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// 예보(weather[].hourly[]) 파싱, 열(column) 단위로 저장
+// 예보 시각은 현지 날짜/시간을 timegm 으로 변환한 값 (시간 순서로 저장됨)
+// hourly 항목이 없는 응답(format=j2)은 fc->cnt = FC_NONE
+//------------------------------------------------------------------------------
+static void parse_forecast (const cJSON *root, wttr_forecast_t *fc)
+{
+    const cJSON *day, *hour;
+
+    fc->cnt = FC_NONE;
+
+    cJSON_ArrayForEach (day, cJSON_GetObjectItem(root, "weather")) {
+        const cJSON *date   = cJSON_GetObjectItem(day, "date");
+        const cJSON *hourly = cJSON_GetObjectItem(day, "hourly");
+        struct tm d;
+
+        memset (&d, 0, sizeof(d));
+        if (!cJSON_IsArray(hourly) || !cJSON_IsString(date) ||
+            !strptime (date->valuestring, "%Y-%m-%d", &d))
+            continue;
+        if (fc->cnt == FC_NONE)
+            fc->cnt = 0;
+
+        cJSON_ArrayForEach (hour, hourly) {
+            int n = fc->cnt, hhmm;
+
+            if (n >= WTTR_FC_MAX) return;
+
+            hhmm = (int)forecast_value (hour, "time");
+            d.tm_hour = hhmm / 100;
+            d.tm_min  = hhmm % 100;
+
+            fc->time[n] = timegm (&d);
+            fc->col[eWTTR_FC_TEMP]  [n] = forecast_value (hour, "tempC");
+            fc->col[eWTTR_FC_PRECIP][n] = forecast_value (hour, "precipMM");
+            fc->col[eWTTR_FC_WIND]  [n] = forecast_value (hour, "windspeedKmph");
+            fc->col[eWTTR_FC_RAIN]  [n] = forecast_value (hour, "chanceofrain");
+            fc->code[n] = (short)forecast_value (hour, "weatherCode");
+            fc->cnt++;
+        }
+    }
+}
+
+static int parse_weather_data (wttr_data_t *data, size_t cnt, wttr_forecast_t *fc, const char *json)
+{
+    cJSON *root = cJSON_Parse(json);
+    if (!root) {
+        fprintf(stderr, "JSON 파싱 실패\n");
+        return 0;
+    }
+
+    for (size_t i = 0; i < cnt; i++) {
+        cJSON *current = cJSON_GetObjectItem(root, *data[i].sub_class);
+        const cJSON *item;
+
+        if (!cJSON_IsArray(current) || cJSON_GetArraySize(current) == 0) {
+            cJSON_Delete(root);
+            fprintf(stderr, "날씨 정보 없음\n");
+            return 0;
+        }
+
+        cJSON *info = cJSON_GetArrayItem(current, 0);
+
+        if  ((strncmp(data[i].item_str, "areaName", strlen("areaName")) == 0) ||
+             (strncmp(data[i].item_str, "country" , strlen("country"))  == 0) )  {
+            const cJSON *arr = cJSON_GetObjectItem(info, data[i].item_str);
+            const cJSON *obj = cJSON_GetArrayItem (arr, 0);
+
+            item = cJSON_GetObjectItem(obj, "value");
+        }
+        else {
+            /* Get weather data from json arrary */
+            item = cJSON_GetObjectItem(info, data[i].item_str);
+        }
+
+        if (!cJSON_IsString(item)) {
+            cJSON_Delete(root);
+            fprintf(stderr, "날씨 항목 없음 : %s\n", data[i].item_str);
+            return 0;
+        }
+        snprintf (data[i].data_str, sizeof(data[i].data_str), "%s", item->valuestring);
+
+        #if defined (__LIB_WEATHER_DEBUG__)
+            /* Data print */
+            printf ("%s : %s, %s, %s\n", __func__,
+                *data[i].sub_class, data[i].item_str, data[i].data_str);
+        #endif
+    }
+    if (fc)
+        parse_forecast (root, fc);
+
+    cJSON_Delete(root);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// 날씨 provider : 요청 URL 생성 및 응답 → eWttrItem 항목 변환
+//------------------------------------------------------------------------------
+static pthread_mutex_t          ProviderLock = PTHREAD_MUTEX_INITIALIZER;
+static const wttr_provider_t    *Provider    = &WttrProviderWttrIn;    /* 주 provider */
+static const wttr_provider_t    *Fallback    = NULL;                   /* hedge 요청 provider */
+
+//------------------------------------------------------------------------------
+// wttr.in (FetchMode 의 j1/j2 사용, registry 에 미리 인코딩된 path 를 붙임)
+//------------------------------------------------------------------------------
+static int wttrin_url (const char *base, const char *location, char *url, size_t size)
+{
+    const struct loc_entry *e = loc_get (wttr_loc_intern (location));
+    int light = (fetch_mode_get () & WTTR_FETCH_LIGHT) ? 1 : 0;
+
+    if (!e) return 0;
+
+    return snprintf (url, size, "%s%s", base, e->path[light]) < (int)size;
+}
+
+static int wttrin_parse (const char *body, size_t len, wttr_data_t *data, size_t cnt,
+                         wttr_forecast_t *fc)
+{
+    (void)len;
+    return parse_weather_data (data, cnt, fc, body);
+}
+
+const wttr_provider_t WttrProviderWttrIn = { "wttr.in", wttrin_url, wttrin_parse, WEATHER_URL_BASE };
+
+//------------------------------------------------------------------------------
+// open-meteo : WMO 날씨 코드 → wttr.in(WWO) 날씨 코드
+//------------------------------------------------------------------------------
+static const short WmoCode [][2] = {
+    {  0, 113 }, {  1, 113 }, {  2, 116 }, {  3, 122 }, { 45, 248 }, { 48, 260 },
+    { 51, 263 }, { 53, 266 }, { 55, 266 }, { 56, 281 }, { 57, 284 },
+    { 61, 296 }, { 63, 302 }, { 65, 308 }, { 66, 311 }, { 67, 314 },
+    { 71, 326 }, { 73, 332 }, { 75, 338 }, { 77, 350 },
+    { 80, 353 }, { 81, 356 }, { 82, 359 }, { 85, 368 }, { 86, 371 },
+    { 95, 389 }, { 96, 389 }, { 99, 389 },
+};
+
+static int wmo_to_wwo (int wmo)
+{
+    for (size_t i = 0; i < sizeof(WmoCode) / sizeof(WmoCode[0]); i++)
+        if (WmoCode[i][0] == wmo)
+            return WmoCode[i][1];
+    /* 알 수 없는 코드는 흐림 */
+    return 119;
+}
+
+static int openmeteo_url (const char *base, const char *location, char *url, size_t size)
+{
+    double lat, lon;
+    char c;
+
+    /* 지역명 검색은 지원하지 않음 */
+    if (!location || sscanf (location, "%lf,%lf%c", &lat, &lon, &c) != 2)
+        return 0;
+
+    snprintf (url, size, "%s" OPENMETEO_URL_PATH, base, lat, lon);
+    return 1;
+}
+
+static int om_number (const cJSON *obj, const char *item, double *v)
+{
+    const cJSON *n = cJSON_GetObjectItem(obj, item);
+
+    if (!cJSON_IsNumber(n)) return 0;
+    *v = n->valuedouble;
+    return 1;
+}
+
+static int om_time (const cJSON *str, struct tm *t)
+{
+    memset (t, 0, sizeof(struct tm));
+    return cJSON_IsString(str) && strptime (str->valuestring, "%Y-%m-%dT%H:%M", t) != NULL;
+}
+
+//------------------------------------------------------------------------------
+// 시간별 예보 (hourly.time[] 과 같은 길이의 항목 배열), 시각은 parse_forecast 와 같이 timegm
+//------------------------------------------------------------------------------
+static void openmeteo_forecast (const cJSON *hourly, wttr_forecast_t *fc)
+{
+    const char *col_item [eWTTR_FC_COL_END] = {
+        "temperature_2m", "precipitation", "wind_speed_10m", "precipitation_probability" };
+    const cJSON *col [eWTTR_FC_COL_END], *code = cJSON_GetObjectItem(hourly, "weather_code");
+    const cJSON *tm;
+    struct tm t;
+    int n = 0;
+
+    fc->cnt = cJSON_IsObject(hourly) ? 0 : FC_NONE;
+    for (int c = 0; c < eWTTR_FC_COL_END; c++)
+        col[c] = cJSON_GetObjectItem(hourly, col_item[c]);
+
+    cJSON_ArrayForEach (tm, cJSON_GetObjectItem(hourly, "time")) {
+        const cJSON *v;
+
+        if (n >= WTTR_FC_MAX) break;
+        if (!om_time (tm, &t)) { n++; continue; }
+
+        fc->time[fc->cnt] = timegm (&t);
+        for (int c = 0; c < eWTTR_FC_COL_END; c++) {
+            v = cJSON_GetArrayItem(col[c], n);
+            fc->col[c][fc->cnt] = cJSON_IsNumber(v) ? (float)v->valuedouble : 0;
+        }
+        v = cJSON_GetArrayItem(code, n);
+        fc->code[fc->cnt] = cJSON_IsNumber(v) ? (short)wmo_to_wwo (v->valueint) : 0;
+        fc->cnt++;
+        n++;
+    }
+}
+
+//------------------------------------------------------------------------------
+// current 항목을 wttr.in 과 같은 단위/형식의 문자열로 변환
+// (시정 m → km, 관측 시간 "2025-05-20 12:15 PM", 지역/국가 이름은 없음)
+//------------------------------------------------------------------------------
+static int openmeteo_parse (const char *body, size_t len, wttr_data_t *data, size_t cnt,
+                            wttr_forecast_t *fc)
+{
+    cJSON *root = cJSON_Parse(body);
+    const cJSON *cur;
+    struct tm t;
+    double v;
+
+    (void)len;
+    if (!root) {
+        fprintf(stderr, "JSON 파싱 실패\n");
+        return 0;
+    }
+    cur = cJSON_GetObjectItem(root, "current");
+    if (!cJSON_IsObject(cur) || !om_time (cJSON_GetObjectItem(cur, "time"), &t)) {
+        cJSON_Delete(root);
+        fprintf(stderr, "날씨 정보 없음\n");
+        return 0;
+    }
+
+    for (size_t i = 0; i < cnt; i++) {
+        const char *item = NULL;
+        char *str = data[i].data_str;
+        size_t size = sizeof(data[i].data_str);
+
+        switch (data[i].id) {
+            case eWTTR_TEMP_FEEL:   item = "apparent_temperature";  break;
+            case eWTTR_CLOUD:       item = "cloud_cover";           break;
+            case eWTTR_HUMIDUTY:    item = "relative_humidity_2m";  break;
+            case eWTTR_PRESSURE:    item = "pressure_msl";          break;
+            case eWTTR_TEMP:        item = "temperature_2m";        break;
+            case eWTTR_UV:          item = "uv_index";              break;
+            case eWTTR_WIND_DIR:    item = "wind_direction_10m";    break;
+            case eWTTR_WIND_SPEED:  item = "wind_speed_10m";        break;
+            case eWTTR_LOBS_DATE:
+                /* %p 는 locale 에 따라 바뀌므로 AM/PM 은 직접 추가 */
+                strftime (str, size - 2, "%Y-%m-%d %I:%M ", &t);
+                strcat (str, t.tm_hour < 12 ? "AM" : "PM");
+                continue;
+            case eWTTR_PRECIPI:
+                snprintf (str, size, "%.1f", om_number (cur, "precipitation", &v) ? v : 0);
+                continue;
+            case eWTTR_VISIVILITY:
+                snprintf (str, size, "%ld", om_number (cur, "visibility", &v) ? lround (v / 1000) : 0);
+                continue;
+            case eWTTR_W_CODE:
+                if (!om_number (cur, "weather_code", &v)) {
+                    cJSON_Delete(root);
+                    fprintf(stderr, "날씨 항목 없음 : weather_code\n");
+                    return 0;
+                }
+                snprintf (str, size, "%d", wmo_to_wwo ((int)v));
+                continue;
+            case eWTTR_LATITUDE:
+            case eWTTR_LONGITUDE:
+                v = 0;
+                om_number (root, data[i].id == eWTTR_LATITUDE ? "latitude" : "longitude", &v);
+                snprintf (str, size, "%.3f", v);
+                continue;
+            default:
+                str[0] = '\0';
+                continue;
+        }
+        snprintf (str, size, "%ld", om_number (cur, item, &v) ? lround (v) : 0);
+    }
+    if (fc)
+        openmeteo_forecast (cJSON_GetObjectItem(root, "hourly"), fc);
+
+    cJSON_Delete(root);
+    return 1;
+}
+
+const wttr_provider_t WttrProviderOpenMeteo = { "open-meteo", openmeteo_url, openmeteo_parse, OPENMETEO_URL_BASE };
+
+int wttr_set_provider (enum eWttrEndpoint ep, const wttr_provider_t *provider)
+{
+    if (provider && (!provider->url || !provider->parse))
+        return 0;
+
+    pthread_mutex_lock (&ProviderLock);
+    if (ep == eWTTR_EP_WEATHER)
+        Provider = provider ? provider : &WttrProviderWttrIn;
+    else if (ep == eWTTR_EP_FALLBACK)
+        Fallback = provider;
+    pthread_mutex_unlock (&ProviderLock);
+    return (ep == eWTTR_EP_WEATHER || ep == eWTTR_EP_FALLBACK);
+}
+
+//------------------------------------------------------------------------------
+// batch/비동기 요청의 주 provider, wttr.in 이면 NULL (registry path 와 stream 파싱 사용)
+// 보조 provider 의 hedge 요청은 동기 요청(wttr_ctx_update)에서만 사용함.
+//------------------------------------------------------------------------------
+static const wttr_provider_t *provider_primary (void)
+{
+    const wttr_provider_t *prov;
+
+    pthread_mutex_lock   (&ProviderLock);
+    prov = Provider;
+    pthread_mutex_unlock (&ProviderLock);
+    return (prov == &WttrProviderWttrIn) ? NULL : prov;
+}
+
+//------------------------------------------------------------------------------
+// 날씨 요청 URL (prov = provider_primary 결과), 반환값 = url 또는 malloc 된 문자열
+// (loc_url 과 같음), NULL = 요청할 수 없는 지역
+//------------------------------------------------------------------------------
+static char *provider_url (const wttr_provider_t *prov, wttr_loc_t loc, int fetch_mode,
+                           char *url, size_t size)
+{
+    const struct loc_entry *e = loc_get (loc);
+    char base [WTTR_URL_BASE_SIZE];
+
+    if (!prov)
+        return loc_url (e, fetch_mode, url, size);
+
+    return (e && provider_base (eWTTR_EP_WEATHER, prov, base, sizeof(base)) &&
+            prov->url (base, e->key, url, size)) ? url : NULL;
+}
+
+//------------------------------------------------------------------------------
+// 문자열 값으로 snapshot 생성 (숫자/시간 값은 여기서 한번만 변환)
+//------------------------------------------------------------------------------
+static void wttr_snap_build (wttr_snap_t *snap, const wttr_result_t *res)
+{
+    const wttr_data_t *data = res->data;
+
+    memcpy (snap->data, data, sizeof(snap->data));
+    memcpy (&snap->fc,  &res->fc, sizeof(wttr_forecast_t));
+    if (snap->fc.cnt < 0)
+        snap->fc.cnt = 0;
+
+    for (size_t i = 0; i < WTTR_ITEM_CNT; i++) {
+        snap->fval[i] = strtod (data[i].data_str, NULL);
+        snap->ival[i] = (int)lround (snap->fval[i]);
+    }
+
+    memset (&snap->obs_tm, 0, sizeof(struct tm));
+    strptime (data[wttr_item_index (eWTTR_LOBS_DATE)].data_str, "%Y-%m-%d %I:%M %p", &snap->obs_tm);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// snapshot 파일 : 마지막 정상 업데이트 값(문자열, 변환된 숫자, 예보)과 그 좌표의
+// 위치 이름(geocode cache)을 저장하고, 시작시 mmap 으로 읽어 바로 사용함 (stale 표시).
+// 구조체를 그대로 쓰지 않고 고정 크기 field 와 길이+문자열로 저장함.
+//
+//   header  : struct snap_file_hdr
+//   payload : key      u16 len, bytes (location key)
+//             obs_tm   i32 x 9
+//             item     i32 id, i32 ival, f64 fval, u16 len, bytes        (x item_cnt)
+//             forecast i32 cnt, { i64 time, i16 code, f32 col[fc_cols] } (x cnt)
+//             geo      i64 lat_q, i64 lon_q, char lang[4], u16 len, city, u16 len, country
+//                                                                         (x geo_cnt)
+//------------------------------------------------------------------------------
+#define SNAP_MAGIC          "WTTRSNAP"
+#define SNAP_VERSION        1
+#define SNAP_ENDIAN         0x01020304u
+#define SNAP_PAYLOAD_MAX    (64 * 1024)
+
+struct snap_file_hdr {
+    char        magic [8];
+    uint32_t    version;
+    uint32_t    endian;         /* 다른 byte order 에서 만든 파일 확인 */
+    uint32_t    item_cnt;
+    uint32_t    fc_cols;
+    uint32_t    geo_cnt;
+    uint32_t    payload;        /* header 뒤 data 크기 */
+    int64_t     saved;          /* 저장 시간 (time_t) */
+    uint64_t    hash;           /* 응답 body hash (payload_hash) */
+    uint64_t    checksum;       /* payload 의 payload_hash */
+    double      geo_grid;       /* 저장할 때의 위치 cache grid (다르면 geo 는 사용안함) */
+};
+
+struct snap_buf {
+    unsigned char   *p, *end;
+};
+
+static int snap_put (struct snap_buf *b, const void *src, size_t n)
+{
+    if ((size_t)(b->end - b->p) < n)    return 0;
+    memcpy (b->p, src, n);
+    b->p += n;
+    return 1;
+}
+
+static int snap_put_str (struct snap_buf *b, const char *str)
+{
+    uint16_t len = (uint16_t)strnlen (str, UINT16_MAX);
+
+    return snap_put (b, &len, sizeof(len)) && snap_put (b, str, len);
+}
+
+/* mmap 된 data 는 정렬되어 있지 않으므로 memcpy 로 읽음 */
+static int snap_get (struct snap_buf *b, void *dst, size_t n)
+{
+    if ((size_t)(b->end - b->p) < n)    return 0;
+    memcpy (dst, b->p, n);
+    b->p += n;
+    return 1;
+}
+
+static int snap_get_str (struct snap_buf *b, char *dst, size_t size)
+{
+    uint16_t len;
+
+    if (!snap_get (b, &len, sizeof(len)) || (size_t)(b->end - b->p) < len)
+        return 0;
+    snprintf (dst, size, "%.*s", (len < size) ? (int)len : (int)size - 1, (const char *)b->p);
+    b->p += len;
+    return 1;
+}
+
+/* 저장된 지역 key 는 길이 제한 없이 registry 에 다시 등록 (빈 문자열 = 없음) */
+static int snap_get_loc (struct snap_buf *b, wttr_loc_t *loc)
+{
+    uint16_t len;
+    char *key;
+
+    if (!snap_get (b, &len, sizeof(len)) || (size_t)(b->end - b->p) < len ||
+        !(key = malloc (len + 1)))
+        return 0;
+    memcpy (key, b->p, len);
+    key[len] = '\0';
+    b->p += len;
+
+    *loc = len ? wttr_loc_intern (key) : WTTR_LOC_INVALID;
+    free (key);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// snapshot 좌표의 위치 이름 (get_location_json 의 ko/en 결과)
+//------------------------------------------------------------------------------
+static const char *SnapGeoLang[] = { "ko", "en" };
+
+static int snap_put_geo (struct snap_buf *b, const wttr_snap_t *snap, struct snap_file_hdr *hdr)
+{
+    double lat = snap->fval[wttr_item_index (eWTTR_LATITUDE)];
+    double lon = snap->fval[wttr_item_index (eWTTR_LONGITUDE)];
+    long lat_q, lon_q;
+    int ok = 1;
+
+    pthread_mutex_lock (&GeoLock);
+    hdr->geo_grid = GeoGrid;
+    geo_quantize (lat, lon, &lat_q, &lon_q);
+    for (size_t i = 0; ok && i < sizeof(SnapGeoLang) / sizeof(SnapGeoLang[0]); i++) {
+        const struct geo_entry *e = geo_find (lat_q, lon_q, SnapGeoLang[i]);
+        int64_t q[2] = { lat_q, lon_q };
+        char lang[4] = "";
+
+        if (!e) continue;
+        snprintf (lang, sizeof(lang), "%s", e->lang);
+        ok = snap_put (b, q, sizeof(q)) && snap_put (b, lang, sizeof(lang)) &&
+             snap_put_str (b, e->city) && snap_put_str (b, e->country);
+        hdr->geo_cnt++;
+    }
+    pthread_mutex_unlock (&GeoLock);
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+// snapshot 파일 저장 작업 : snap_save_prepare 는 ctx->mutex 를 잡은 상태에서 내용을
+// 복사하고, snap_save_commit 은 mutex 를 푼 뒤 파일에 씀 (fsync 동안 reader/writer 대기 없음).
+//------------------------------------------------------------------------------
+struct snap_save {
+    unsigned char   *buf;
+    size_t          len;
+    char            *path;
+    unsigned int    gen;
+};
+
+//------------------------------------------------------------------------------
+// ctx->snap 을 파일 형식으로 직렬화 (ctx->mutex 를 잡은 상태에서 호출)
+//------------------------------------------------------------------------------
+static unsigned char *snap_file_build (wttr_ctx_t *ctx, size_t *len)
+{
+    const wttr_snap_t *snap = &ctx->snap;
+    struct snap_file_hdr hdr;
+    struct snap_buf b;
+    unsigned char *buf;
+    int32_t tm[9] = {
+        snap->obs_tm.tm_sec,  snap->obs_tm.tm_min, snap->obs_tm.tm_hour,
+        snap->obs_tm.tm_mday, snap->obs_tm.tm_mon, snap->obs_tm.tm_year,
+        snap->obs_tm.tm_wday, snap->obs_tm.tm_yday, snap->obs_tm.tm_isdst,
+    };
+    int32_t fc_cnt = snap->fc.cnt;
+    int ok = 1;
+
+    if (!(buf = malloc (sizeof(hdr) + SNAP_PAYLOAD_MAX)))
+        return NULL;
+
+    memset (&hdr, 0, sizeof(hdr));
+    memcpy (hdr.magic, SNAP_MAGIC, sizeof(hdr.magic));
+    hdr.version  = SNAP_VERSION;
+    hdr.endian   = SNAP_ENDIAN;
+    hdr.item_cnt = WTTR_ITEM_CNT;
+    hdr.fc_cols  = eWTTR_FC_COL_END;
+    hdr.saved    = (int64_t)time (NULL);
+    hdr.hash     = (ctx->cond_loc >= 0) ? ctx->cond.hash : 0;
+
+    b.p   = buf + sizeof(hdr);
+    b.end = b.p + SNAP_PAYLOAD_MAX;
+
+    ok = snap_put_str (&b, (ctx->cond_loc >= 0) ? wttr_loc_key (ctx->cond_loc) : "") &&
+         snap_put (&b, tm, sizeof(tm));
+    for (size_t i = 0; ok && i < WTTR_ITEM_CNT; i++) {
+        int32_t id = snap->data[i].id, ival = snap->ival[i];
+
+        ok = snap_put (&b, &id, sizeof(id)) && snap_put (&b, &ival, sizeof(ival)) &&
+             snap_put (&b, &snap->fval[i], sizeof(double)) &&
+             snap_put_str (&b, snap->data[i].data_str);
+    }
+    ok = ok && snap_put (&b, &fc_cnt, sizeof(fc_cnt));
+    for (int i = 0; ok && i < snap->fc.cnt; i++) {
+        int64_t t = snap->fc.time[i];
+        int16_t code = snap->fc.code[i];
+
+        ok = snap_put (&b, &t, sizeof(t)) && snap_put (&b, &code, sizeof(code));
+        for (int c = 0; ok && c < eWTTR_FC_COL_END; c++)
+            ok = snap_put (&b, &snap->fc.col[c][i], sizeof(float));
+    }
+    ok = ok && snap_put_geo (&b, snap, &hdr);
+
+    hdr.payload  = (uint32_t)(b.p - (buf + sizeof(hdr)));
+    hdr.checksum = payload_hash (PAYLOAD_HASH_INIT, buf + sizeof(hdr), hdr.payload);
+    memcpy (buf, &hdr, sizeof(hdr));
+
+    if (!ok) {
+        free (buf);
+        return NULL;
+    }
+    *len = sizeof(hdr) + hdr.payload;
+    return buf;
+}
+
+//------------------------------------------------------------------------------
+// 직렬화된 snapshot 을 path 에 저장
+// 임시 파일에 쓰고 fsync 후 rename, 전원이 꺼져도 이전 파일 또는 새 파일이 남음.
+//------------------------------------------------------------------------------
+static int snap_file_write (const char *path, const unsigned char *buf, size_t len)
+{
+    char *tmp;
+    int fd, ok = 1;
+
+    if (!(tmp = malloc (strlen (path) + 8)))
+        return 0;
+    sprintf (tmp, "%s.tmp", path);
+
+    if ((fd = open (tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644)) >= 0) {
+        size_t pos = 0;
+
+        while (ok && pos < len) {
+            ssize_t n = write (fd, buf + pos, len - pos);
+
+            if (n <= 0)     ok = 0;
+            else            pos += n;
+        }
+        ok = !fsync (fd) && ok;
+        ok = !close (fd) && ok && !rename (tmp, path);
+        if (!ok)    unlink (tmp);
+    } else {
+        ok = 0;
+    }
+    #if defined (__LIB_WEATHER_DEBUG__)
+        if (!ok)    fprintf (stderr, "%s : %s save error\n", __func__, path);
+    #endif
+    free (tmp);
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+// 저장할 내용 복사 (ctx->mutex 를 잡은 상태에서 호출), 반환값 0 = 저장할 것 없음
+//------------------------------------------------------------------------------
+static int snap_save_prepare (wttr_ctx_t *ctx, struct snap_save *job)
+{
+    memset (job, 0, sizeof(struct snap_save));
+
+    if (!ctx->snap_path)
+        return 0;
+    if (!(job->buf = snap_file_build (ctx, &job->len)) ||
+        !(job->path = strdup (ctx->snap_path))) {
+        free (job->buf);
+        job->buf = NULL;
+        return 0;
+    }
+    job->gen = ++ctx->snap_gen;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 파일 저장 (ctx->mutex 를 잡지 않은 상태에서 호출)
+// 더 최근에 복사한 내용이 이미 저장되었으면 쓰지 않음 (반환값 1).
+//------------------------------------------------------------------------------
+static int snap_save_commit (wttr_ctx_t *ctx, struct snap_save *job)
+{
+    int ok = 1;
+
+    if (!job->buf)
+        return 0;
+
+    pthread_mutex_lock   (&ctx->save_lock);
+    if ((int)(job->gen - ctx->snap_done) > 0) {
+        if ((ok = snap_file_write (job->path, job->buf, job->len)))
+            ctx->snap_done = job->gen;
+    }
+    pthread_mutex_unlock (&ctx->save_lock);
+
+    free (job->path);
+    free (job->buf);
+    job->buf = NULL;
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// 공유 메모리 snapshot (POSIX shm) : daemon 이 업데이트한 값을 같은 장치의 여러
+// process 가 network 없이 읽음. 쓰는 쪽은 하나(flock)이고 seqlock 으로 게시함.
+// 읽는 쪽은 segment 를 읽기 전용으로 mmap 하여 lock 없이 필요한 값만 복사함.
+// 구조체를 그대로 공유하므로 같은 version 의 라이브러리끼리만 사용함 (size 확인).
+//------------------------------------------------------------------------------
+#define SHM_MAGIC           0x5753484du     /* "WSHM" */
+#define SHM_VERSION         2
+#define SHM_NAME_SIZE       WTTR_GEO_NAME_SIZE  /* 위치 이름 (get_location_json 과 같은 크기) */
+
+enum { SHM_GEO_KO = 0, SHM_GEO_EN, SHM_GEO_END };
+
+struct shm_seg {
+    uint32_t        magic;
+    uint32_t        version;
+    uint32_t        size;                   /* sizeof(struct shm_seg) */
+    uint32_t        seq;                    /* seqlock (홀수 = 교체중), generation = seq / 2 */
+    int32_t         writer_pid;             /* 0 = daemon 종료 */
+    int32_t         stale;                  /* snapshot 파일에서 읽은 값 */
+    int64_t         updated;                /* 게시 시간 (time_t) */
+
+    char            str  [WTTR_ITEM_CNT][WTTR_DATA_SIZE];
+    int32_t         ival [WTTR_ITEM_CNT];
+    double          fval [WTTR_ITEM_CNT];
+    struct tm       obs_tm;
+    wttr_forecast_t fc;
+    char            city    [SHM_GEO_END][SHM_NAME_SIZE];
+    char            country [SHM_GEO_END][SHM_NAME_SIZE];
+};
+
+static long shm_futex (uint32_t *addr, int op, uint32_t val, const struct timespec *ts)
+{
+    return syscall (SYS_futex, addr, op, val, ts, NULL, 0);
+}
+
+//------------------------------------------------------------------------------
+// ctx->snap 과 그 좌표의 위치 이름을 segment 에 게시 (ctx->mutex 를 잡은 상태에서 호출)
+//------------------------------------------------------------------------------
+static void shm_write (wttr_ctx_t *ctx)
+{
+    struct shm_seg *seg = ctx->shm;
+    const wttr_snap_t *snap = &ctx->snap;
+    char city [SHM_GEO_END][SHM_NAME_SIZE], country [SHM_GEO_END][SHM_NAME_SIZE];
+    long lat_q, lon_q;
+
+    memset (city,    0, sizeof(city));
+    memset (country, 0, sizeof(country));
+
+    pthread_mutex_lock (&GeoLock);
+    geo_quantize (snap->fval[wttr_item_index (eWTTR_LATITUDE)],
+                  snap->fval[wttr_item_index (eWTTR_LONGITUDE)], &lat_q, &lon_q);
+    for (int g = 0; g < SHM_GEO_END; g++) {
+        const struct geo_entry *e = geo_find (lat_q, lon_q, SnapGeoLang[g]);
+
+        if (e) {
+            str_copy (city[g],    SHM_NAME_SIZE, e->city);
+            str_copy (country[g], SHM_NAME_SIZE, e->country);
+        }
+    }
+    pthread_mutex_unlock (&GeoLock);
+
+    __atomic_store_n (&seg->seq, seg->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence (__ATOMIC_RELEASE);
+
+    for (size_t i = 0; i < WTTR_ITEM_CNT; i++) {
+        memcpy (seg->str[i], snap->data[i].data_str, WTTR_DATA_SIZE);
+        seg->ival[i] = snap->ival[i];
+        seg->fval[i] = snap->fval[i];
+    }
+    memcpy (&seg->obs_tm, &snap->obs_tm, sizeof(struct tm));
+    memcpy (&seg->fc,     &snap->fc,     sizeof(wttr_forecast_t));
+    memcpy (seg->city,    city,    sizeof(city));
+    memcpy (seg->country, country, sizeof(country));
+    seg->stale   = ctx->stale;
+    seg->updated = (int64_t)time (NULL);
+
+    __atomic_store_n (&seg->seq, seg->seq + 1, __ATOMIC_RELEASE);
+
+    /* wttr_shm_wait 로 기다리는 reader */
+    shm_futex (&seg->seq, FUTEX_WAKE, INT_MAX, NULL);
+}
+
+//------------------------------------------------------------------------------
+// writer 해제 (ctx->mutex 를 잡은 상태 또는 destroy 에서 호출), flock 도 풀림
+//------------------------------------------------------------------------------
+static void shm_unmap (wttr_ctx_t *ctx)
+{
+    if (!ctx->shm)
+        return;
+
+    __atomic_store_n (&ctx->shm->writer_pid, 0, __ATOMIC_RELEASE);
+    munmap (ctx->shm, sizeof(struct shm_seg));
+    close (ctx->shm_fd);
+    ctx->shm    = NULL;
+    ctx->shm_fd = -1;
+}
+
+//------------------------------------------------------------------------------
+// 파싱된 snapshot 을 context 에 한번에 교체
+//------------------------------------------------------------------------------
+static void wttr_ctx_publish (wttr_ctx_t *ctx, const wttr_result_t *res,
+                              wttr_loc_t loc, const wttr_cond_t *cond)
+{
+    struct snap_save job;
+    wttr_snap_t snap;
+
+    int lat = wttr_item_index (eWTTR_LATITUDE), lon = wttr_item_index (eWTTR_LONGITUDE);
+
+    wttr_snap_build (&snap, res);
+
+    pthread_mutex_lock   (&ctx->mutex);
+    /* 예보가 없는 응답(j2, streaming 파싱)은 같은 좌표의 이전 예보를 유지 */
+    if (res->fc.cnt == FC_NONE &&
+        snap.fval[lat] == ctx->snap.fval[lat] && snap.fval[lon] == ctx->snap.fval[lon])
+        memcpy (&snap.fc, &ctx->snap.fc, sizeof(wttr_forecast_t));
+
+    __atomic_store_n (&ctx->seq, ctx->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence (__ATOMIC_RELEASE);
+    memcpy (&ctx->snap, &snap, sizeof(wttr_snap_t));
+    __atomic_store_n (&ctx->seq, ctx->seq + 1, __ATOMIC_RELEASE);
+
+    /* snapshot 과 validator 는 같이 교체 (다른 응답의 validator 가 남지 않도록) */
+    ctx->cond_loc = cond ? loc : WTTR_LOC_INVALID;
+    if (ctx->cond_loc >= 0) memcpy (&ctx->cond, cond, sizeof(wttr_cond_t));
+    else                    memset (&ctx->cond, 0, sizeof(wttr_cond_t));
+
+    ctx->stale = 0;
+    snap_save_prepare (ctx, &job);
+    if (ctx->shm)
+        shm_write (ctx);
+    pthread_mutex_unlock (&ctx->mutex);
+
+    snap_save_commit (ctx, &job);
+}
+
+static void wttr_ctx_store (wttr_ctx_t *ctx, const wttr_result_t *res)
+{
+    wttr_ctx_publish (ctx, res, WTTR_LOC_INVALID, NULL);
+}
+
+//------------------------------------------------------------------------------
+// 현재 snapshot 이 loc 의 응답이면 validator 를 cond 에 복사 (아니면 빈 값)
+//------------------------------------------------------------------------------
+static void wttr_ctx_cond_get (wttr_ctx_t *ctx, wttr_loc_t loc, wttr_cond_t *cond)
+{
+    memset (cond, 0, sizeof(wttr_cond_t));
+
+    pthread_mutex_lock   (&ctx->mutex);
+    if (loc >= 0 && ctx->cond_loc == loc)
+        memcpy (cond, &ctx->cond, sizeof(wttr_cond_t));
+    pthread_mutex_unlock (&ctx->mutex);
+}
+
+//------------------------------------------------------------------------------
+// 변경없음 응답의 validator 로 갱신 (그 사이 snapshot 이 바뀌었으면 무시)
+//------------------------------------------------------------------------------
+static void wttr_ctx_cond_set (wttr_ctx_t *ctx, wttr_loc_t loc, const wttr_cond_t *cond)
+{
+    pthread_mutex_lock   (&ctx->mutex);
+    if (loc >= 0 && ctx->cond_loc == loc && ctx->cond.hash == cond->hash) {
+        memcpy (&ctx->cond, cond, sizeof(wttr_cond_t));
+        /* 파일에서 읽은 snapshot 이 최신임을 확인 (공유 메모리의 stale 도 갱신) */
+        if (ctx->stale) {
+            ctx->stale = 0;
+            if (ctx->shm)
+                shm_write (ctx);
+        }
+    }
+    pthread_mutex_unlock (&ctx->mutex);
+}
+
+//------------------------------------------------------------------------------
+// snapshot 일부(src)를 dst 로 복사 (seqlock reader, 교체중이면 다시 읽음)
+//------------------------------------------------------------------------------
+static void wttr_ctx_read (wttr_ctx_t *ctx, void *dst, const void *src, size_t size)
+{
+    unsigned int seq;
+
+    for (;;) {
+        while ((seq = __atomic_load_n (&ctx->seq, __ATOMIC_ACQUIRE)) & 1)
+            sched_yield ();
+
+        memcpy (dst, src, size);
+        __atomic_thread_fence (__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n (&ctx->seq, __ATOMIC_RELAXED) == seq)
+            return;
+    }
+}
+
+//------------------------------------------------------------------------------
+// snapshot 교체 횟수 (값이 바뀌었는지 확인용)
+//------------------------------------------------------------------------------
+unsigned int wttr_ctx_generation (wttr_ctx_t *ctx)
+{
+    return ctx ? __atomic_load_n (&ctx->seq, __ATOMIC_ACQUIRE) / 2 : 0;
+}
+
+static int wttr_ctx_apply_json (wttr_ctx_t *ctx, const char *json)
+{
+    wttr_result_t res;
+
+    wttr_result_init (&res);
+
+    if (!parse_weather_data (res.data, WTTR_ITEM_CNT, &res.fc, json))
+        return 0;
+
+    wttr_ctx_store (ctx, &res);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// context 별 thread buffer 해제 (thread 종료시 호출됨)
+//------------------------------------------------------------------------------
+static void data_tls_free (void *arg)
+{
+    struct data_tls *tls = arg;
+    wttr_ctx_t *ctx = tls->ctx;
+
+    pthread_mutex_lock   (&ctx->tls_lock);
+    if (tls->prev)  tls->prev->next = tls->next;
+    else            ctx->tls_list   = tls->next;
+    if (tls->next)  tls->next->prev = tls->prev;
+    pthread_mutex_unlock (&ctx->tls_lock);
+    free (tls);
+}
+
+//------------------------------------------------------------------------------
+// 현재 thread 의 context 항목 buffer (처음 요청시 생성, 실패하면 thread 공용 buffer)
+//------------------------------------------------------------------------------
+static char *data_tls_get (wttr_ctx_t *ctx, int index)
+{
+    struct data_tls *tls;
+
+    if (!ctx->tls_ok)
+        return DataTls[index];
+    if ((tls = pthread_getspecific (ctx->tls_key)) != NULL)
+        return tls->data[index];
+
+    if ((tls = malloc (sizeof(struct data_tls))) == NULL)
+        return DataTls[index];
+    tls->ctx  = ctx;
+    tls->prev = NULL;
+
+    pthread_mutex_lock   (&ctx->tls_lock);
+    if ((tls->next = ctx->tls_list) != NULL)
+        tls->next->prev = tls;
+    ctx->tls_list = tls;
+    pthread_mutex_unlock (&ctx->tls_lock);
+
+    if (pthread_setspecific (ctx->tls_key, tls)) {
+        data_tls_free (tls);
+        return DataTls[index];
+    }
+    return tls->data[index];
+}
+
+//------------------------------------------------------------------------------
+// context 초기화 (WttrData table 을 초기값으로 복사)
+//------------------------------------------------------------------------------
+static void wttr_ctx_init (wttr_ctx_t *ctx)
+{
+    wttr_result_t res;
+
+    pthread_condattr_t attr;
+
+    wttr_result_init (&res);
+    pthread_mutex_init (&ctx->mutex, NULL);
+    ctx->seq = 0;
+    wttr_snap_build (&ctx->snap, &res);
+    ctx->cond_loc = WTTR_LOC_INVALID;
+    memset (&ctx->cond, 0, sizeof(wttr_cond_t));
+    ctx->snap_path  = NULL;
+    ctx->snap_saved = 0;
+    ctx->stale      = 0;
+    ctx->snap_gen   = 0;
+    ctx->snap_done  = 0;
+    pthread_mutex_init (&ctx->save_lock, NULL);
+    ctx->shm        = NULL;
+    ctx->shm_fd     = -1;
+
+    pthread_condattr_init (&attr);
+    pthread_condattr_setclock (&attr, CLOCK_MONOTONIC);
+    pthread_cond_init  (&ctx->refresh_cond, &attr);
+    pthread_condattr_destroy (&attr);
+    pthread_mutex_init (&ctx->refresh_lock, NULL);
+    ctx->refresh_run = 0;
+    ctx->refresh_loc = WTTR_LOC_INVALID;
+
+    pthread_mutex_init (&ctx->tls_lock, NULL);
+    ctx->tls_list = NULL;
+    ctx->tls_ok   = (pthread_key_create (&ctx->tls_key, data_tls_free) == 0);
+}
+
+static void default_ctx_init (void)
+{
+    wttr_ctx_init (&DefaultCtx);
+}
+
+wttr_ctx_t *wttr_default_ctx (void)
+{
+    pthread_once (&DefaultCtxOnce, default_ctx_init);
+    return &DefaultCtx;
+}
+
+//------------------------------------------------------------------------------
+// 지역별 context 생성/삭제
+//------------------------------------------------------------------------------
+wttr_ctx_t *wttr_ctx_create (void)
+{
+    wttr_ctx_t *ctx = malloc (sizeof(wttr_ctx_t));
+
+    if (ctx) wttr_ctx_init (ctx);
+    return ctx;
+}
+
+void wttr_ctx_destroy (wttr_ctx_t *ctx)
+{
+    if (!ctx || ctx == &DefaultCtx) return;
+
+    wttr_ctx_refresh_stop (ctx);
+    pthread_cond_destroy  (&ctx->refresh_cond);
+    pthread_mutex_destroy (&ctx->refresh_lock);
+    pthread_mutex_destroy (&ctx->mutex);
+    pthread_mutex_destroy (&ctx->save_lock);
+    free (ctx->snap_path);
+    shm_unmap (ctx);
+
+    /* key 를 지운 뒤에는 thread 종료시 destructor 가 호출되지 않으므로 남은 buffer 를 모두 해제 */
+    if (ctx->tls_ok)
+        pthread_key_delete (ctx->tls_key);
+    while (ctx->tls_list) {
+        struct data_tls *tls = ctx->tls_list;
+        ctx->tls_list = tls->next;
+        free (tls);
+    }
+    pthread_mutex_destroy (&ctx->tls_lock);
+    free (ctx);
+}
+
+//------------------------------------------------------------------------------
+// snapshot 파일 읽기 (mmap), header/checksum 이 맞지 않으면 사용하지 않음
+//------------------------------------------------------------------------------
+static int snap_file_load (wttr_ctx_t *ctx, const char *path)
+{
+    struct snap_file_hdr hdr;
+    struct snap_buf b;
+    struct stat st;
+    wttr_result_t res;
+    wttr_snap_t *snap;
+    wttr_loc_t loc = WTTR_LOC_INVALID;
+    int32_t tm[9] = { 0 }, fc_cnt;
+    void *map;
+    int fd, ok = 0;
+
+    if ((fd = open (path, O_RDONLY)) < 0)
+        return 0;
+    if (fstat (fd, &st) || st.st_size < (off_t)sizeof(hdr) ||
+        (map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+        close (fd);
+        return 0;
+    }
+    close (fd);
+
+    memcpy (&hdr, map, sizeof(hdr));
+    if (memcmp (hdr.magic, SNAP_MAGIC, sizeof(hdr.magic)) || hdr.version != SNAP_VERSION ||
+        hdr.endian != SNAP_ENDIAN || hdr.fc_cols != eWTTR_FC_COL_END ||
+        hdr.payload > (uint64_t)st.st_size - sizeof(hdr) ||
+        hdr.checksum != payload_hash (PAYLOAD_HASH_INIT, (const char *)map + sizeof(hdr), hdr.payload))
+        goto out;
+
+    if (!(snap = malloc (sizeof(wttr_snap_t))))
+        goto out;
+
+    /* 항목 이름 등은 현재 table 을 사용하고 저장된 값만 덮어씀 */
+    wttr_result_init (&res);
+    wttr_snap_build  (snap, &res);
+
+    b.p   = (unsigned char *)map + sizeof(hdr);
+    b.end = b.p + hdr.payload;
+    ok = snap_get_loc (&b, &loc) && snap_get (&b, tm, sizeof(tm));
+    /* 읽기 실패시 tm 은 0 (ok 가 아니면 snap 은 사용하지 않음) */
+    snap->obs_tm.tm_sec  = tm[0];   snap->obs_tm.tm_min  = tm[1];   snap->obs_tm.tm_hour  = tm[2];
+    snap->obs_tm.tm_mday = tm[3];   snap->obs_tm.tm_mon  = tm[4];   snap->obs_tm.tm_year  = tm[5];
+    snap->obs_tm.tm_wday = tm[6];   snap->obs_tm.tm_yday = tm[7];   snap->obs_tm.tm_isdst = tm[8];
+
+    for (uint32_t i = 0; ok && i < hdr.item_cnt; i++) {
+        int32_t id, ival;
+        double fval;
+        char str [WTTR_DATA_SIZE];
+        int idx;
+
+        ok = snap_get (&b, &id, sizeof(id)) && snap_get (&b, &ival, sizeof(ival)) &&
+             snap_get (&b, &fval, sizeof(fval)) && snap_get_str (&b, str, sizeof(str));
+        /* 이후 version 에서 없어진 항목은 무시 */
+        if (ok && (idx = wttr_item_index ((enum eWttrItem)id)) >= 0) {
+            strcpy (snap->data[idx].data_str, str);
+            snap->ival[idx] = ival;
+            snap->fval[idx] = fval;
+        }
+    }
+
+    ok = ok && snap_get (&b, &fc_cnt, sizeof(fc_cnt)) && fc_cnt >= 0 && fc_cnt <= WTTR_FC_MAX;
+    snap->fc.cnt = ok ? fc_cnt : 0;
+    for (int i = 0; ok && i < snap->fc.cnt; i++) {
+        int64_t t;
+        int16_t code;
+
+        ok = snap_get (&b, &t, sizeof(t)) && snap_get (&b, &code, sizeof(code));
+        snap->fc.time[i] = (time_t)t;
+        snap->fc.code[i] = code;
+        for (int c = 0; ok && c < eWTTR_FC_COL_END; c++)
+            ok = snap_get (&b, &snap->fc.col[c][i], sizeof(float));
+    }
+
+    /* 위치 이름은 grid 가 같을 때만 위치 cache 에 추가 */
+    for (uint32_t i = 0; ok && i < hdr.geo_cnt; i++) {
+        int64_t q[2];
+        char lang[4], city[256], country[256];
+
+        ok = snap_get (&b, q, sizeof(q)) && snap_get (&b, lang, sizeof(lang)) &&
+             snap_get_str (&b, city, sizeof(city)) && snap_get_str (&b, country, sizeof(country));
+        lang[sizeof(lang) - 1] = '\0';
+
+        pthread_mutex_lock (&GeoLock);
+        if (ok && hdr.geo_grid == GeoGrid) {
+            struct geo_entry *e;
+
+            if (!geo_find ((long)q[0], (long)q[1], lang) &&
+                (e = geo_insert ((long)q[0], (long)q[1], lang, city, country)) != NULL)
+                geo_file_append (e);
+        }
+        pthread_mutex_unlock (&GeoLock);
+    }
+
+    if (ok) {
+        pthread_mutex_lock   (&ctx->mutex);
+        __atomic_store_n (&ctx->seq, ctx->seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence (__ATOMIC_RELEASE);
+        memcpy (&ctx->snap, snap, sizeof(wttr_snap_t));
+        __atomic_store_n (&ctx->seq, ctx->seq + 1, __ATOMIC_RELEASE);
+
+        /* 같은 응답이면 첫 업데이트가 UNCHANGED 가 되도록 hash 를 유지 */
+        ctx->cond_loc = loc;
+        memset (&ctx->cond, 0, sizeof(wttr_cond_t));
+        ctx->cond.hash  = (loc >= 0) ? hdr.hash : 0;
+        ctx->snap_saved = (time_t)hdr.saved;
+        ctx->stale = 1;
+        if (ctx->shm)
+            shm_write (ctx);
+        pthread_mutex_unlock (&ctx->mutex);
+    }
+    free (snap);
+out:
+    munmap (map, st.st_size);
+    #if defined (__LIB_WEATHER_DEBUG__)
+        if (!ok)    fprintf (stderr, "%s : %s is not a valid snapshot\n", __func__, path);
+    #endif
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+// snapshot 파일 설정 및 읽기, 이후 업데이트마다 파일에 저장함 (path = NULL 이면 저장안함)
+// 반환값 = 1 (파일의 값을 읽음, stale 상태) / 0 (파일 없음 또는 사용할 수 없는 파일)
+//------------------------------------------------------------------------------
+int wttr_ctx_snapshot_open (wttr_ctx_t *ctx, const char *path)
+{
+    char *new_path = path ? strdup (path) : NULL, *old_path;
+
+    if (!ctx || (path && !new_path)) {
+        free (new_path);
+        return 0;
+    }
+    pthread_mutex_lock   (&ctx->mutex);
+    old_path = ctx->snap_path;
+    ctx->snap_path = new_path;
+    pthread_mutex_unlock (&ctx->mutex);
+    free (old_path);
+
+    return path ? snap_file_load (ctx, path) : 0;
+}
+
+//------------------------------------------------------------------------------
+// 현재 snapshot 저장 (위치 이름을 요청한 뒤 바로 저장할 때 사용)
+//------------------------------------------------------------------------------
+int wttr_ctx_snapshot_save (wttr_ctx_t *ctx)
+{
+    struct snap_save job;
+
+    if (!ctx) return 0;
+
+    pthread_mutex_lock   (&ctx->mutex);
+    snap_save_prepare (ctx, &job);
+    pthread_mutex_unlock (&ctx->mutex);
+
+    return snap_save_commit (ctx, &job);
+}
+
+//------------------------------------------------------------------------------
+// 파일에서 읽은 값을 아직 업데이트하지 못했으면 1, saved = 파일 저장 시간
+//------------------------------------------------------------------------------
+int wttr_ctx_is_stale (wttr_ctx_t *ctx, time_t *saved)
+{
+    int stale;
+
+    if (!ctx) return 0;
+
+    pthread_mutex_lock   (&ctx->mutex);
+    stale = ctx->stale;
+    if (saved)  *saved = stale ? ctx->snap_saved : 0;
+    pthread_mutex_unlock (&ctx->mutex);
+    return stale;
+}
+
+//------------------------------------------------------------------------------
+// 공유 메모리 segment 를 만들고(또는 이전 daemon 의 segment 를 다시 사용) 이후
+// 업데이트마다 게시함. name = "/wttr" 형식 (shm_open), 쓰는 process 는 하나만 가능.
+// 반환값 = 1 (성공) / 0 (실패 또는 다른 daemon 이 사용중)
+//------------------------------------------------------------------------------
+int wttr_ctx_shm_open (wttr_ctx_t *ctx, const char *name)
+{
+    struct shm_seg *seg;
+    struct stat st;
+    int fd;
+
+    if (!ctx || !name)
+        return 0;
+
+    if ((fd = shm_open (name, O_CREAT | O_RDWR, 0644)) < 0) {
+        fprintf (stderr, "%s : %s open error (%s)\n", __func__, name, strerror (errno));
+        return 0;
+    }
+    /* 다른 daemon 이 쓰고 있으면 사용안함 (process 가 종료되면 lock 이 풀림) */
+    if (flock (fd, LOCK_EX | LOCK_NB)) {
+        fprintf (stderr, "%s : %s is used by another writer\n", __func__, name);
+        close (fd);
+        return 0;
+    }
+    if (fstat (fd, &st) || (st.st_size != sizeof(struct shm_seg) &&
+                            ftruncate (fd, sizeof(struct shm_seg)))) {
+        close (fd);
+        return 0;
+    }
+    seg = mmap (NULL, sizeof(struct shm_seg), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (seg == MAP_FAILED) {
+        close (fd);
+        return 0;
+    }
+
+    /* 같은 구조의 segment 이면 generation 을 이어서 사용 (기다리는 reader 가 있을 수 있음) */
+    if (seg->magic != SHM_MAGIC || seg->version != SHM_VERSION || seg->size != sizeof(struct shm_seg)) {
+        memset (seg, 0, sizeof(struct shm_seg));
+        seg->version = SHM_VERSION;
+        seg->size    = sizeof(struct shm_seg);
+        __atomic_store_n (&seg->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+    }
+    else if (seg->seq & 1) {
+        /* 이전 daemon 이 게시 중 종료됨 */
+        __atomic_store_n (&seg->seq, seg->seq + 1, __ATOMIC_RELEASE);
+    }
+    seg->writer_pid = (int32_t)getpid ();
+
+    pthread_mutex_lock   (&ctx->mutex);
+    shm_unmap (ctx);
+    ctx->shm    = seg;
+    ctx->shm_fd = fd;
+    /* 이미 업데이트(또는 snapshot 파일을 읽은) 값이 있으면 바로 게시 */
+    if (__atomic_load_n (&ctx->seq, __ATOMIC_RELAXED))
+        shm_write (ctx);
+    pthread_mutex_unlock (&ctx->mutex);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 현재 snapshot 을 다시 게시 (get_location_json 으로 위치 이름을 받은 뒤)
+//------------------------------------------------------------------------------
+int wttr_ctx_shm_publish (wttr_ctx_t *ctx)
+{
+    int ret = 0;
+
+    if (!ctx) return 0;
+
+    pthread_mutex_lock   (&ctx->mutex);
+    if (ctx->shm) {
+        shm_write (ctx);
+        ret = 1;
+    }
+    pthread_mutex_unlock (&ctx->mutex);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// 게시 중지, segment 는 남겨두므로 reader 는 마지막 값을 계속 읽을 수 있음 (writer_pid = 0)
+//------------------------------------------------------------------------------
+void wttr_ctx_shm_close (wttr_ctx_t *ctx)
+{
+    if (!ctx) return;
+
+    pthread_mutex_lock   (&ctx->mutex);
+    shm_unmap (ctx);
+    pthread_mutex_unlock (&ctx->mutex);
+}
+
+//------------------------------------------------------------------------------
+// 공유 메모리 reader (network, lock 사용안함)
+//------------------------------------------------------------------------------
+struct wttr_shm__t {
+    const struct shm_seg    *seg;
+};
+
+wttr_shm_t *wttr_shm_attach (const char *name)
+{
+    const struct shm_seg *seg;
+    wttr_shm_t *shm;
+    struct stat st;
+    int fd;
+
+    if (!name || (fd = shm_open (name, O_RDONLY, 0)) < 0)
+        return NULL;
+
+    if (fstat (fd, &st) || st.st_size != sizeof(struct shm_seg)) {
+        close (fd);
+        return NULL;
+    }
+    seg = mmap (NULL, sizeof(struct shm_seg), PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);
+    if (seg == MAP_FAILED)
+        return NULL;
+
+    if (__atomic_load_n (&seg->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC ||
+        seg->version != SHM_VERSION || seg->size != sizeof(struct shm_seg) ||
+        !(shm = malloc (sizeof(wttr_shm_t)))) {
+        munmap ((void *)seg, sizeof(struct shm_seg));
+        return NULL;
+    }
+    shm->seg = seg;
+    return shm;
+}
+
+void wttr_shm_detach (wttr_shm_t *shm)
+{
+    if (!shm) return;
+
+    munmap ((void *)shm->seg, sizeof(struct shm_seg));
+    free (shm);
+}
+
+//------------------------------------------------------------------------------
+// seqlock read (wttr_ctx_read 와 같은 방식), 반환값 = 읽은 값의 generation
+//------------------------------------------------------------------------------
+static unsigned int shm_read (const struct shm_seg *seg, void *dst, const void *src, size_t size)
+{
+    unsigned int seq;
+
+    for (;;) {
+        while ((seq = __atomic_load_n (&seg->seq, __ATOMIC_ACQUIRE)) & 1)
+            sched_yield ();
+        memcpy (dst, src, size);
+        __atomic_thread_fence (__ATOMIC_ACQUIRE);
+        if (__atomic_load_n (&seg->seq, __ATOMIC_RELAXED) == seq)
+            return seq / 2;
+    }
+}
+
+//------------------------------------------------------------------------------
+// 게시 횟수 (0 = 아직 값 없음), 값이 바뀌었는지 확인할 때 사용
+//------------------------------------------------------------------------------
+unsigned int wttr_shm_generation (wttr_shm_t *shm)
+{
+    return shm ? __atomic_load_n (&shm->seg->seq, __ATOMIC_ACQUIRE) / 2 : 0;
+}
+
+//------------------------------------------------------------------------------
+// generation 이 gen 과 달라질 때까지 대기 (timeout_ms < 0 이면 계속 대기)
+// 반환값 = 현재 generation (timeout 이면 gen 그대로)
+//------------------------------------------------------------------------------
+unsigned int wttr_shm_wait (wttr_shm_t *shm, unsigned int gen, int timeout_ms)
+{
+    struct timespec end, ts;
+    unsigned int seq;
+
+    if (!shm) return 0;
+
+    clock_gettime (CLOCK_MONOTONIC, &end);
+    end.tv_sec  += timeout_ms / 1000;
+    end.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (end.tv_nsec >= 1000000000L) {
+        end.tv_sec++;
+        end.tv_nsec -= 1000000000L;
+    }
+
+    while (((seq = __atomic_load_n (&shm->seg->seq, __ATOMIC_ACQUIRE)) & 1) || seq / 2 == gen) {
+        if (timeout_ms >= 0) {
+            clock_gettime (CLOCK_MONOTONIC, &ts);
+            ts.tv_sec  = end.tv_sec  - ts.tv_sec;
+            ts.tv_nsec = end.tv_nsec - ts.tv_nsec;
+            if (ts.tv_nsec < 0) {
+                ts.tv_sec--;
+                ts.tv_nsec += 1000000000L;
+            }
+            if (ts.tv_sec < 0)
+                return gen;
+        }
+        /* 게시 중(홀수)이면 잠깐 양보, 아니면 writer 의 FUTEX_WAKE 까지 대기 */
+        if (seq & 1)
+            sched_yield ();
+        else
+            shm_futex ((uint32_t *)&shm->seg->seq, FUTEX_WAIT, seq,
+                       timeout_ms >= 0 ? &ts : NULL);
+    }
+    return seq / 2;
+}
+
+//------------------------------------------------------------------------------
+// 항목 값 (wttr_ctx_get_* 와 같음), 아직 값이 없으면 0
+//------------------------------------------------------------------------------
+int wttr_shm_get_data_buf (wttr_shm_t *shm, enum eWttrItem id, char *buf, size_t size)
+{
+    char str [WTTR_DATA_SIZE];
+    int idx = wttr_item_index (id);
+
+    if (!shm || idx < 0 || !buf || !size)
+        return 0;
+
+    if (!shm_read (shm->seg, str, shm->seg->str[idx], sizeof(str)))
+        return 0;
+    str[WTTR_DATA_SIZE - 1] = '\0';
+    snprintf (buf, size, "%s", str);
+    return 1;
+}
+
+int wttr_shm_get_int (wttr_shm_t *shm, enum eWttrItem id)
+{
+    int32_t val = 0;
+    int idx = wttr_item_index (id);
+
+    if (shm && idx >= 0)
+        shm_read (shm->seg, &val, &shm->seg->ival[idx], sizeof(val));
+    return val;
+}
+
+double wttr_shm_get_float (wttr_shm_t *shm, enum eWttrItem id)
+{
+    double val = 0;
+    int idx = wttr_item_index (id);
+
+    if (shm && idx >= 0)
+        shm_read (shm->seg, &val, &shm->seg->fval[idx], sizeof(val));
+    return val;
+}
+
+int wttr_shm_get_tm (wttr_shm_t *shm, struct tm *t)
+{
+    if (!shm || !t)
+        return 0;
+    return shm_read (shm->seg, t, &shm->seg->obs_tm, sizeof(struct tm)) ? 1 : 0;
+}
+
+int wttr_shm_get_forecast (wttr_shm_t *shm, wttr_forecast_t *fc)
+{
+    if (!shm || !fc)
+        return 0;
+    if (!shm_read (shm->seg, fc, &shm->seg->fc, sizeof(wttr_forecast_t)))
+        fc->cnt = 0;
+    return fc->cnt;
+}
+
+//------------------------------------------------------------------------------
+// daemon 이 받아둔 위치 이름 (get_location_json 결과), 없으면 0
+//------------------------------------------------------------------------------
+int wttr_shm_get_location (wttr_shm_t *shm, int is_kor, char *city, char *country, size_t size)
+{
+    char name [2][SHM_NAME_SIZE];
+    int g = is_kor ? SHM_GEO_KO : SHM_GEO_EN;
+    unsigned int gen;
+
+    if (!shm || !city || !country || !size)
+        return 0;
+
+    /* city, country 는 같은 게시에서 읽어야 함 */
+    do {
+        gen = shm_read (shm->seg, name[0], shm->seg->city[g], SHM_NAME_SIZE);
+    } while (shm_read (shm->seg, name[1], shm->seg->country[g], SHM_NAME_SIZE) != gen);
+
+    if (!gen || !name[0][0])
+        return 0;
+    name[0][SHM_NAME_SIZE - 1] = name[1][SHM_NAME_SIZE - 1] = '\0';
+    str_copy (city,    size, name[0]);
+    str_copy (country, size, name[1]);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 게시 시간, stale(snapshot 파일의 값) 상태, 반환값 = writer pid (0 = daemon 종료)
+//------------------------------------------------------------------------------
+int wttr_shm_info (wttr_shm_t *shm, time_t *updated, int *stale)
+{
+    struct { int32_t pid, stale; int64_t updated; } info;
+
+    if (!shm) return 0;
+
+    shm_read (shm->seg, &info, &shm->seg->writer_pid, sizeof(info));
+    if (updated)    *updated = (time_t)info.updated;
+    if (stale)      *stale   = info.stale;
+
+    /* daemon 이 signal 로 종료되어 writer_pid 를 지우지 못한 경우 */
+    if (info.pid && kill (info.pid, 0) && errno == ESRCH)
+        info.pid = 0;
+    return info.pid;
+}
+
+//------------------------------------------------------------------------------
+// 기본 context 에 Json 날씨데이터 파싱 및 저장
+//------------------------------------------------------------------------------
+void parse_weather(const char *json)
+{
+    wttr_ctx_apply_json (wttr_default_ctx(), json);
+}
+
+//------------------------------------------------------------------------------
+// 응답 파싱 방식 설정 (기본값 eWTTR_PARSE_CJSON)
+//------------------------------------------------------------------------------
+void wttr_set_parse_mode (enum eWttrParse mode)
+{
+    __atomic_store_n (&ParseMode, mode, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+// 수신된 Json 을 지정한 방식으로 파싱하여 context 에 저장
+// streaming 방식은 cURL 과 같은 크기(CURL_MAX_WRITE_SIZE)로 나누어 전달함.
+//------------------------------------------------------------------------------
+int wttr_ctx_parse (wttr_ctx_t *ctx, const char *json, size_t len, enum eWttrParse mode)
+{
+    wttr_result_t res;
+
+    if (!ctx || !json) return 0;
+
+    if (mode == eWTTR_PARSE_CJSON)
+        return wttr_ctx_apply_json (ctx, json);
+
+    wttr_stream_t st;
+
+    wttr_result_init (&res);
+    stream_init (&st, res.data, WTTR_ITEM_CNT);
+
+    for (size_t pos = 0; pos < len; pos += CURL_MAX_WRITE_SIZE) {
+        size_t size = (len - pos < CURL_MAX_WRITE_SIZE) ? len - pos : CURL_MAX_WRITE_SIZE;
+
+        if (!WriteStreamCallback ((void *)&json[pos], 1, size, &st))
+            return 0;
+    }
+    if (!stream_finish (&st))
+        return 0;
+
+    wttr_ctx_store (ctx, &res);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 측정시간[eWTTR_LOBS_DATE] (WttrData struct) 데이터 변환
+//------------------------------------------------------------------------------
+void get_wttr_date (const char *obs_data, struct tm *t)
+{
+    // Local Obs Data : "2025-05-20 12:14 PM"
+    strptime (obs_data, "%Y-%m-%d %I:%M %p", t);
+    /* mktime (t);  // 자동으로 overflow 조정 */
+
+    #if defined (__LIB_WEATHER_DEBUG__)
+        printf("관측 시각: %d년 %d월 %d일 %d시 %d분 %d요일 %d일/356일\n",
+            t->tm_year + 1900,
+            t->tm_mon + 1,
+            t->tm_mday,
+            t->tm_hour,
+            t->tm_min,
+            t->tm_wday,
+            t->tm_yday + 1
+        );
+    #endif
+}
+
+//------------------------------------------------------------------------------
+// context data 요청
+// 반환값은 context 별, thread 별 buffer 로, 같은 thread 에서 같은 context 의 같은 항목을
+// 다시 요청하거나 context 를 삭제하기 전까지 유효 (다른 context 의 값은 덮어쓰지 않음)
+//------------------------------------------------------------------------------
+const char *wttr_ctx_get_data (wttr_ctx_t *ctx, enum eWttrItem id)
+{
+    int index = wttr_item_index (id);
+    char *data;
+
+    if (!ctx || index < 0) return NULL;
+
+    data = data_tls_get (ctx, index);
+    wttr_ctx_read (ctx, data, ctx->snap.data[index].data_str, WTTR_DATA_SIZE);
+    return data;
+}
+
+//------------------------------------------------------------------------------
+// context data 를 buf 에 복사 (다른 thread 의 update 와 동시에 사용가능)
+//------------------------------------------------------------------------------
+int wttr_ctx_get_data_buf (wttr_ctx_t *ctx, enum eWttrItem id, char *buf, size_t size)
+{
+    int index = wttr_item_index (id);
+    char data [WTTR_DATA_SIZE];
+
+    if (!ctx || !buf || !size || index < 0) return 0;
+
+    wttr_ctx_read (ctx, data, ctx->snap.data[index].data_str, WTTR_DATA_SIZE);
+    snprintf (buf, size, "%s", data);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 숫자 값 요청 (update 시점에 변환된 값, 숫자가 아닌 항목은 0)
+//------------------------------------------------------------------------------
+int wttr_ctx_get_int (wttr_ctx_t *ctx, enum eWttrItem id)
+{
+    int index = wttr_item_index (id), val;
+
+    if (!ctx || index < 0) return 0;
+
+    wttr_ctx_read (ctx, &val, &ctx->snap.ival[index], sizeof(val));
+    return val;
+}
+
+double wttr_ctx_get_float (wttr_ctx_t *ctx, enum eWttrItem id)
+{
+    int index = wttr_item_index (id);
+    double val;
+
+    if (!ctx || index < 0) return 0;
+
+    wttr_ctx_read (ctx, &val, &ctx->snap.fval[index], sizeof(val));
+    return val;
+}
+
+//------------------------------------------------------------------------------
+// 측정시간[eWTTR_LOBS_DATE] 요청 (update 시점에 변환된 값)
+//------------------------------------------------------------------------------
+int wttr_ctx_get_tm (wttr_ctx_t *ctx, struct tm *t)
+{
+    if (!ctx || !t) return 0;
+
+    wttr_ctx_read (ctx, t, &ctx->snap.obs_tm, sizeof(struct tm));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 기본 context 숫자/시간 값 요청
+//------------------------------------------------------------------------------
+int get_wttr_int (enum eWttrItem id)
+{
+    return wttr_ctx_get_int (wttr_default_ctx(), id);
+}
+
+double get_wttr_float (enum eWttrItem id)
+{
+    return wttr_ctx_get_float (wttr_default_ctx(), id);
+}
+
+int get_wttr_tm (struct tm *t)
+{
+    return wttr_ctx_get_tm (wttr_default_ctx(), t);
+}
+
+//------------------------------------------------------------------------------
+// 예보(weather) 요청, 반환값 = 예보 시각 수
+//------------------------------------------------------------------------------
+int wttr_ctx_get_forecast (wttr_ctx_t *ctx, wttr_forecast_t *fc)
+{
+    if (!ctx || !fc) return 0;
+
+    wttr_ctx_read (ctx, fc, &ctx->snap.fc, sizeof(wttr_forecast_t));
+    return fc->cnt;
+}
+
+int get_wttr_forecast (wttr_forecast_t *fc)
+{
+    return wttr_ctx_get_forecast (wttr_default_ctx(), fc);
+}
+
+//------------------------------------------------------------------------------
+// 예보 시각 범위 [from, to) 의 시작/끝 index (시간 순서로 저장되어 있음)
+//------------------------------------------------------------------------------
+static int forecast_lower (const wttr_forecast_t *fc, time_t t)
+{
+    int lo = 0, hi = fc->cnt;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (fc->time[mid] < t)  lo = mid + 1;
+        else                    hi = mid;
+    }
+    return lo;
+}
+
+//------------------------------------------------------------------------------
+// 예보 열(column)의 시간 범위 [from, to) 통계, 반환값 = 범위내 예보 수
+//------------------------------------------------------------------------------
+int wttr_forecast_stats (const wttr_forecast_t *fc, enum eWttrFcCol col,
+                         time_t from, time_t to, wttr_fc_stats_t *stats)
+{
+    int start, end;
+    const float *v;
+    float min, max, sum = 0;
+
+    if (!fc || !stats || col < 0 || col >= eWTTR_FC_COL_END) return 0;
+
+    memset (stats, 0, sizeof(wttr_fc_stats_t));
+
+    start = forecast_lower (fc, from);
+    end   = forecast_lower (fc, to);
+    if (start >= end)   return 0;
+
+    /* 연속된 열 구간 : 분기 없는 loop (float 합계는 -ffast-math 에서 벡터화됨) */
+    v   = &fc->col[col][start];
+    min = max = v[0];
+    for (int i = 0; i < end - start; i++) {
+        min  = (v[i] < min) ? v[i] : min;
+        max  = (v[i] > max) ? v[i] : max;
+        sum += v[i];
+    }
+    stats->cnt  = end - start;
+    stats->min  = min;
+    stats->max  = max;
+    stats->mean = sum / stats->cnt;
+    return stats->cnt;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// wttr.in 응답 cache (LRU, TTL, stale-while-revalidate)
+// key = 지역 registry handle, 값 = 파싱된 snapshot
+// TTL 이 지난 항목은 기존 snapshot 을 바로 돌려주고 background 에서 갱신함.
+//------------------------------------------------------------------------------
+#define CACHE_HASH_SIZE     256
+#define CACHE_MAX_BYTES     (256 * 1024)
+
+struct cache_entry {
+    struct cache_entry  *prev, *next;   /* LRU list (head = 최근 사용) */
+    struct cache_entry  *hnext;         /* hash chain */
+    wttr_loc_t          loc;            /* registry handle (key) */
+    size_t              bytes;
+    time_t              fetched;        /* CLOCK_MONOTONIC sec */
+    int                 refreshing;
+    wttr_result_t       res;
+};
+
+enum { CACHE_MISS = 0, CACHE_HIT, CACHE_STALE };
+
+static pthread_mutex_t      CacheLock = PTHREAD_MUTEX_INITIALIZER;
+static struct cache_entry   *CacheHash [CACHE_HASH_SIZE];
+static struct cache_entry   *CacheHead = NULL, *CacheTail = NULL;
+static int                  CacheTTL = 0;       /* 0 = cache 사용안함 */
+static size_t               CacheMaxBytes = CACHE_MAX_BYTES;
+static wttr_cache_stats_t   CacheStats;
+
+static time_t cache_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+static void cache_lru_unlink (struct cache_entry *e)
+{
+    if (e->prev) e->prev->next = e->next; else CacheHead = e->next;
+    if (e->next) e->next->prev = e->prev; else CacheTail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void cache_lru_push (struct cache_entry *e)
+{
+    e->prev = NULL;
+    e->next = CacheHead;
+    if (CacheHead)  CacheHead->prev = e;
+    CacheHead = e;
+    if (!CacheTail) CacheTail = e;
+}
+
+static struct cache_entry *cache_find (wttr_loc_t loc)
+{
+    struct cache_entry *e = CacheHash[loc % CACHE_HASH_SIZE];
+
+    for (; e; e = e->hnext)
+        if (e->loc == loc) return e;
+    return NULL;
+}
+
+static void cache_remove (struct cache_entry *e)
+{
+    struct cache_entry **pe = &CacheHash[e->loc % CACHE_HASH_SIZE];
+
+    while (*pe != e) pe = &(*pe)->hnext;
+    *pe = e->hnext;
+
+    cache_lru_unlink (e);
+    CacheStats.entries--;
+    CacheStats.bytes -= e->bytes;
+    free (e);
+}
+
+//------------------------------------------------------------------------------
+// 메모리 제한을 넘으면 오래 사용하지 않은 항목부터 제거 (CacheLock 상태에서 호출)
+//------------------------------------------------------------------------------
+static void cache_trim (void)
+{
+    while (CacheTail && CacheStats.bytes > CacheMaxBytes) {
+        cache_remove (CacheTail);
+        CacheStats.evict++;
+    }
+}
+
+//------------------------------------------------------------------------------
+// cache 조회, HIT/STALE 인 경우 res 에 파싱 결과 복사
+// STALE 이고 갱신중이 아니면 *refresh = 1 (호출한 곳에서 갱신 요청)
+//------------------------------------------------------------------------------
+static int cache_lookup (wttr_loc_t loc, wttr_result_t *res, int *refresh)
+{
+    struct cache_entry *e;
+    int ret = CACHE_MISS;
+
+    *refresh = 0;
+
+    pthread_mutex_lock (&CacheLock);
+    if ((e = cache_find (loc)) != NULL) {
+        memcpy (res, &e->res, sizeof(wttr_result_t));
+        cache_lru_unlink (e);
+        cache_lru_push   (e);
+
+        if (cache_now () - e->fetched < CacheTTL) {
+            CacheStats.hit++;
+            ret = CACHE_HIT;
+        } else {
+            CacheStats.stale++;
+            ret = CACHE_STALE;
+            if (!e->refreshing)
+                *refresh = e->refreshing = 1;
+        }
+    } else {
+        CacheStats.miss++;
+    }
+    pthread_mutex_unlock (&CacheLock);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// cache 저장 (res == NULL 이면 갱신 실패, refreshing 상태만 해제)
+//------------------------------------------------------------------------------
+static void cache_store (wttr_loc_t loc, const wttr_result_t *res)
+{
+    struct cache_entry *e;
+
+    pthread_mutex_lock (&CacheLock);
+    if (!CacheTTL || loc < 0) goto out;
+
+    if (!(e = cache_find (loc))) {
+        if (!res) goto out;
+        if (!(e = calloc (1, sizeof(struct cache_entry))))  goto out;
+
+        e->loc   = loc;
+        e->bytes = sizeof(struct cache_entry);
+        e->hnext = CacheHash[loc % CACHE_HASH_SIZE];
+        CacheHash[loc % CACHE_HASH_SIZE] = e;
+        cache_lru_push (e);
+
+        CacheStats.entries++;
+        CacheStats.bytes += e->bytes;
+    }
+    e->refreshing = 0;
+    if (res) {
+        memcpy (&e->res, res, sizeof(wttr_result_t));
+        e->fetched = cache_now ();
+    }
+    cache_trim ();
+out:
+    pthread_mutex_unlock (&CacheLock);
+}
+
+//------------------------------------------------------------------------------
+// cache 설정, ttl_sec = 0 이면 cache 사용안함(모든 항목 삭제)
+// max_bytes = 0 이면 기본값(CACHE_MAX_BYTES)
+//------------------------------------------------------------------------------
+void wttr_cache_config (int ttl_sec, size_t max_bytes)
+{
+    pthread_mutex_lock (&CacheLock);
+    CacheTTL      = (ttl_sec > 0) ? ttl_sec : 0;
+    CacheMaxBytes = max_bytes ? max_bytes : CACHE_MAX_BYTES;
+
+    if (!CacheTTL) {
+        while (CacheHead) cache_remove (CacheHead);
+    }
+    cache_trim ();
+    pthread_mutex_unlock (&CacheLock);
+}
+
+void wttr_cache_get_stats (wttr_cache_stats_t *stats)
+{
+    if (!stats) return;
+
+    pthread_mutex_lock (&CacheLock);
+    memcpy (stats, &CacheStats, sizeof(wttr_cache_stats_t));
+    pthread_mutex_unlock (&CacheLock);
+}
+
+//------------------------------------------------------------------------------
+// provider 요청 (hedged request)
+// 주 provider 에 요청한 뒤 최근 p95 시간이 지나도 응답이 없거나 요청이 실패하면 보조
+// provider 에도 요청하고, 먼저 도착한 정상 응답을 사용함 (늦은 요청은 취소).
+// 두 요청 모두 남은 시간 budget 안에서만 진행되며 재시도는 하지 않음.
+// 반환값 = wttr_fetch_once 와 같음
+//------------------------------------------------------------------------------
+enum { HEDGE_IDLE = 0, HEDGE_WAIT, HEDGE_RUNNING, HEDGE_DONE, HEDGE_FAILED };
+
+struct hedge_req {
+    int                     ep;
+    int                     state;      /* HEDGE_xxx */
+    const wttr_provider_t   *provider;
+    char                    url [512];
+    CURL                    *curl;
+    struct MemoryStruct     chunk;
+    struct curl_slist       *hdr;
+    long long               start;      /* 요청 시작 (HEDGE_WAIT 이면 시작할) 시간 (us) */
+};
+
+//------------------------------------------------------------------------------
+// gate 허가, token 을 기다려야 하면 start 시간까지 HEDGE_WAIT
+//------------------------------------------------------------------------------
+static void hedge_admit (struct hedge_req *h)
+{
+    long long wait = gate_admit (h->ep, deadline_left ());
+
+    h->state = (wait == GATE_REJECTED) ? HEDGE_FAILED : HEDGE_WAIT;
+    h->start = now_us () + (wait > 0 ? wait : 0);
+}
+
+static void hedge_run (CURLM *multi, struct hedge_req *h, wttr_cond_t *cond)
+{
+    h->state = HEDGE_FAILED;
+    if (!(h->chunk.memory = malloc(1)) || !(h->curl = http_handle_get())) {
+        gate_cancel (h->ep);
+        return;
+    }
+    h->chunk.memory[0] = 0;
+    h->chunk.size      = 0;
+
+    http_setopt (h->curl, h->url, "Mozilla/5.0", 1L, (curl_write_callback)WriteMemoryCallback, &h->chunk);
+    if (h->provider == &WttrProviderWttrIn)
+        fetch_setopt (h->curl, fetch_mode_get ());
+    if (cond)
+        h->hdr = cond_setopt (h->curl, cond);
+    curl_easy_setopt (h->curl, CURLOPT_PRIVATE, (void *)h);
+
+    if (curl_multi_add_handle (multi, h->curl) != CURLM_OK) {
+        gate_cancel (h->ep);
+        return;
+    }
+    h->state = HEDGE_RUNNING;
+    h->start = now_us ();
+}
+
+static int hedge_alive (const struct hedge_req *h)
+{
+    return (h->state == HEDGE_WAIT || h->state == HEDGE_RUNNING);
+}
+
+static int provider_fetch (const wttr_provider_t **prov, const char *location,
+                           wttr_result_t *res, wttr_cond_t *cond)
+{
+    struct hedge_req h[2];
+    char base [WTTR_URL_BASE_SIZE];
+    unsigned long long hash;
+    wttr_cond_t old;
+    CURLM *multi;
+    long long p95, now, next;
+    int running = 0, msgs, win = -1, ret = WTTR_UPDATE_FAIL;
+
+    memset (h, 0, sizeof(h));
+    h[0].ep = eWTTR_EP_WEATHER;
+    h[1].ep = eWTTR_EP_FALLBACK;
+    for (int i = 0; i < 2; i++) {
+        h[i].provider = prov[i];
+        if (!prov[i] || !provider_base (h[i].ep, prov[i], base, sizeof(base)) ||
+            !prov[i]->url (base, location, h[i].url, sizeof(h[i].url)))
+            h[i].state = HEDGE_FAILED;
+    }
+    if (cond)
+        memcpy (&old, cond, sizeof(wttr_cond_t));
+
+    pthread_once (&CurlInitOnce, curl_init_once);
+    if (!(multi = curl_multi_init()))
+        return WTTR_UPDATE_FAIL;
+
+    pthread_mutex_lock (&StatsLock);
+    p95 = latency_p95 (eWTTR_EP_WEATHER);
+    pthread_mutex_unlock (&StatsLock);
+
+    if (h[0].state == HEDGE_IDLE)
+        hedge_admit (&h[0]);
+
+    while (win < 0 && deadline_left () > 0) {
+        CURLMsg *msg;
+
+        /* hedge 시점 : 주 요청이 실패했거나 p95 시간이 지남 */
+        now = now_us ();
+        if (h[1].state == HEDGE_IDLE &&
+            (h[0].state == HEDGE_FAILED ||
+             (p95 && h[0].state == HEDGE_RUNNING && now >= h[0].start + p95))) {
+        #if defined (__LIB_WEATHER_DEBUG__)
+            printf ("%s : hedge %s (p95 = %lld us)\n", __func__, prov[1]->name, p95);
+        #endif
+            hedge_admit (&h[1]);
+        }
+        for (int i = 0; i < 2; i++)
+            if (h[i].state == HEDGE_WAIT && now >= h[i].start)
+                hedge_run (multi, &h[i], i ? NULL : cond);
+
+        if (!hedge_alive (&h[0]) && !hedge_alive (&h[1]))
+            break;
+
+        curl_multi_perform (multi, &running);
+        while ((msg = curl_multi_info_read (multi, &msgs)) != NULL) {
+            struct hedge_req *r;
+            CURLcode rc = msg->data.result;
+
+            if (msg->msg != CURLMSG_DONE) continue;
+
+            curl_easy_getinfo (msg->easy_handle, CURLINFO_PRIVATE, (char **)&r);
+            curl_multi_remove_handle (multi, r->curl);
+            stats_request (r->curl, r->ep, rc);
+            gate_result (r->ep, !gate_failure (r->curl, rc));
+
+            r->state = (rc == CURLE_OK) ? HEDGE_DONE : HEDGE_FAILED;
+            if (rc == CURLE_OK && win < 0)
+                win = (int)(r - h);
+            else if (rc != CURLE_OK)
+                fprintf(stderr, "curl 요청 실패(%s): %s\n", r->provider->name, curl_easy_strerror(rc));
+        }
+        if (win >= 0)
+            break;
+        /* 주 요청 실패 : 기다리지 않고 바로 hedge */
+        if (h[0].state == HEDGE_FAILED && h[1].state == HEDGE_IDLE)
+            continue;
+
+        /* 다음 이벤트 : 응답, hedge 시점, token 대기 완료, budget 만료 */
+        now  = now_us ();
+        next = now + deadline_left ();
+        if (p95 && h[1].state == HEDGE_IDLE && h[0].state == HEDGE_RUNNING && h[0].start + p95 < next)
+            next = h[0].start + p95;
+        for (int i = 0; i < 2; i++)
+            if (h[i].state == HEDGE_WAIT && h[i].start < next)
+                next = h[i].start;
+        next = (next > now) ? (next - now + 999) / 1000 : 0;
+        if (next > 1000)
+            next = 1000;
+
+        if (running)    curl_multi_wait (multi, NULL, 0, (int)next, NULL);
+        else            sleep_us (next * 1000);
+    }
+
+    if (win >= 0) {
+        struct hedge_req *w = &h[win];
+        long long start;
+
+        if (w->provider == &WttrProviderWttrIn)
+            fetch_account (w->curl, fetch_mode_get (), w->chunk.size);
+        if (cond && !win) {
+            cond_finish (w->curl, cond, &old);
+        } else if (cond) {
+            /* 보조 provider 응답 : 다음 요청은 주 provider 에 조건 없이 요청 */
+            cond->etag[0] = cond->last_mod[0] = '\0';
+            cond->not_modified = 0;
+        }
+        if (win) {
+            pthread_mutex_lock   (&StatsLock);
+            Stats[w->ep].hedge_wins++;
+            pthread_mutex_unlock (&StatsLock);
+        }
+
+        /* 304 또는 이전과 같은 응답은 파싱하지 않음 */
+        hash = payload_hash (PAYLOAD_HASH_INIT, w->chunk.memory, w->chunk.size);
+        if (cond && (cond->not_modified || cond->hash == hash)) {
+            stats_parse (w->ep, -1, 1);
+            ret = WTTR_UPDATE_UNCHANGED;
+        } else {
+            start = now_us ();
+            ret = w->provider->parse (w->chunk.memory, w->chunk.size, res->data, WTTR_ITEM_CNT, &res->fc);
+            stats_parse (w->ep, now_us () - start, ret);
+            res->hash = hash;
+            ret = ret ? WTTR_UPDATE_OK : WTTR_UPDATE_FAIL;
+        }
+    }
+
+    for (int i = 0; i < 2; i++) {
+        /* 늦은 요청 취소 */
+        if (hedge_alive (&h[i])) {
+            if (h[i].state == HEDGE_RUNNING) {
+                curl_multi_remove_handle (multi, h[i].curl);
+                stats_cancel (h[i].ep, now_us () - h[i].start);
+            }
+            gate_cancel (h[i].ep);
+        }
+        if (h[i].curl)
+            http_handle_put (h[i].curl);
+        curl_slist_free_all (h[i].hdr);
+        free (h[i].chunk.memory);
+    }
+    curl_multi_cleanup (multi);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// 날씨 데이터 요청 및 파싱 (res 에 저장)
+// cond != NULL 이면 조건부 요청, 304 응답이거나 body hash 가 cond->hash 와 같으면
+// 파싱하지 않고 WTTR_UPDATE_UNCHANGED 반환 (res 는 채워지지 않음).
+//------------------------------------------------------------------------------
+static int wttr_fetch_once (const struct loc_entry *e, wttr_result_t *res, wttr_cond_t *cond)
+{
+    const wttr_provider_t *prov[2];
+    unsigned long long hash;
+    char *json;
+    long long start;
+    int ret;
+
+    wttr_result_init (res);
+
+    /* 보조 provider 가 있거나 wttr.in 이 아닌 경우 */
+    pthread_mutex_lock (&ProviderLock);
+    prov[0] = Provider;
+    prov[1] = Fallback;
+    pthread_mutex_unlock (&ProviderLock);
+    if (prov[0] != &WttrProviderWttrIn || prov[1]) {
+        if ((ret = provider_fetch (prov, e->key, res, cond)) == WTTR_UPDATE_FAIL)
+            fprintf (stderr, "날씨 정보를 가져올 수 없습니다.\n");
+        return ret;
+    }
+
+    if (parse_mode_get () == eWTTR_PARSE_STREAM) {
+        int fetch_mode = fetch_mode_get ();
+        wttr_stream_t st;
+        char buf[512], *url;
+
+        /* 수신과 동시에 추출되므로 hash 가 같아도 추출은 이미 끝난 상태, snapshot 교체만 생략 */
+        stream_init (&st, res->data, WTTR_ITEM_CNT);
+        ret = (url = loc_url (e, fetch_mode, buf, sizeof(buf))) ?
+              http_get_stream (url, "Mozilla/5.0", 1L, fetch_mode, &st, cond) : 0;
+        if (url != buf) free (url);
+        if (!ret) {
+            fprintf (stderr, "날씨 정보를 가져올 수 없습니다.\n");
+            return WTTR_UPDATE_FAIL;
+        }
+        if (ret == WTTR_UPDATE_UNCHANGED || (cond && cond->hash == st.hash))
+            return WTTR_UPDATE_UNCHANGED;
+
+        res->hash = st.hash;
+        return WTTR_UPDATE_OK;
+    }
+
+    if (!(json = weather_get (e, cond))) {
+        fprintf (stderr, "날씨 정보를 가져올 수 없습니다.\n");
+        return WTTR_UPDATE_FAIL;
+    }
+    #if defined (__LIB_WEATHER_DEBUG__)
+        printf ("서버 응답 내용:\n%s\n", json);
+    #endif
+
+    /* 304 또는 이전과 같은 응답은 파싱하지 않음 */
+    hash = payload_hash (PAYLOAD_HASH_INIT, json, strlen (json));
+    if (cond && (cond->not_modified || cond->hash == hash)) {
+        stats_parse (eWTTR_EP_WEATHER, -1, 1);
+        free(json);
+        return WTTR_UPDATE_UNCHANGED;
+    }
+
+    start = now_us ();
+    ret = parse_weather_data (res->data, WTTR_ITEM_CNT, &res->fc, json);
+    stats_parse (eWTTR_EP_WEATHER, now_us () - start, ret);
+    free(json);
+
+    res->hash = hash;
+    return ret ? WTTR_UPDATE_OK : WTTR_UPDATE_FAIL;
+}
+
+//------------------------------------------------------------------------------
+// 같은 지역을 요청중이면 그 결과를 사용 (wttr_fetch_once 와 같은 반환값)
+// 요청한 caller 의 결과가 UNCHANGED 이면 파싱된 결과가 없으므로 같은 응답을
+// 가지고 있는 caller(cond->hash 가 같음)만 결과를 같이 사용하고 나머지는 다시 요청함.
+//------------------------------------------------------------------------------
+struct fetch_result {
+    wttr_result_t   res;
+    wttr_cond_t     cond;       /* 요청에 사용한 hash, 응답의 validator */
+};
+
+static int wttr_fetch_data (const struct loc_entry *e, wttr_result_t *res, wttr_cond_t *cond)
+{
+    struct fetch_result *r;
+    struct flight *f;
+    int leader = 1, ret;
+
+    f = flight_join (FLIGHT_WEATHER_DATA + parse_mode_get (), e->key, &leader);
+
+    if (leader) {
+        ret = wttr_fetch_once (e, res, cond);
+        if (f) {
+            if ((r = malloc (sizeof(struct fetch_result))) != NULL) {
+                memcpy (&r->res, res, sizeof(wttr_result_t));
+                if (cond)   memcpy (&r->cond, cond, sizeof(wttr_cond_t));
+                else        memset (&r->cond, 0,    sizeof(wttr_cond_t));
+            }
+            flight_done  (f, ret, r);
+            flight_leave (f, free);
+        }
+        return ret;
+    }
+
+    ret = -1;
+    if ((r = (struct fetch_result *)f->result) != NULL) {
+        if (f->ret == WTTR_UPDATE_OK) {
+            memcpy (res, &r->res, sizeof(wttr_result_t));
+            ret = (cond && cond->hash == res->hash) ? WTTR_UPDATE_UNCHANGED : WTTR_UPDATE_OK;
+        } else if (f->ret == WTTR_UPDATE_UNCHANGED) {
+            if (cond && cond->hash && cond->hash == r->cond.hash)
+                ret = WTTR_UPDATE_UNCHANGED;
+        } else {
+            ret = WTTR_UPDATE_FAIL;
+        }
+        if (cond && ret > 0) {
+            strcpy (cond->etag,     r->cond.etag);
+            strcpy (cond->last_mod, r->cond.last_mod);
+            cond->not_modified = 0;
+        }
+    }
+    flight_leave (f, free);
+
+    return (ret < 0) ? wttr_fetch_once (e, res, cond) : ret;
+}
+
+//------------------------------------------------------------------------------
+// background 갱신 thread (STALE 항목)
+//------------------------------------------------------------------------------
+static void *cache_refresh_thread (void *arg)
+{
+    wttr_loc_t loc = (wttr_loc_t)(intptr_t)arg;
+    wttr_result_t res;
+
+    deadline_enter (0);
+    cache_store (loc, wttr_fetch_data (loc_get (loc), &res, NULL) ? &res : NULL);
+    return NULL;
+}
+
+static void cache_refresh_start (wttr_loc_t loc)
+{
+    pthread_attr_t attr;
+    pthread_t tid;
+
+    pthread_attr_init (&attr);
+    pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+
+    if (pthread_create (&tid, &attr, cache_refresh_thread, (void *)(intptr_t)loc))
+        cache_store (loc, NULL);
+    pthread_attr_destroy (&attr);
+}
+
+//------------------------------------------------------------------------------
+// 지역 날씨 업데이트, loc = 지역 registry handle (wttr_loc_intern)
+// 반환값 = WTTR_UPDATE_OK, WTTR_UPDATE_FAIL,
+//          WTTR_UPDATE_UNCHANGED (이전 응답과 같음, snapshot 은 교체하지 않음)
+//------------------------------------------------------------------------------
+static int ctx_update (wttr_ctx_t *ctx, wttr_loc_t loc)
+{
+    const struct loc_entry *e = loc_get (loc);
+    wttr_result_t res;
+    wttr_cond_t cond;
+    int ret, refresh, use_cache;
+
+    if (!ctx || !e) return WTTR_UPDATE_FAIL;
+
+    wttr_ctx_cond_get (ctx, loc, &cond);
+
+    if (CacheTTL) {
+        if (cache_lookup (loc, &res, &refresh) != CACHE_MISS) {
+            if (res.hash && res.hash == cond.hash) {
+                wttr_ctx_cond_set (ctx, loc, &cond);
+                ret = WTTR_UPDATE_UNCHANGED;
+            } else {
+                /* cache 에는 validator 가 없으므로 hash 만 유지 */
+                memset (&cond, 0, sizeof(wttr_cond_t));
+                cond.hash = res.hash;
+                wttr_ctx_publish (ctx, &res, loc, &cond);
+                ret = WTTR_UPDATE_OK;
+            }
+            if (refresh)
+                cache_refresh_start (loc);
+            return ret;
+        }
+    }
+
+    /* cache 에 저장할 결과가 필요한 경우 조건부 요청/파싱 생략을 하지 않고 hash 만 비교 */
+    use_cache = CacheTTL;
+    ret = wttr_fetch_data (e, &res, use_cache ? NULL : &cond);
+    if (ret == WTTR_UPDATE_OK) {
+        if (use_cache) {
+            cache_store (loc, &res);
+            cond.etag[0] = cond.last_mod[0] = '\0';
+        }
+        if (cond.hash && cond.hash == res.hash) {
+            ret = WTTR_UPDATE_UNCHANGED;
+        } else {
+            cond.hash = res.hash;
+            wttr_ctx_publish (ctx, &res, loc, &cond);
+        }
+    } else if (ret == WTTR_UPDATE_UNCHANGED) {
+        wttr_ctx_cond_set (ctx, loc, &cond);
+    } else if (wttr_ctx_generation (ctx)) {
+        /* 요청 실패 : getter 는 이전 snapshot 을 그대로 돌려줌 */
+        stats_cached (eWTTR_EP_WEATHER);
+    }
+    return ret;
+}
+
+int wttr_ctx_update (wttr_ctx_t *ctx, const char *location)
+{
+    return wttr_ctx_update_budget (ctx, location, 0);
+}
+
+//------------------------------------------------------------------------------
+// budget_ms 안에 끝나는 업데이트 (token 대기, 재시도, hedge 요청 포함)
+//------------------------------------------------------------------------------
+int wttr_ctx_update_budget (wttr_ctx_t *ctx, const char *location, int budget_ms)
+{
+    return wttr_ctx_update_loc (ctx, wttr_loc_intern (location), budget_ms);
+}
+
+//------------------------------------------------------------------------------
+// 등록된 지역 업데이트 (정규화/인코딩 없이 handle 로 바로 요청)
+//------------------------------------------------------------------------------
+int wttr_ctx_update_loc (wttr_ctx_t *ctx, wttr_loc_t loc, int budget_ms)
+{
+    long long prev = deadline_enter (budget_ms);
+    int ret = ctx_update (ctx, loc);
+
+    deadline_leave (prev);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// background refresher : interval_sec 마다 wttr_ctx_update 반복
+// 완성된 snapshot 만 게시되므로 reader(UI thread)는 fetch 를 기다리지 않음.
+//------------------------------------------------------------------------------
+static void *refresh_thread (void *arg)
+{
+    wttr_ctx_t *ctx = (wttr_ctx_t *)arg;
+    struct timespec ts;
+
+    pthread_mutex_lock (&ctx->refresh_lock);
+    while (ctx->refresh_run) {
+        pthread_mutex_unlock (&ctx->refresh_lock);
+
+        if (!wttr_ctx_update_loc (ctx, ctx->refresh_loc, 0)) {
+        #if defined (__LIB_WEATHER_DEBUG__)
+            fprintf (stderr, "%s : refresh failed (%s)\n", __func__, wttr_loc_key (ctx->refresh_loc));
+        #endif
+        }
+
+        pthread_mutex_lock (&ctx->refresh_lock);
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+        ts.tv_sec += ctx->refresh_sec;
+        while (ctx->refresh_run &&
+               pthread_cond_timedwait (&ctx->refresh_cond, &ctx->refresh_lock, &ts) != ETIMEDOUT)
+            ;
+    }
+    pthread_mutex_unlock (&ctx->refresh_lock);
+    return NULL;
+}
+
+int wttr_ctx_refresh_start (wttr_ctx_t *ctx, const char *location, int interval_sec)
+{
+    if (!ctx || interval_sec <= 0) return 0;
+
+    wttr_ctx_refresh_stop (ctx);
+
+    pthread_mutex_lock (&ctx->refresh_lock);
+    ctx->refresh_loc = wttr_loc_intern (location);
+    ctx->refresh_sec = interval_sec;
+    ctx->refresh_run = 1;
+
+    if (ctx->refresh_loc < 0 ||
+        pthread_create (&ctx->refresh_tid, NULL, refresh_thread, ctx)) {
+        ctx->refresh_loc = WTTR_LOC_INVALID;
+        ctx->refresh_run = 0;
+    }
+    pthread_mutex_unlock (&ctx->refresh_lock);
+    return ctx->refresh_run;
+}
+
+//------------------------------------------------------------------------------
+// refresher 종료 (진행중인 fetch 가 끝날 때까지 기다림)
+//------------------------------------------------------------------------------
+void wttr_ctx_refresh_stop (wttr_ctx_t *ctx)
+{
+    int run;
+
+    if (!ctx) return;
+
+    pthread_mutex_lock (&ctx->refresh_lock);
+    run = ctx->refresh_run;
+    ctx->refresh_run = 0;
+    pthread_cond_signal  (&ctx->refresh_cond);
+    pthread_mutex_unlock (&ctx->refresh_lock);
+
+    if (!run) return;
+
+    pthread_join (ctx->refresh_tid, NULL);
+    ctx->refresh_loc = WTTR_LOC_INVALID;
+}
+
+//------------------------------------------------------------------------------
+// 여러 지역 동시 업데이트 (curl_multi), 동시에 진행되는 요청은 max_inflight 개로 제한
+// result[i] = 1(성공) / 0(실패), 반환값 = 성공한 지역 수
+// 각 요청은 다른 요청과 같이 gate 허가를 받고(token 대기, circuit breaker) 실패하면
+// backoff 후 재시도함. 시간 budget 은 지역마다 요청을 시작할 때부터 계산함.
+// 주 provider 가 wttr.in 이 아니면 그 provider 로 요청하고 buffer 로 받아 파싱함
+// (보조 provider 의 hedge 요청은 하지 않음).
+//------------------------------------------------------------------------------
+#define BATCH_INFLIGHT_DEFAULT  8
+
+struct batch_slot {
+    CURL                *curl;
+    int                 index;
+    int                 attempt;        /* 재시도 횟수 */
+    int                 admitted;       /* gate 허가를 받고 token 을 기다리는 중 */
+    long long           due;            /* 0 이 아니면 이 시간까지 대기 (multi 에 없음) */
+    long long           deadline;
+    wttr_loc_t          loc;
+    struct MemoryStruct chunk;
+    wttr_stream_t       stream;
+    wttr_result_t       res;
+};
+
+//------------------------------------------------------------------------------
+// 응답 buffer 초기화 (처음 요청 및 재시도)
+//------------------------------------------------------------------------------
+static void batch_slot_reset (struct batch_slot *slot, int parse_mode)
+{
+    slot->chunk.size = 0;
+    wttr_result_init (&slot->res);
+    if (parse_mode == eWTTR_PARSE_STREAM)
+        stream_init (&slot->stream, slot->res.data, WTTR_ITEM_CNT);
+}
+
+//------------------------------------------------------------------------------
+// gate 허가 후 multi 에 등록, token 또는 재시도를 기다려야 하면 due 를 설정
+// 반환값 0 = 허가를 받지 못함 (요청 실패)
+//------------------------------------------------------------------------------
+static int batch_submit (CURLM *multi, struct batch_slot *slot)
+{
+    long long wait;
+
+    if (!slot->admitted) {
+        if ((wait = gate_admit (eWTTR_EP_WEATHER, slot->deadline - now_us ())) == GATE_REJECTED)
+            return 0;
+        if (wait) {
+            slot->admitted = 1;
+            slot->due      = now_us () + wait;
+            return 1;
+        }
+    }
+    slot->admitted = 0;
+    slot->due      = 0;
+
+    deadline_setopt (slot->curl, slot->deadline - now_us ());
+    if (curl_multi_add_handle (multi, slot->curl) != CURLM_OK) {
+        gate_result (eWTTR_EP_WEATHER, 1);
+        return 0;
+    }
+    return 1;
+}
+
+static void batch_slot_free (struct batch_slot *slot)
+{
+    http_handle_put (slot->curl);
+    free (slot->chunk.memory);
+    slot->curl         = NULL;
+    slot->chunk.memory = NULL;
+}
+
+int wttr_batch_update (wttr_ctx_t **ctx, const char **location, int *result,
+                       int cnt, int max_inflight)
+{
+    CURLM *multi;
+    struct batch_slot *slots;
+    const wttr_provider_t *prov = provider_primary ();
+    int fetch_mode = fetch_mode_get (), parse_mode = prov ? eWTTR_PARSE_CJSON : parse_mode_get ();
+    int next = 0, running = 0, active = 0, ok_cnt = 0, parsed;
+
+    if (!ctx || !location || cnt <= 0) return 0;
+    if (max_inflight <= 0)  max_inflight = BATCH_INFLIGHT_DEFAULT;
+    if (max_inflight > cnt) max_inflight = cnt;
+
+    for (int i = 0; result && i < cnt; i++)
+        result[i] = 0;
+
+    pthread_once (&CurlInitOnce, curl_init_once);
+    if (!(multi = curl_multi_init()))
+        return 0;
+
+    if (!(slots = calloc (max_inflight, sizeof(struct batch_slot)))) {
+        curl_multi_cleanup (multi);
+        return 0;
+    }
+
+    do {
+        CURLMsg *msg;
+        long long now, wait_us = 1000000;
+        int msgs, delayed = 0;
+
+        /* 빈 slot 에 다음 지역 요청 추가 */
+        for (int s = 0; s < max_inflight && next < cnt; s++) {
+            struct batch_slot *slot = &slots[s];
+            char buf[512], *url = NULL;
+
+            if (slot->curl) continue;
+
+            slot->index        = next++;
+            slot->loc          = wttr_loc_intern (location[slot->index]);
+            slot->chunk.memory = malloc(1);
+            slot->chunk.size   = 0;
+
+            if (!slot->chunk.memory || !ctx[slot->index] ||
+                !(url = provider_url (prov, slot->loc, fetch_mode, buf, sizeof(buf))) ||
+                !(slot->curl = http_handle_get())) {
+                if (url != buf) free (url);
+                free (slot->chunk.memory);
+                slot->chunk.memory = NULL;
+                continue;
+            }
+            batch_slot_reset (slot, parse_mode);
+            if (parse_mode == eWTTR_PARSE_STREAM) {
+                http_setopt (slot->curl, url, "Mozilla/5.0", 1L,
+                             (curl_write_callback)WriteStreamCallback, &slot->stream);
+            } else {
+                http_setopt (slot->curl, url, "Mozilla/5.0", 1L,
+                             (curl_write_callback)WriteMemoryCallback, &slot->chunk);
+            }
+            if (!prov)
+                fetch_setopt (slot->curl, fetch_mode);
+            curl_easy_setopt (slot->curl, CURLOPT_PRIVATE, (void *)slot);
+            if (url != buf) free (url);
+
+            slot->attempt  = 0;
+            slot->admitted = 0;
+            slot->due      = 0;
+            slot->deadline = now_us () + deadline_left ();
+            if (!batch_submit (multi, slot)) {
+                fprintf(stderr, "curl 요청 실패(%s): %s\n",
+                    location[slot->index] ? location[slot->index] : "",
+                    http_strerror(HTTP_REJECTED));
+                batch_slot_free (slot);
+                continue;
+            }
+            active++;
+        }
+
+        /* token 또는 재시도 대기가 끝난 요청 시작 */
+        now = now_us ();
+        for (int s = 0; s < max_inflight; s++) {
+            struct batch_slot *slot = &slots[s];
+
+            if (!slot->curl || !slot->due || slot->due > now) continue;
+            if (!batch_submit (multi, slot)) {
+                fprintf(stderr, "curl 요청 실패(%s): %s\n",
+                    location[slot->index] ? location[slot->index] : "",
+                    http_strerror(HTTP_REJECTED));
+                batch_slot_free (slot);
+                active--;
+            }
+        }
+
+        curl_multi_perform (multi, &running);
+
+        /* 완료된 요청 처리 */
+        while ((msg = curl_multi_info_read (multi, &msgs)) != NULL) {
+            struct batch_slot *slot;
+            CURLcode res;
+            long long wait;
+            size_t rx;
+            int fail;
+
+            if (msg->msg != CURLMSG_DONE) continue;
+
+            res = msg->data.result;
+            curl_easy_getinfo (msg->easy_handle, CURLINFO_PRIVATE, (char **)&slot);
+            curl_multi_remove_handle (multi, slot->curl);
+
+            rx = (parse_mode == eWTTR_PARSE_STREAM) ? slot->stream.bytes : slot->chunk.size;
+            if (res == CURLE_OK && !prov)
+                fetch_account (slot->curl, fetch_mode, rx);
+
+            fail = gate_failure (slot->curl, res);
+            stats_request (slot->curl, eWTTR_EP_WEATHER, res);
+            gate_result (eWTTR_EP_WEATHER, !fail);
+
+            /* 재시도 (http_perform 과 같은 조건), 대기 후 다시 gate 허가를 받음 */
+            if (fail && !rx &&
+                (wait = gate_backoff (eWTTR_EP_WEATHER, slot->curl, slot->attempt++,
+                                      slot->deadline - now_us ())) != GATE_REJECTED) {
+                batch_slot_reset (slot, parse_mode);
+                slot->due = now_us () + wait;
+                continue;
+            }
+
+            parsed = 0;
+            if (res == CURLE_OK) {
+                long long start = now_us ();
+
+                if (parse_mode == eWTTR_PARSE_STREAM)
+                    parsed = stream_finish (&slot->stream);
+                else if (prov)
+                    parsed = prov->parse (slot->chunk.memory, slot->chunk.size,
+                                          slot->res.data, WTTR_ITEM_CNT, &slot->res.fc);
+                else
+                    parsed = parse_weather_data (slot->res.data, WTTR_ITEM_CNT, &slot->res.fc,
+                                                 slot->chunk.memory);
+                stats_parse (eWTTR_EP_WEATHER,
+                             (parse_mode == eWTTR_PARSE_STREAM) ? -1 : now_us () - start, parsed);
+            }
+            if (parsed) {
+                wttr_ctx_store (ctx[slot->index], &slot->res);
+                cache_store (slot->loc, &slot->res);
+                if (result) result[slot->index] = 1;
+                ok_cnt++;
+            } else if (res != CURLE_OK) {
+                fprintf(stderr, "curl 요청 실패(%s): %s\n",
+                    location[slot->index] ? location[slot->index] : "",
+                    curl_easy_strerror(res));
+            }
+
+            batch_slot_free (slot);
+            active--;
+        }
+
+        /* 다음 대기 만료 시간까지 기다림 (multi 에 요청이 없으면 sleep) */
+        now = now_us ();
+        for (int s = 0; s < max_inflight; s++) {
+            if (!slots[s].curl || !slots[s].due) continue;
+            delayed = 1;
+            if (slots[s].due - now < wait_us)
+                wait_us = (slots[s].due > now) ? slots[s].due - now : 0;
+        }
+        if (running)
+            curl_multi_wait (multi, NULL, 0, (int)((wait_us + 999) / 1000), NULL);
+        else if (delayed)
+            sleep_us (wait_us);
+
+    } while (active || next < cnt);
+
+    free (slots);
+    curl_multi_cleanup (multi);
+    return ok_cnt;
+}
+
 //------------------------------------------------------------------------------
-void parse_weather(const char *json)
+//------------------------------------------------------------------------------
+// 비동기 API (curl_multi_socket_action)
+// 요청 함수는 바로 반환하고, host 의 event loop(epoll 등)가 socket_cb/timer_cb 로
+// 받은 fd/timeout 을 감시하다가 wttr_async_action 을 호출하면 완료된 요청의
+// callback 이 호출됨. 하나의 async 객체는 하나의 thread 에서만 사용함.
+//------------------------------------------------------------------------------
+enum { ASYNC_WEATHER = 0, ASYNC_LOCATION };
+
+struct async_req {
+    struct async_req        *prev, *next;
+    CURL                    *curl;
+    int                     type;
+    int                     result;         /* 요청없이 완료된 경우 (ready list) */
+    int                     attempt;        /* 재시도 횟수 */
+    int                     admitted;       /* gate 허가를 받고 token 을 기다리는 중 */
+    long long               due;            /* delayed list 에서 시작할 시간 (us) */
+    long long               deadline;       /* 요청 만료 시간 (us, 시작시 + 기본 budget) */
+    const size_t            *rx;            /* 수신된 body 크기 (재시도 가능 여부) */
+    struct MemoryStruct     chunk;
+    void                    *userp;
+
+    /* ASYNC_WEATHER */
+    wttr_ctx_t              *ctx;
+    char                    *location;
+    wttr_loc_t              loc;
+    const wttr_provider_t   *provider;      /* NULL = wttr.in (provider_primary) */
+    int                     fetch_mode, parse_mode, use_cache;
+    struct curl_slist       *hdr;
+    wttr_cond_t             cond, old;
+    wttr_stream_t           stream;
+    wttr_result_t           res;
+    wttr_async_weather_cb_t weather_cb;
+
+    /* ASYNC_LOCATION */
+    double                  lat, lon;
+    char                    lang [4];
+    char                    *city, *country;
+    wttr_async_location_cb_t location_cb;
+};
+
+struct wttr_async__t {
+    CURLM                   *multi;
+    wttr_async_socket_cb_t  socket_cb;
+    wttr_async_timer_cb_t   timer_cb;
+    void                    *userp;
+    struct async_req        *reqs;          /* curl 에 등록된 요청 */
+    struct async_req        *ready;         /* 요청없이 완료된 요청 (cache hit 등) */
+    struct async_req        *delayed;       /* token 또는 재시도를 기다리는 요청 */
+    long long               curl_due;       /* curl timer 만료 시간 (us), 0 = 없음 */
+    int                     pending;
+};
+
+//------------------------------------------------------------------------------
+// curl → host event loop
+//------------------------------------------------------------------------------
+static int async_socket_cb (CURL *easy, curl_socket_t fd, int what, void *userp, void *socketp)
 {
-    cJSON *root = cJSON_Parse(json);
-    if (!root) {
-        fprintf(stderr, "JSON 파싱 실패\n");
-        return;
+    wttr_async_t *as = (wttr_async_t *)userp;
+    int ev = 0;
+
+    (void)easy; (void)socketp;
+    if (what == CURL_POLL_REMOVE)   ev = WTTR_POLL_REMOVE;
+    else {
+        if (what & CURL_POLL_IN)    ev |= WTTR_POLL_IN;
+        if (what & CURL_POLL_OUT)   ev |= WTTR_POLL_OUT;
     }
+    as->socket_cb ((int)fd, ev, as->userp);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// host timer 설정 : curl timer 와 delayed list 중 먼저 만료되는 시간
+// 바로 처리할 완료 항목이 있으면 timer 를 0 으로 유지
+//------------------------------------------------------------------------------
+static void async_timer_set (wttr_async_t *as)
+{
+    struct async_req *r;
+    long long due = as->curl_due, now;
 
-    for (size_t i = 0; i < (sizeof (WttrData) / sizeof (WttrData[0])); i++) {
-        cJSON *current = cJSON_GetObjectItem(root, *WttrData[i].sub_class);
+    for (r = as->delayed; r; r = r->next)
+        if (!due || r->due < due)
+            due = r->due;
 
-        if (!cJSON_IsArray(current) || cJSON_GetArraySize(current) == 0) {
-            cJSON_Delete(root);
-            fprintf(stderr, "날씨 정보 없음\n");
+    if (as->ready)
+        as->timer_cb (0, as->userp);
+    else if (!due)
+        as->timer_cb (-1, as->userp);
+    else {
+        now = now_us ();
+        as->timer_cb (due > now ? (long)((due - now + 999) / 1000) : 0, as->userp);
+    }
+}
+
+static int async_timer_cb (CURLM *multi, long timeout_ms, void *userp)
+{
+    wttr_async_t *as = (wttr_async_t *)userp;
+
+    (void)multi;
+    as->curl_due = (timeout_ms < 0) ? 0 : now_us () + timeout_ms * 1000LL;
+    async_timer_set (as);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+wttr_async_t *wttr_async_create (wttr_async_socket_cb_t socket_cb, wttr_async_timer_cb_t timer_cb,
+                                 void *userp)
+{
+    wttr_async_t *as;
+
+    if (!socket_cb || !timer_cb) return NULL;
+
+    pthread_once (&CurlInitOnce, curl_init_once);
+    if (!(as = calloc (1, sizeof(wttr_async_t))))
+        return NULL;
+
+    if (!(as->multi = curl_multi_init ())) {
+        free (as);
+        return NULL;
+    }
+    as->socket_cb = socket_cb;
+    as->timer_cb  = timer_cb;
+    as->userp     = userp;
+
+    curl_multi_setopt (as->multi, CURLMOPT_SOCKETFUNCTION, async_socket_cb);
+    curl_multi_setopt (as->multi, CURLMOPT_SOCKETDATA,     as);
+    curl_multi_setopt (as->multi, CURLMOPT_TIMERFUNCTION,  async_timer_cb);
+    curl_multi_setopt (as->multi, CURLMOPT_TIMERDATA,      as);
+    return as;
+}
+
+static void async_req_free (struct async_req *r)
+{
+    if (r->curl)    http_handle_put (r->curl);
+    curl_slist_free_all (r->hdr);
+    free (r->chunk.memory);
+    free (r->location);
+    free (r->city);
+    free (r->country);
+    free (r);
+}
+
+static void async_list_del (struct async_req **head, struct async_req *r)
+{
+    if (r->prev)    r->prev->next = r->next;
+    else            *head = r->next;
+    if (r->next)    r->next->prev = r->prev;
+    r->prev = r->next = NULL;
+}
+
+static void async_list_add (struct async_req **head, struct async_req *r)
+{
+    r->prev = NULL;
+    r->next = *head;
+    if (*head)      (*head)->prev = r;
+    *head = r;
+}
+
+//------------------------------------------------------------------------------
+// 진행중인 요청은 callback 없이 취소됨 (callback 안에서 호출하면 안됨)
+//------------------------------------------------------------------------------
+void wttr_async_destroy (wttr_async_t *as)
+{
+    struct async_req *r;
+
+    if (!as) return;
+
+    while ((r = as->reqs) != NULL) {
+        async_list_del (&as->reqs, r);
+        curl_multi_remove_handle (as->multi, r->curl);
+        async_req_free (r);
+    }
+    while ((r = as->ready) != NULL) {
+        async_list_del (&as->ready, r);
+        async_req_free (r);
+    }
+    while ((r = as->delayed) != NULL) {
+        async_list_del (&as->delayed, r);
+        async_req_free (r);
+    }
+    curl_multi_cleanup (as->multi);
+    free (as);
+}
+
+int wttr_async_pending (wttr_async_t *as)
+{
+    return as ? as->pending : 0;
+}
+
+//------------------------------------------------------------------------------
+// 요청없이 완료 (다음 wttr_async_action 에서 callback 호출)
+//------------------------------------------------------------------------------
+static void async_ready (wttr_async_t *as, struct async_req *r, int result)
+{
+    r->result = result;
+    async_list_add (&as->ready, r);
+    as->timer_cb (0, as->userp);
+}
+
+static int async_ep (const struct async_req *r)
+{
+    return (r->type == ASYNC_WEATHER) ? eWTTR_EP_WEATHER : eWTTR_EP_LOCATION;
+}
+
+//------------------------------------------------------------------------------
+// 요청 실패시 cache 값 사용 (날씨는 이전 snapshot, 위치는 주변 grid), 반환값 = result
+//------------------------------------------------------------------------------
+static int async_fallback (struct async_req *r)
+{
+    if (r->type == ASYNC_WEATHER) {
+        if (wttr_ctx_generation (r->ctx))
+            stats_cached (eWTTR_EP_WEATHER);
+        return WTTR_UPDATE_FAIL;
+    }
+    free (r->city);
+    free (r->country);
+    r->city = r->country = NULL;
+    if (!geo_lookup_near (r->lat, r->lon, r->lang, &r->city, &r->country))
+        return 0;
+    stats_cached (eWTTR_EP_LOCATION);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// gate 허가 후 curl 에 등록, token 또는 재시도를 기다려야 하면 delayed list 에 추가
+//------------------------------------------------------------------------------
+static void async_submit (wttr_async_t *as, struct async_req *r)
+{
+    long long wait;
+
+    if (!r->admitted) {
+        if ((wait = gate_admit (async_ep (r), r->deadline - now_us ())) == GATE_REJECTED) {
+            async_ready (as, r, async_fallback (r));
+            return;
+        }
+        if (wait) {
+            r->admitted = 1;
+            r->due      = now_us () + wait;
+            async_list_add (&as->delayed, r);
+            async_timer_set (as);
             return;
         }
+    }
+    r->admitted = 0;
 
-        cJSON *info = cJSON_GetArrayItem(current, 0);
+    deadline_setopt (r->curl, r->deadline - now_us ());
+    async_list_add (&as->reqs, r);
+    if (curl_multi_add_handle (as->multi, r->curl) != CURLM_OK) {
+        async_list_del (&as->reqs, r);
+        gate_result (async_ep (r), 1);
+        async_ready (as, r, 0);
+    }
+}
 
-        if  ((strncmp(WttrData[i].item_str, "areaName", strlen("areaName")) == 0) ||
-             (strncmp(WttrData[i].item_str, "country" , strlen("country"))  == 0) )  {
-            const cJSON *arr = cJSON_GetObjectItem(info, WttrData[i].item_str);
-            const cJSON *obj = cJSON_GetArrayItem (arr, 0);
+//------------------------------------------------------------------------------
+// 시간이 된 delayed 요청 시작
+//------------------------------------------------------------------------------
+static void async_delayed_run (wttr_async_t *as)
+{
+    struct async_req *r, *next;
+    long long now = now_us ();
+
+    for (r = as->delayed; r; r = next) {
+        next = r->next;
+        if (r->due > now)
+            continue;
+        async_list_del (&as->delayed, r);
+        async_submit (as, r);
+    }
+}
+
+//------------------------------------------------------------------------------
+// 요청 시작, 실패하면 FAIL 로 완료 처리
+//------------------------------------------------------------------------------
+static void async_start (wttr_async_t *as, struct async_req *r, const char *url, const char *agent,
+                         long follow, curl_write_callback write_cb, void *writep)
+{
+    if (!(r->curl = http_handle_get ())) {
+        async_ready (as, r, 0);
+        return;
+    }
+    http_setopt (r->curl, url, agent, follow, write_cb, writep);
+    curl_easy_setopt (r->curl, CURLOPT_PRIVATE, (void *)r);
+    r->deadline = now_us () + BudgetMs * 1000LL;
+
+    if (r->type == ASYNC_WEATHER) {
+        if (!r->provider)
+            fetch_setopt (r->curl, r->fetch_mode);
+        memcpy (&r->old, &r->cond, sizeof(wttr_cond_t));
+        r->hdr = cond_setopt (r->curl, &r->cond);
+        r->rx  = (r->parse_mode == eWTTR_PARSE_STREAM) ? &r->stream.bytes : &r->chunk.size;
+    } else {
+        r->rx  = &r->chunk.size;
+    }
+    async_submit (as, r);
+}
 
-            strncpy (
-                WttrData[i].data_str,
-                cJSON_GetObjectItem(obj, "value")->valuestring,
-                strlen(cJSON_GetObjectItem(obj, "value")->valuestring)
-            );
+//------------------------------------------------------------------------------
+// 날씨 업데이트 요청, 완료되면 cb(ctx, location, result, userp)
+// result = WTTR_UPDATE_OK, WTTR_UPDATE_FAIL, WTTR_UPDATE_UNCHANGED (wttr_ctx_update 와 동일)
+// 반환값 = 1 (요청됨, cb 는 반드시 한번 호출됨) / 0 (잘못된 인자 또는 메모리 부족)
+//------------------------------------------------------------------------------
+int wttr_async_update (wttr_async_t *as, wttr_ctx_t *ctx, const char *location,
+                       wttr_async_weather_cb_t cb, void *userp)
+{
+    struct async_req *r;
+    char buf[512], *url;
+    int refresh;
+
+    if (!as || !ctx || !(r = calloc (1, sizeof(struct async_req))))
+        return 0;
+
+    r->type       = ASYNC_WEATHER;
+    r->ctx        = ctx;
+    r->weather_cb = cb;
+    r->userp      = userp;
+    r->provider   = provider_primary ();
+    r->fetch_mode = fetch_mode_get ();
+    r->parse_mode = r->provider ? eWTTR_PARSE_CJSON : parse_mode_get ();
+    if (!(r->location = strdup (location ? location : "")) ||
+        !(r->chunk.memory = malloc (1))) {
+        async_req_free (r);
+        return 0;
+    }
+    r->chunk.memory[0] = 0;
+    as->pending++;
+
+    r->loc = wttr_loc_intern (location);
+    wttr_ctx_cond_get (ctx, r->loc, &r->cond);
+    wttr_result_init (&r->res);
+
+    /* wttr_ctx_update 와 같은 방법으로 응답 cache 사용 */
+    if (CacheTTL && r->loc >= 0) {
+        if (cache_lookup (r->loc, &r->res, &refresh) != CACHE_MISS) {
+            int ret = WTTR_UPDATE_UNCHANGED;
+
+            if (!r->res.hash || r->res.hash != r->cond.hash) {
+                memset (&r->cond, 0, sizeof(wttr_cond_t));
+                r->cond.hash = r->res.hash;
+                wttr_ctx_publish (ctx, &r->res, r->loc, &r->cond);
+                ret = WTTR_UPDATE_OK;
+            } else {
+                wttr_ctx_cond_set (ctx, r->loc, &r->cond);
+            }
+            if (refresh)
+                cache_refresh_start (r->loc);
+            async_ready (as, r, ret);
+            return 1;
         }
-        else {
-            /* Get weather data from json arrary */
-            strncpy (
-                WttrData[i].data_str,
-                cJSON_GetObjectItem(info, WttrData[i].item_str)->valuestring,
-                strlen(cJSON_GetObjectItem(info, WttrData[i].item_str)->valuestring)
-            );
+        /* cache 에 저장할 결과가 필요하므로 조건부 요청 안함 */
+        r->use_cache = 1;
+        r->cond.etag[0] = r->cond.last_mod[0] = '\0';
+    }
+
+    if (!(url = provider_url (r->provider, r->loc, r->fetch_mode, buf, sizeof(buf)))) {
+        async_ready (as, r, WTTR_UPDATE_FAIL);
+        return 1;
+    }
+    if (r->parse_mode == eWTTR_PARSE_STREAM) {
+        stream_init (&r->stream, r->res.data, WTTR_ITEM_CNT);
+        async_start (as, r, url, "Mozilla/5.0", 1L,
+                     (curl_write_callback)WriteStreamCallback, &r->stream);
+    } else {
+        async_start (as, r, url, "Mozilla/5.0", 1L,
+                     (curl_write_callback)WriteMemoryCallback, &r->chunk);
+    }
+    if (url != buf) free (url);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 위치 요청, 완료되면 cb(lat, lon, city, country, ok, userp)
+// 반환값 = 1 (요청됨, cb 는 반드시 한번 호출됨) / 0 (잘못된 인자 또는 메모리 부족)
+//------------------------------------------------------------------------------
+int wttr_async_location (wttr_async_t *as, double lat, double lon, int is_kor,
+                         wttr_async_location_cb_t cb, void *userp)
+{
+    struct async_req *r;
+    char url[512];
+
+    if (!as || !(r = calloc (1, sizeof(struct async_req))))
+        return 0;
+
+    r->type        = ASYNC_LOCATION;
+    r->lat         = lat;
+    r->lon         = lon;
+    r->location_cb = cb;
+    r->userp       = userp;
+    strcpy (r->lang, is_kor ? "ko" : "en");
+    if (!(r->chunk.memory = malloc (1))) {
+        async_req_free (r);
+        return 0;
+    }
+    r->chunk.memory[0] = 0;
+    as->pending++;
+
+    if (geo_lookup_dup (lat, lon, r->lang, &r->city, &r->country)) {
+        async_ready (as, r, 1);
+        return 1;
+    }
+    location_url (lat, lon, r->lang, url, sizeof(url));
+    async_start (as, r, url, "C-Geocoder/1.0", 0L,
+                 (curl_write_callback)WriteMemoryCallback, &r->chunk);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// 완료된 날씨 요청 처리 (wttr_fetch_once + wttr_ctx_update 와 같은 결과)
+//------------------------------------------------------------------------------
+static int async_weather_done (struct async_req *r, CURLcode res)
+{
+    long long start;
+    int ok;
+
+    if (res == CURLE_OK) {
+        if (!r->provider)
+            fetch_account (r->curl, r->fetch_mode, *r->rx);
+        cond_finish (r->curl, &r->cond, &r->old);
+    }
+
+    if (res != CURLE_OK) {
+        fprintf(stderr, "curl 요청 실패(%s): %s\n", r->location, curl_easy_strerror(res));
+        return async_fallback (r);
+    }
+    if (r->cond.not_modified) {
+        stats_parse (eWTTR_EP_WEATHER, -1, 1);
+        wttr_ctx_cond_set (r->ctx, r->loc, &r->cond);
+        return WTTR_UPDATE_UNCHANGED;
+    }
+
+    if (r->parse_mode == eWTTR_PARSE_STREAM) {
+        ok = stream_finish (&r->stream);
+        stats_parse (eWTTR_EP_WEATHER, -1, ok);
+        r->res.hash = r->stream.hash;
+    } else {
+        r->res.hash = payload_hash (PAYLOAD_HASH_INIT, r->chunk.memory, r->chunk.size);
+        /* 이전과 같은 응답은 파싱하지 않음 (cache 에 저장할 경우는 제외) */
+        if (!r->use_cache && r->res.hash == r->cond.hash) {
+            stats_parse (eWTTR_EP_WEATHER, -1, 1);
+            wttr_ctx_cond_set (r->ctx, r->loc, &r->cond);
+            return WTTR_UPDATE_UNCHANGED;
         }
-        #if defined (__LIB_WEATHER_DEBUG__)
-            /* Data print */
-            printf ("%s : %s, %s, %s\n", __func__,
-                *WttrData[i].sub_class, WttrData[i].item_str, WttrData[i].data_str);
-        #endif
+        start = now_us ();
+        ok = r->provider ?
+             r->provider->parse (r->chunk.memory, r->chunk.size, r->res.data, WTTR_ITEM_CNT, &r->res.fc) :
+             parse_weather_data (r->res.data, WTTR_ITEM_CNT, &r->res.fc, r->chunk.memory);
+        stats_parse (eWTTR_EP_WEATHER, now_us () - start, ok);
+    }
+    if (!ok)
+        return WTTR_UPDATE_FAIL;
+
+    if (r->use_cache)
+        cache_store (r->loc, &r->res);
+    if (r->cond.hash && r->cond.hash == r->res.hash) {
+        wttr_ctx_cond_set (r->ctx, r->loc, &r->cond);
+        return WTTR_UPDATE_UNCHANGED;
+    }
+    r->cond.hash = r->res.hash;
+    wttr_ctx_publish (r->ctx, &r->res, r->loc, &r->cond);
+    return WTTR_UPDATE_OK;
+}
+
+static int async_location_done (struct async_req *r, CURLcode res)
+{
+    if (res != CURLE_OK) {
+        fprintf(stderr, "curl 요청 실패: %s\n", curl_easy_strerror(res));
+        return async_fallback (r);
     }
+    /* 응답보다 긴 이름은 없음 */
+    free (r->city);
+    free (r->country);
+    r->city    = malloc (r->chunk.size + 1);
+    r->country = malloc (r->chunk.size + 1);
+
+    return (r->city && r->country) ?
+        location_parse (r->chunk.memory, r->lat, r->lon, r->lang, r->city, r->country,
+                        r->chunk.size + 1) : 0;
 }
 
 //------------------------------------------------------------------------------
-// 측정시간[eWTTR_LOBS_DATE] (WttrData struct) 데이터 변환
+// callback 호출 후 해제 (callback 에서 새 요청을 추가할 수 있음)
 //------------------------------------------------------------------------------
-void get_wttr_date (const char *obs_data, struct tm *t)
+static void async_complete (wttr_async_t *as, struct async_req *r)
 {
-    // Local Obs Data : "2025-05-20 12:14 PM"
-    strptime (obs_data, "%Y-%m-%d %I:%M %p", t);
-    /* mktime (t);  // 자동으로 overflow 조정 */
+    as->pending--;
 
-    #if defined (__LIB_WEATHER_DEBUG__)
-        printf("관측 시각: %d년 %d월 %d일 %d시 %d분 %d요일 %d일/356일\n",
-            t->tm_year + 1900,
-            t->tm_mon + 1,
-            t->tm_mday,
-            t->tm_hour,
-            t->tm_min,
-            t->tm_wday,
-            t->tm_yday + 1
-        );
-    #endif
+    if (r->type == ASYNC_WEATHER) {
+        if (r->weather_cb)
+            r->weather_cb (r->ctx, r->location, r->result, r->userp);
+    } else if (r->location_cb) {
+        int ok = r->result && r->city && r->country;
+
+        r->location_cb (r->lat, r->lon, ok ? r->city : "", ok ? r->country : "", ok, r->userp);
+    }
+    async_req_free (r);
 }
 
 //------------------------------------------------------------------------------
-// WttrData Struct data 요청
+// host event loop 에서 호출
+// fd = 이벤트가 발생한 fd (events = WTTR_POLL_IN/OUT/ERR), timer 만료는 WTTR_ASYNC_TIMEOUT
+// 반환값 = 진행중인 요청 수
 //------------------------------------------------------------------------------
-const char *get_wttr_data (enum eWttrItem id)
+int wttr_async_action (wttr_async_t *as, int fd, int events)
 {
-    size_t cnt;
+    struct async_req *r;
+    CURLMsg *msg;
+    int running = 0, msgs, mask = 0;
+
+    if (!as) return 0;
+
+    if (events & WTTR_POLL_IN)  mask |= CURL_CSELECT_IN;
+    if (events & WTTR_POLL_OUT) mask |= CURL_CSELECT_OUT;
+    if (events & WTTR_POLL_ERR) mask |= CURL_CSELECT_ERR;
 
-    for (cnt = 0; cnt < sizeof (WttrData)/sizeof (WttrData[0]); cnt++) {
-        if (WttrData[cnt].id == id) return WttrData[cnt].data_str;
+    curl_multi_socket_action (as->multi,
+        (fd == WTTR_ASYNC_TIMEOUT) ? CURL_SOCKET_TIMEOUT : (curl_socket_t)fd, mask, &running);
+
+    while ((msg = curl_multi_info_read (as->multi, &msgs)) != NULL) {
+        CURLcode res;
+        long long wait;
+        int fail;
+
+        if (msg->msg != CURLMSG_DONE) continue;
+
+        res = msg->data.result;
+        curl_easy_getinfo (msg->easy_handle, CURLINFO_PRIVATE, (char **)&r);
+        async_list_del (&as->reqs, r);
+        curl_multi_remove_handle (as->multi, r->curl);
+
+        fail = gate_failure (r->curl, res);
+        stats_request (r->curl, async_ep (r), res);
+        gate_result (async_ep (r), !fail);
+
+        /* 재시도 (http_perform 과 같은 조건), 대기 후 다시 gate 허가를 받음 */
+        if (fail && !*r->rx &&
+            (wait = gate_backoff (async_ep (r), r->curl, r->attempt++,
+                                  r->deadline - now_us ())) != GATE_REJECTED) {
+            r->due = now_us () + wait;
+            async_list_add (&as->delayed, r);
+            continue;
+        }
+        r->result = (r->type == ASYNC_WEATHER) ? async_weather_done  (r, res)
+                                               : async_location_done (r, res);
+        async_complete (as, r);
     }
-    return NULL;
+    async_delayed_run (as);
+
+    /* 요청없이 완료된 항목 (callback 에서 추가된 항목은 다음 호출에서 처리) */
+    r = as->ready;
+    as->ready = NULL;
+    while (r) {
+        struct async_req *next = r->next;
+
+        async_complete (as, r);
+        r = next;
+    }
+    /* delayed list 의 다음 만료 시간 */
+    if (as->delayed)
+        async_timer_set (as);
+    return as->pending;
+}
+
+//------------------------------------------------------------------------------
+// 기본 context data 요청
+//------------------------------------------------------------------------------
+const char *get_wttr_data (enum eWttrItem id)
+{
+    return wttr_ctx_get_data (wttr_default_ctx(), id);
 }
 
 //------------------------------------------------------------------------------
@@ -503,20 +6413,51 @@ const char *get_wttr_data (enum eWttrItem id)
 //------------------------------------------------------------------------------
 int update_weather_data (const char *location)
 {
-    char *json = get_weather_json (location);
+    return wttr_ctx_update (wttr_default_ctx(), location);
+}
 
-    if (!json) {
-        fprintf (stderr, "날씨 정보를 가져올 수 없습니다.\n");
-        return 0;
-    }
-    #if defined (__LIB_WEATHER_DEBUG__)
-        printf ("서버 응답 내용:\n%s\n", json);
-    #endif
+//------------------------------------------------------------------------------
+// 기본 context background refresher
+//------------------------------------------------------------------------------
+int weather_refresh_start (const char *location, int interval_sec)
+{
+    return wttr_ctx_refresh_start (wttr_default_ctx(), location, interval_sec);
+}
 
-    parse_weather(json);
-    free(json);
+void weather_refresh_stop (void)
+{
+    wttr_ctx_refresh_stop (wttr_default_ctx());
+}
 
-    return 1;
+//------------------------------------------------------------------------------
+// 기본 context snapshot 파일
+//------------------------------------------------------------------------------
+int weather_snapshot_open (const char *path)
+{
+    return wttr_ctx_snapshot_open (wttr_default_ctx(), path);
+}
+
+int weather_snapshot_save (void)
+{
+    return wttr_ctx_snapshot_save (wttr_default_ctx());
+}
+
+int get_wttr_stale (time_t *saved)
+{
+    return wttr_ctx_is_stale (wttr_default_ctx(), saved);
+}
+
+//------------------------------------------------------------------------------
+// 기본 context 공유 메모리 게시 (daemon)
+//------------------------------------------------------------------------------
+int weather_shm_open (const char *name)
+{
+    return wttr_ctx_shm_open (wttr_default_ctx(), name);
+}
+
+int weather_shm_publish (void)
+{
+    return wttr_ctx_shm_publish (wttr_default_ctx());
 }
 
 //------------------------------------------------------------------------------
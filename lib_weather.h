@@ -12,10 +12,47 @@
  *
  */
 //------------------------------------------------------------------------------
+#include <stddef.h>
+#include <time.h>
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// 요청 URL = base URL + path (base URL 은 wttr_set_endpoint 또는 환경변수로 변경가능)
 //------------------------------------------------------------------------------
-#define WEATHER_URL_FORMAT      "http://wttr.in/%s?format=j1"
-#define LOCATION_URL_FORMAT_KR  "https://nominatim.openstreetmap.org/reverse?format=json&lat=%f&lon=%f&zoom=10&accept-language=ko"
-#define LOCATION_URL_FORMAT_EN  "https://nominatim.openstreetmap.org/reverse?format=json&lat=%f&lon=%f&zoom=10&accept-language=en"
+#define WEATHER_URL_BASE        "http://wttr.in"
+#define WEATHER_URL_PATH        "/%s?format=j1"
+/* j1 에서 시간별 예보(weather.hourly)를 제외한 응답 */
+#define WEATHER_URL_PATH_LIGHT  "/%s?format=j2"
+#define LOCATION_URL_BASE       "https://nominatim.openstreetmap.org"
+#define LOCATION_URL_PATH       "/reverse?format=json&lat=%f&lon=%f&zoom=10&accept-language=%s"
+/* 보조 날씨 provider (wttr_set_provider 로 설정한 경우만 사용) */
+#define OPENMETEO_URL_BASE      "https://api.open-meteo.com"
+#define FALLBACK_URL_BASE       OPENMETEO_URL_BASE
+#define OPENMETEO_URL_PATH      "/v1/forecast?latitude=%.4f&longitude=%.4f" \
+                                "&current=temperature_2m,apparent_temperature,relative_humidity_2m," \
+                                "precipitation,weather_code,cloud_cover,pressure_msl,wind_speed_10m," \
+                                "wind_direction_10m,uv_index,visibility" \
+                                "&hourly=temperature_2m,precipitation,wind_speed_10m," \
+                                "precipitation_probability,weather_code&forecast_days=3&timezone=auto"
+
+/* 이전 version 호환용 전체 URL (기본 base URL 기준, endpoint/환경변수 설정은 반영되지 않음) */
+#define WEATHER_URL_FORMAT      WEATHER_URL_BASE WEATHER_URL_PATH
+#define LOCATION_URL_FORMAT_KR  LOCATION_URL_BASE "/reverse?format=json&lat=%f&lon=%f&zoom=10&accept-language=ko"
+#define LOCATION_URL_FORMAT_EN  LOCATION_URL_BASE "/reverse?format=json&lat=%f&lon=%f&zoom=10&accept-language=en"
+
+/* base URL 환경변수 (처음 요청시 한번 읽음) */
+#define WEATHER_URL_ENV         "WTTR_WEATHER_URL"
+#define LOCATION_URL_ENV        "WTTR_LOCATION_URL"
+#define FALLBACK_URL_ENV        "WTTR_FALLBACK_URL"
+#define WTTR_URL_BASE_SIZE      256
+
+enum eWttrEndpoint {
+    eWTTR_EP_WEATHER = 0,   /* wttr.in */
+    eWTTR_EP_LOCATION,      /* nominatim */
+    eWTTR_EP_FALLBACK,      /* 보조 날씨 provider (open-meteo 등) */
+    eWTTR_EP_END
+};
+
 #define DEFAULT_LOCATION ""
 
 //------------------------------------------------------------------------------
@@ -67,6 +104,27 @@ enum eWttrItem {
 
 #define WTTR_DATA_SIZE   32
 
+//------------------------------------------------------------------------------
+// 날씨 코드/풍향/자외선 언어 pack
+// weather[0] = 알 수 없는 코드, weather[1..48] = 113, 116, ... 395 (코드 순서)
+//------------------------------------------------------------------------------
+#define WTTR_WCODE_CNT  48      /* wttr.in 날씨 코드 수 */
+#define WTTR_WCODE_MAX  400     /* 날씨 코드 최대값 + 1 */
+#define WTTR_LANG_MAX   16
+
+enum eWttrLang {
+    eWTTR_LANG_EN = 0,
+    eWTTR_LANG_KO,
+    eWTTR_LANG_BUILTIN,
+};
+
+typedef struct wttr_lang__t {
+    const char *code;                           /* "ko", "en", "ja" ... */
+    const char *weather [WTTR_WCODE_CNT + 1];
+    const char *wind    [16];                   /* N, NNE, ... NNW */
+    const char *uv      [5];                    /* 0-2, 3-5, 6-7, 8-10, 11~ */
+}   wttr_lang_t;
+
 typedef struct wttr_data__t {
     enum eWttrItem id;
     const char **sub_class;
@@ -75,6 +133,141 @@ typedef struct wttr_data__t {
 
 }   wttr_data_t;
 
+//------------------------------------------------------------------------------
+// 응답 파싱 방식
+//   eWTTR_PARSE_CJSON  : 전체 응답을 buffer 에 저장 후 cJSON tree 로 파싱
+//   eWTTR_PARSE_STREAM : 수신되는 데이터를 바로 scan 하여 필요한 항목만 추출
+//                        (응답 buffer, tree 할당 없음)
+//------------------------------------------------------------------------------
+enum eWttrParse {
+    eWTTR_PARSE_CJSON = 0,
+    eWTTR_PARSE_STREAM,
+};
+
+//------------------------------------------------------------------------------
+// wttr.in 요청 방식 (bit 조합)
+//   WTTR_FETCH_COMPRESS : gzip/deflate 압축 전송 요청
+//   WTTR_FETCH_LIGHT    : format=j2 (현재 날씨/지역 항목은 j1 과 동일)
+//------------------------------------------------------------------------------
+#define WTTR_FETCH_J1           0x00
+#define WTTR_FETCH_COMPRESS     0x01
+#define WTTR_FETCH_LIGHT        0x02
+#define WTTR_FETCH_MODE_CNT     4
+
+typedef struct wttr_fetch_stats__t {
+    unsigned long       requests;
+    unsigned long long  wire_bytes;     /* 수신된 header + body (압축 상태) */
+    unsigned long long  body_bytes;     /* 압축 해제 후 body */
+}   wttr_fetch_stats_t;
+
+//------------------------------------------------------------------------------
+// 시간별 예보 (weather[].hourly[]), 열(column) 단위 저장
+// time[] = 현지 날짜/시간을 timegm 으로 변환한 값 (오름차순)
+// 예보는 eWTTR_PARSE_CJSON + j1 요청(WTTR_FETCH_LIGHT 아님)에서만 채워짐.
+// 예보가 없는 응답(j2, streaming 파싱)으로 업데이트하면 같은 좌표의 이전 예보를 유지함
+// (처음부터 light/streaming 으로만 업데이트한 context 의 예보는 비어있음).
+//------------------------------------------------------------------------------
+#define WTTR_FC_MAX     72      /* 3일 x 24시간 */
+
+enum eWttrFcCol {
+    eWTTR_FC_TEMP = 0,  /* 온도 "tempC" */
+    eWTTR_FC_PRECIP,    /* 강수 "precipMM" */
+    eWTTR_FC_WIND,      /* 풍속 "windspeedKmph" */
+    eWTTR_FC_RAIN,      /* 강수확률 "chanceofrain" */
+    eWTTR_FC_COL_END
+};
+
+typedef struct wttr_forecast__t {
+    int     cnt;
+    time_t  time [WTTR_FC_MAX];
+    float   col  [eWTTR_FC_COL_END][WTTR_FC_MAX];
+    short   code [WTTR_FC_MAX];     /* 날씨 코드 "weatherCode" */
+}   wttr_forecast_t;
+
+typedef struct wttr_fc_stats__t {
+    int     cnt;
+    float   min, max, mean;
+}   wttr_fc_stats_t;
+
+//------------------------------------------------------------------------------
+// 지역별 날씨 context (opaque). 각 context 는 자신의 snapshot 을 가지며
+// 서로 다른 context 는 여러 thread 에서 동시에 update 가능함.
+//------------------------------------------------------------------------------
+typedef struct wttr_ctx__t wttr_ctx_t;
+
+//------------------------------------------------------------------------------
+// 지역 registry handle (wttr_loc_intern), 프로그램 종료까지 유효함
+//------------------------------------------------------------------------------
+typedef int wttr_loc_t;
+
+#define WTTR_LOC_INVALID    (-1)
+
+//------------------------------------------------------------------------------
+// cache 통계 (wttr_cache_get_stats, wttr_geo_cache_get_stats)
+//------------------------------------------------------------------------------
+typedef struct wttr_cache_stats__t {
+    unsigned long   hit;        /* TTL 이내 */
+    unsigned long   miss;       /* network 요청 */
+    unsigned long   stale;      /* TTL 초과, 기존 값 반환 후 갱신 */
+    unsigned long   evict;      /* 메모리 제한으로 삭제 */
+    unsigned long   entries;
+    size_t          bytes;
+}   wttr_cache_stats_t;
+
+//------------------------------------------------------------------------------
+// 요청 단계별 시간 histogram (endpoint 별, wttr_stats_get)
+//   DNS/CONNECT/TLS = 각 단계에 걸린 시간 (재사용된 연결은 0)
+//   TTFB/TOTAL      = 요청 시작부터 첫 byte 수신/완료까지
+//   PARSE           = 응답 파싱 (streaming 은 수신과 동시에 처리되므로 기록안함)
+// bucket[i] = 시간이 WTTR_HIST_BOUNDS_US[i] 이하인 요청 수 (누적 아님),
+// bucket[WTTR_HIST_CNT] = 마지막 경계 초과
+//------------------------------------------------------------------------------
+#define WTTR_HIST_CNT       14
+#define WTTR_HIST_BOUNDS_US { 500, 1000, 2500, 5000, 10000, 25000, 50000, \
+                              100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000 }
+
+enum eWttrPhase {
+    eWTTR_PH_DNS = 0,
+    eWTTR_PH_CONNECT,
+    eWTTR_PH_TLS,
+    eWTTR_PH_TTFB,
+    eWTTR_PH_TOTAL,
+    eWTTR_PH_PARSE,
+    eWTTR_PH_END
+};
+
+enum eWttrOutcome {
+    eWTTR_OUT_OK = 0,       /* 수신 및 파싱 성공 */
+    eWTTR_OUT_NET,          /* 연결/timeout 등 cURL 오류 */
+    eWTTR_OUT_HTTP,         /* 4xx/5xx 응답 */
+    eWTTR_OUT_PARSE,        /* 응답 파싱 실패 */
+    eWTTR_OUT_END
+};
+
+typedef struct wttr_hist__t {
+    unsigned long long  cnt;
+    unsigned long long  sum_us;
+    unsigned long long  bucket [WTTR_HIST_CNT + 1];
+}   wttr_hist_t;
+
+typedef struct wttr_req_stats__t {
+    unsigned long long  requests;
+    unsigned long long  rx_bytes;           /* 수신된 header + body */
+    unsigned long long  coalesced;          /* 진행중인 같은 요청의 결과를 받은 호출 (요청 안함) */
+    unsigned long long  retries;            /* 재시도한 요청 */
+    unsigned long long  queued;             /* token 을 기다린 뒤 보낸 요청 */
+    unsigned long long  queue_wait_us;      /* token 을 기다린 시간 합 */
+    unsigned long long  rate_rejected;      /* token 대기 시간 초과로 보내지 않은 요청 */
+    unsigned long long  breaker_rejected;   /* circuit open 상태라 보내지 않은 요청 */
+    unsigned long long  breaker_opened;     /* circuit open 횟수 */
+    unsigned long long  served_cached;      /* 요청 실패시 cache 값으로 응답 */
+    unsigned long long  deadline_exceeded;  /* 남은 시간 budget 이 부족하여 보내지/재시도하지 않은 요청 */
+    unsigned long long  hedge_wins;         /* 먼저 도착하여 사용된 hedge 응답 (fallback) */
+    unsigned long long  recent_p95_us;      /* 최근 성공한 요청 시간의 p95 (표본이 부족하면 0) */
+    unsigned long long  outcome [eWTTR_OUT_END];
+    wttr_hist_t         phase   [eWTTR_PH_END];
+}   wttr_req_stats_t;
+
 //------------------------------------------------------------------------------
 #if 0
 서버 응답 내용:
@@ -147,6 +340,21 @@ typedef struct wttr_data__t {
 //
 // Lib weather API
 //
+//------------------------------------------------------------------------------
+// 언어 pack 등록/검색, 반환값 = 언어 id (enum eWttrLang 또는 등록된 id)
+//------------------------------------------------------------------------------
+extern int wttr_lang_register (const wttr_lang_t *lang);
+extern int wttr_lang_find     (const char *code);
+
+//------------------------------------------------------------------------------
+// 날씨 코드, 풍향, 자외선 지수 변환 (lang = 언어 id)
+// 풍향은 360도 단위로 정규화, 음수 자외선 지수는 "Low" 로 처리함.
+// translate_* 함수는 이전 문자열 기반 동작(atoi, 정확한 코드 비교)을 유지함.
+//------------------------------------------------------------------------------
+extern const char *wttr_weather_code_str (int code,   int lang);
+extern const char *wttr_wind_degree_str  (int degree, int lang);
+extern const char *wttr_uv_index_str     (int index,  int lang);
+
 //------------------------------------------------------------------------------
 // 풍향 변환
 //------------------------------------------------------------------------------
@@ -162,9 +370,21 @@ extern const char* translate_weather_code(const char* code, int is_kor);
 //------------------------------------------------------------------------------
 extern const char* translate_uv_index (const char* index, int is_kor);
 
+//------------------------------------------------------------------------------
+// 지역을 한글로 입력시 인코딩 (반환값은 free 필요)
+//------------------------------------------------------------------------------
+extern char *url_encode (const char *str);
+
 //------------------------------------------------------------------------------
 // 숫자를 한글로 출력
+// wttr_int_to_kor : int 전체 범위 (음수 = "마이너스"), 반환값 = 문자열 길이
+//                   buf 가 작으면 빈 문자열 및 -1 (WTTR_KOR_NUM_SIZE 이상이면 항상 성공)
+// int_to_kor_buf  : output = WTTR_DATA_SIZE 크기 buffer
+// int_to_kor      : thread 별 buffer 반환
 //------------------------------------------------------------------------------
+#define WTTR_KOR_NUM_SIZE   72      /* "마이너스이십일억사천칠백사십팔만삼천육백사십팔" + '\0' */
+
+extern int          wttr_int_to_kor (int num, char *buf, size_t size);
 extern void         int_to_kor_buf  (int num, char* output);
 extern const char   *int_to_kor     (int num);
 
@@ -174,10 +394,170 @@ extern const char   *int_to_kor     (int num);
 extern void         date_to_kor_buf (enum eDayItem d_item, void *i_time, char *k_str);
 extern const char   *date_to_kor    (enum eDayItem d_item, void *i_time);
 
+//------------------------------------------------------------------------------
+// 날짜/시간 전체 문장 (t == NULL 이면 WTTR_TIMEZONE 의 현재시간)
+// lang = eWTTR_LANG_KO (한글) / 그외 (영어), 반환값 = 문자열 길이 (buf 가 작으면 -1)
+//------------------------------------------------------------------------------
+#define WTTR_TIMEZONE       "Asia/Seoul"
+#define WTTR_DATE_STR_SIZE  128
+
+extern int          wttr_date_str   (const struct tm *t, int lang, char *buf, size_t size);
+
 //------------------------------------------------------------------------------
 // 위,경도 도시, 지역 이름요청
+// get_location_json     : g_city/g_country 는 각각 WTTR_GEO_NAME_SIZE byte 이상
+// get_location_json_buf : 각각 size byte buffer, 반환값 = 1 (성공) / 0 (실패)
+// buffer 보다 긴 이름은 UTF-8 글자 단위로 자름.
+//------------------------------------------------------------------------------
+extern void get_location_json     (double lat, double lon, char *g_city, char *g_country, int is_kor);
+extern int  get_location_json_buf (double lat, double lon, char *g_city, char *g_country,
+                                   size_t size, int is_kor);
+
+//------------------------------------------------------------------------------
+// 위치 요청 cache (위,경도를 grid_deg 단위로 양자화, 언어별 저장)
+// grid_deg = 0 이면 기본값(0.01도), grid_deg < 0 이면 cache 사용안함 (benchmark 등)
+// path = cache 파일 (NULL 이면 메모리만 사용)
+// 통계는 wttr_cache_stats_t 의 hit/miss/entries/bytes 항목을 사용함.
+//------------------------------------------------------------------------------
+extern void wttr_geo_cache_config    (double grid_deg, const char *path);
+extern void wttr_geo_cache_get_stats (wttr_cache_stats_t *stats);
+
+//------------------------------------------------------------------------------
+// 여러 좌표의 위치 요청 (batch reverse geocoding)
+// 위치 cache 를 공간 index 로 사용하여 이미 알고 있는 위치의 radius_m 안에 있는 점은
+// 요청하지 않고, 새로운 점만 위치 요청 gate(초당 1회)를 거쳐 순서대로 요청함.
+// radius_m <= 0 이면 기본값(WTTR_GEO_RADIUS_M), radius 보다 grid 가 크면 같은 grid 의 값을 사용.
+// 입력 = pt[i].lat/lon, 결과 = city/country/source/dist_m, 반환값 = 이름을 찾은 점의 수
 //------------------------------------------------------------------------------
-extern void get_location_json (double lat, double lon, char *g_city, char *g_country, int is_kor);
+#define WTTR_GEO_NAME_SIZE  256
+#define WTTR_GEO_RADIUS_M   1000
+
+enum eWttrGeoSource {
+    eWTTR_GEO_FAIL = 0,     /* 요청 실패 (city/country = "") */
+    eWTTR_GEO_INDEX,        /* 이미 알고 있던 위치 (radius 안) */
+    eWTTR_GEO_DEDUP,        /* 같은 batch 에서 먼저 요청한 점 (radius 안) */
+    eWTTR_GEO_UPSTREAM,     /* 새로 요청함 (요청 실패시 주변 grid 의 cache 값일 수 있음) */
+};
+
+typedef struct wttr_geo_point__t {
+    double  lat, lon;
+    char    city    [WTTR_GEO_NAME_SIZE];
+    char    country [WTTR_GEO_NAME_SIZE];
+    int     source;                         /* eWTTR_GEO_xxx */
+    double  dist_m;                         /* 사용한 위치와의 거리 (UPSTREAM = 0) */
+}   wttr_geo_point_t;
+
+extern int  wttr_geo_batch           (wttr_geo_point_t *pt, int cnt, int is_kor, double radius_m);
+
+//------------------------------------------------------------------------------
+// 지역 registry
+// intern : 지역을 정규화하여 등록하고 handle 반환 (이미 등록된 지역이면 같은 handle)
+//          "위도,경도" 는 소수점 4자리로 반올림, 지역명은 앞/뒤/연속 공백 제거 및 영문 소문자.
+//          길이 제한 없음, 요청 URL 의 인코딩된 path 는 등록할 때 한번만 만듦.
+//          반환값 = handle / WTTR_LOC_INVALID (메모리 부족, 등록 가능한 수(65536) 초과)
+// coord  : 위,경도로 등록 (wttr_loc_intern ("위도,경도") 와 같음)
+// key    : 정규화된 지역 문자열 (잘못된 handle = NULL)
+//------------------------------------------------------------------------------
+extern wttr_loc_t   wttr_loc_intern (const char *location);
+extern wttr_loc_t   wttr_loc_coord  (double lat, double lon);
+extern const char   *wttr_loc_key   (wttr_loc_t loc);
+
+//------------------------------------------------------------------------------
+// 날씨 Json 요청 (반환값은 호출한 곳에서 free)
+// 같은 지역(지역 registry 정규화)의 요청이 진행중이면 새로 요청하지 않고 그 응답을 받음.
+// get_location_json, update_weather_data 도 동일 (wttr_req_stats_t.coalesced)
+//------------------------------------------------------------------------------
+extern char *get_weather_json (const char *location);
+
+//------------------------------------------------------------------------------
+// 요청 base URL 설정 ("http://127.0.0.1:18080" 등), base_url = NULL 이면 기본값
+// eWTTR_EP_WEATHER/FALLBACK 은 설정(또는 환경변수)한 경우에만 그 provider 의 base 대신 사용함.
+// 반환값 = 1(성공) / 0(잘못된 endpoint, 너무 긴 URL)
+//------------------------------------------------------------------------------
+extern int  wttr_set_endpoint    (enum eWttrEndpoint ep, const char *base_url);
+extern int  wttr_get_endpoint    (enum eWttrEndpoint ep, char *buf, size_t size);
+
+//------------------------------------------------------------------------------
+// wttr.in 요청 방식 설정 및 방식별 수신량 (WTTR_FETCH_xxx)
+//------------------------------------------------------------------------------
+extern void wttr_set_fetch_mode  (int mode);
+extern int  wttr_get_fetch_mode  (void);
+extern void wttr_fetch_get_stats (int mode, wttr_fetch_stats_t *stats);
+
+//------------------------------------------------------------------------------
+// endpoint 별 요청 통계 (단계별 시간 histogram, 결과, 수신량)
+// wttr_stats_dump      : Prometheus text 형식, 반환값 = 필요한 길이 (snprintf 와 동일)
+// wttr_stats_dump_file : node_exporter textfile 등에서 읽을 수 있도록 파일로 저장
+//------------------------------------------------------------------------------
+extern void wttr_stats_get       (enum eWttrEndpoint ep, wttr_req_stats_t *stats);
+extern void wttr_stats_reset     (void);
+extern int  wttr_stats_dump      (char *buf, size_t size);
+extern int  wttr_stats_dump_file (const char *path);
+
+//------------------------------------------------------------------------------
+// upstream 보호 (endpoint 별, 동기/비동기 요청 모두 적용)
+// rate    : token bucket, rate = 초당 요청 수 (0 = 제한없음), burst = 연속으로 보낼 수 있는 수
+//           token 을 max_wait_ms 안에 받을 수 없는 요청은 보내지 않고 실패 처리
+//           기본값 : location 1 req/s, 최대 5초 대기 (nominatim 정책) / weather 제한없음
+// retry   : 연결 오류, timeout, 429, 5xx 응답을 retries 번까지 다시 요청 (기본값 2)
+//           대기 시간 = base_ms * 2^n (max_ms 까지) 의 50~100%, Retry-After 가 있으면 그 이상
+// breaker : 연속 threshold 번 실패하면 open_ms 동안 요청하지 않고 바로 실패 (0 = 사용안함)
+//           그 동안 update 는 이전 snapshot/응답 cache, 위치는 주변 grid 의 cache 값을 사용하고
+//           open_ms 후 한 요청이 성공하면 다시 닫힘 (half-open)
+//------------------------------------------------------------------------------
+enum eWttrBreaker {
+    eWTTR_BREAKER_CLOSED = 0,
+    eWTTR_BREAKER_OPEN,
+    eWTTR_BREAKER_HALF_OPEN,
+};
+
+extern int  wttr_rate_config     (enum eWttrEndpoint ep, double rate, int burst, int max_wait_ms);
+extern int  wttr_retry_config    (enum eWttrEndpoint ep, int retries, int base_ms, int max_ms);
+extern int  wttr_breaker_config  (enum eWttrEndpoint ep, int threshold, int open_ms);
+extern int  wttr_breaker_state   (enum eWttrEndpoint ep);
+
+//------------------------------------------------------------------------------
+// 요청 시간 budget (ms) : 한 호출 안의 token 대기, 재시도, hedge 요청을 모두 포함한 시간
+// (update_weather_data, get_location_json, 비동기 요청 1개 등), 기본값 WTTR_BUDGET_MS
+// 남은 시간이 cURL timeout 이 되고, 남은 시간 안에 보낼 수 없는 요청/재시도는 하지 않음.
+// budget_ms <= 0 이면 기본값, 호출 단위 budget 은 wttr_ctx_update_budget 사용
+//------------------------------------------------------------------------------
+#define WTTR_BUDGET_MS      10000
+
+extern void wttr_set_budget      (int budget_ms);
+
+//------------------------------------------------------------------------------
+// 날씨 provider : 다른 날씨 서비스의 응답을 같은 eWttrItem 항목으로 변환
+//   url   : base URL 과 location 으로 요청 URL 생성, 0 = 지원하지 않는 location
+//   base  : provider 의 기본 base URL, 해당 endpoint 를 설정하지 않았으면 사용 (NULL = endpoint 기본값)
+//   parse : 응답 body ('\0' 로 끝남) → data[cnt].data_str (wttr.in 과 같은 단위/형식),
+//           fc = 시간별 예보 (NULL 가능, 응답에 예보가 없으면 fc->cnt = -1),
+//           반환값 = 1(성공) / 0(실패)
+// wttr_set_provider (eWTTR_EP_WEATHER,  p) : 주 provider (NULL = WttrProviderWttrIn)
+// wttr_set_provider (eWTTR_EP_FALLBACK, p) : 보조 provider (기본값 NULL = 사용안함)
+// 보조 provider 가 있으면 주 provider 의 응답이 최근 p95 시간 안에 오지 않거나 실패할 때
+// 보조 provider 에도 요청하고 먼저 도착한 정상 응답을 사용함 (hedged request).
+// 이 경우 응답은 buffer 로 받아 parse 로 변환함 (eWTTR_PARSE_STREAM 사용안함).
+// wttr_batch_update, wttr_async_update 는 주 provider 로만 요청함 (hedge 요청 안함).
+// WttrProviderOpenMeteo 는 "위도,경도" location 만 지원하며 지역/국가 이름은 비어있음.
+//------------------------------------------------------------------------------
+typedef struct wttr_provider__t {
+    const char  *name;
+    int         (*url)   (const char *base, const char *location, char *url, size_t size);
+    int         (*parse) (const char *body, size_t len, wttr_data_t *data, size_t cnt,
+                          wttr_forecast_t *fc);
+    const char  *base;
+}   wttr_provider_t;
+
+extern const wttr_provider_t WttrProviderWttrIn;
+extern const wttr_provider_t WttrProviderOpenMeteo;
+
+extern int  wttr_set_provider    (enum eWttrEndpoint ep, const wttr_provider_t *provider);
+
+//------------------------------------------------------------------------------
+// HTTP handle pool 및 공유 cache(DNS, TLS session, connection) 해제
+//------------------------------------------------------------------------------
+extern void wttr_http_cleanup (void);
 
 //------------------------------------------------------------------------------
 // 측정시간[eWTTR_LOBS_DATE] (WttrData struct) 데이터 변환
@@ -189,10 +569,169 @@ extern void get_wttr_date (const char *obs_data, struct tm *t);
 //------------------------------------------------------------------------------
 extern const char *get_wttr_data (enum eWttrItem id);
 
+//------------------------------------------------------------------------------
+// 날씨 데이터(wttr) 숫자 값 요청 (update 시점에 한번 변환된 값)
+// get_wttr_tm = 측정시간[eWTTR_LOBS_DATE]
+//------------------------------------------------------------------------------
+extern int      get_wttr_int    (enum eWttrItem id);
+extern double   get_wttr_float  (enum eWttrItem id);
+extern int      get_wttr_tm     (struct tm *t);
+
+//------------------------------------------------------------------------------
+// 시간별 예보 요청 및 시간 범위 [from, to) 통계 (min/max/mean)
+//------------------------------------------------------------------------------
+extern int get_wttr_forecast   (wttr_forecast_t *fc);
+extern int wttr_forecast_stats (const wttr_forecast_t *fc, enum eWttrFcCol col,
+                                time_t from, time_t to, wttr_fc_stats_t *stats);
+
 //------------------------------------------------------------------------------
 // 날씨 데이어(wttr) 업데이트, location = 지역명 (한글/영어)
+// 서버가 ETag/Last-Modified 를 보내면 조건부 요청을 사용하고, 아니면 응답 hash 로
+// 이전 응답과 비교함. 변경이 없으면 파싱하지 않고 WTTR_UPDATE_UNCHANGED 를 반환함.
+// (화면 갱신도 생략 가능, 0 이 아니면 성공이므로 기존 호출 코드는 그대로 동작)
 //------------------------------------------------------------------------------
+#define WTTR_UPDATE_FAIL        0
+#define WTTR_UPDATE_OK          1
+#define WTTR_UPDATE_UNCHANGED   2
+
 extern int update_weather_data (const char *location);
 
+//------------------------------------------------------------------------------
+// background 에서 interval_sec 마다 날씨 데이터 업데이트 (get_wttr_data 는 block 되지 않음)
+//------------------------------------------------------------------------------
+extern int  weather_refresh_start (const char *location, int interval_sec);
+extern void weather_refresh_stop  (void);
+
+//------------------------------------------------------------------------------
+// 지역별 날씨 context API
+// get_wttr_data/update_weather_data 는 wttr_default_ctx() 를 사용함.
+// wttr_ctx_get_data 반환값은 context 별, thread 별 buffer 로 같은 thread 에서 같은 context 의
+// 같은 항목을 다시 요청하거나 context 를 삭제하기 전까지 유효함 (보관하려면 wttr_ctx_get_data_buf).
+//------------------------------------------------------------------------------
+extern wttr_ctx_t   *wttr_default_ctx       (void);
+extern wttr_ctx_t   *wttr_ctx_create        (void);
+extern void         wttr_ctx_destroy        (wttr_ctx_t *ctx);
+extern int          wttr_ctx_update         (wttr_ctx_t *ctx, const char *location);
+extern int          wttr_ctx_update_budget  (wttr_ctx_t *ctx, const char *location, int budget_ms);
+extern int          wttr_ctx_update_loc     (wttr_ctx_t *ctx, wttr_loc_t loc, int budget_ms);
+extern const char   *wttr_ctx_get_data      (wttr_ctx_t *ctx, enum eWttrItem id);
+extern int          wttr_ctx_get_data_buf   (wttr_ctx_t *ctx, enum eWttrItem id, char *buf, size_t size);
+extern int          wttr_ctx_get_int        (wttr_ctx_t *ctx, enum eWttrItem id);
+extern double       wttr_ctx_get_float      (wttr_ctx_t *ctx, enum eWttrItem id);
+extern int          wttr_ctx_get_tm         (wttr_ctx_t *ctx, struct tm *t);
+extern int          wttr_ctx_get_forecast   (wttr_ctx_t *ctx, wttr_forecast_t *fc);
+extern unsigned int wttr_ctx_generation     (wttr_ctx_t *ctx);
+extern int          wttr_ctx_refresh_start  (wttr_ctx_t *ctx, const char *location, int interval_sec);
+extern void         wttr_ctx_refresh_stop   (wttr_ctx_t *ctx);
+
+//------------------------------------------------------------------------------
+// snapshot 파일 (마지막 정상 업데이트 값, 숫자 값, 예보, 그 좌표의 위치 이름)
+// open  : path 설정 후 파일을 읽어 바로 사용 (stale 상태), 이후 업데이트마다 저장
+//         반환값 = 1 (읽음) / 0 (파일 없음, 다른 version 또는 손상된 파일)
+// save  : 지금 저장 (get_location_json 결과를 바로 저장할 때)
+// stale : 파일에서 읽은 값이 아직 업데이트(또는 변경없음 확인)되지 않았으면 1,
+//         saved = 파일 저장 시간
+//------------------------------------------------------------------------------
+extern int          wttr_ctx_snapshot_open  (wttr_ctx_t *ctx, const char *path);
+extern int          wttr_ctx_snapshot_save  (wttr_ctx_t *ctx);
+extern int          wttr_ctx_is_stale       (wttr_ctx_t *ctx, time_t *saved);
+
+extern int          weather_snapshot_open   (const char *path);
+extern int          weather_snapshot_save   (void);
+extern int          get_wttr_stale          (time_t *saved);
+
+//------------------------------------------------------------------------------
+// 공유 메모리 snapshot (daemon 모드)
+// 한 process(daemon) 가 업데이트 값, 예보, 위치 이름을 POSIX shm 에 게시하고
+// 여러 process 가 network 없이 읽음. name 은 shm_open 형식 ("/wttr").
+// writer : shm_open    = segment 생성 후 이후 업데이트마다 게시 (writer 는 하나만 가능)
+//          shm_publish = 지금 다시 게시 (get_location_json 이후)
+// reader : attach 후 getter 는 lock 없이 같은 게시의 값을 복사함 (값이 없으면 0)
+//          generation 이 바뀌면 새 값, wait 는 새 게시 또는 timeout 까지 대기
+//          info 반환값 = writer pid (0 = daemon 종료, 마지막 값은 계속 읽을 수 있음)
+//------------------------------------------------------------------------------
+typedef struct wttr_shm__t wttr_shm_t;
+
+#define WTTR_SHM_NAME       "/wttr"
+
+extern int          wttr_ctx_shm_open       (wttr_ctx_t *ctx, const char *name);
+extern int          wttr_ctx_shm_publish    (wttr_ctx_t *ctx);
+extern void         wttr_ctx_shm_close      (wttr_ctx_t *ctx);
+
+extern int          weather_shm_open        (const char *name);
+extern int          weather_shm_publish     (void);
+
+extern wttr_shm_t   *wttr_shm_attach        (const char *name);
+extern void         wttr_shm_detach         (wttr_shm_t *shm);
+extern unsigned int wttr_shm_generation     (wttr_shm_t *shm);
+extern unsigned int wttr_shm_wait           (wttr_shm_t *shm, unsigned int gen, int timeout_ms);
+extern int          wttr_shm_get_data_buf   (wttr_shm_t *shm, enum eWttrItem id, char *buf, size_t size);
+extern int          wttr_shm_get_int        (wttr_shm_t *shm, enum eWttrItem id);
+extern double       wttr_shm_get_float      (wttr_shm_t *shm, enum eWttrItem id);
+extern int          wttr_shm_get_tm         (wttr_shm_t *shm, struct tm *t);
+extern int          wttr_shm_get_forecast   (wttr_shm_t *shm, wttr_forecast_t *fc);
+extern int          wttr_shm_get_location   (wttr_shm_t *shm, int is_kor, char *city, char *country,
+                                             size_t size);
+extern int          wttr_shm_info           (wttr_shm_t *shm, time_t *updated, int *stale);
+
+//------------------------------------------------------------------------------
+// 응답 파싱 방식 설정 및 수신된 Json 파싱 (fixture, benchmark 용)
+//------------------------------------------------------------------------------
+extern void         wttr_set_parse_mode     (enum eWttrParse mode);
+extern int          wttr_ctx_parse          (wttr_ctx_t *ctx, const char *json, size_t len,
+                                             enum eWttrParse mode);
+
+//------------------------------------------------------------------------------
+// wttr.in 응답 cache (LRU), 기본값은 사용안함(ttl_sec = 0)
+// TTL 이 지난 항목은 기존 값을 바로 반환하고 background 에서 갱신함.
+//------------------------------------------------------------------------------
+extern void wttr_cache_config    (int ttl_sec, size_t max_bytes);
+extern void wttr_cache_get_stats (wttr_cache_stats_t *stats);
+
+//------------------------------------------------------------------------------
+// 비동기 API (host event loop 에서 사용, curl_multi_socket_action)
+//   socket_cb(fd, what)  : fd 감시 시작/변경 (WTTR_POLL_IN/OUT), WTTR_POLL_REMOVE = 감시 중지
+//   timer_cb(timeout_ms) : timeout_ms 뒤 wttr_async_action(WTTR_ASYNC_TIMEOUT) 호출,
+//                          0 = 바로 호출, -1 = timer 삭제
+// fd 이벤트 또는 timer 만료시 wttr_async_action 을 호출하면 완료된 요청의 callback 이
+// 그 안에서 호출됨. async 객체는 하나의 thread 에서만 사용하며 callback 에서
+// 새 요청은 추가할 수 있으나 wttr_async_destroy 는 호출할 수 없음.
+//------------------------------------------------------------------------------
+#define WTTR_POLL_IN            1
+#define WTTR_POLL_OUT           2
+#define WTTR_POLL_REMOVE        4
+#define WTTR_POLL_ERR           8
+#define WTTR_ASYNC_TIMEOUT      (-1)
+
+typedef struct wttr_async__t wttr_async_t;
+
+typedef void (*wttr_async_socket_cb_t)   (int fd, int what, void *userp);
+typedef void (*wttr_async_timer_cb_t)    (long timeout_ms, void *userp);
+/* result = WTTR_UPDATE_OK, WTTR_UPDATE_FAIL, WTTR_UPDATE_UNCHANGED */
+typedef void (*wttr_async_weather_cb_t)  (wttr_ctx_t *ctx, const char *location, int result,
+                                          void *userp);
+/* ok = 0 이면 city, country 는 "" */
+typedef void (*wttr_async_location_cb_t) (double lat, double lon, const char *city,
+                                          const char *country, int ok, void *userp);
+
+extern wttr_async_t *wttr_async_create  (wttr_async_socket_cb_t socket_cb,
+                                         wttr_async_timer_cb_t timer_cb, void *userp);
+extern void         wttr_async_destroy  (wttr_async_t *as);
+extern int          wttr_async_update   (wttr_async_t *as, wttr_ctx_t *ctx, const char *location,
+                                         wttr_async_weather_cb_t cb, void *userp);
+extern int          wttr_async_location (wttr_async_t *as, double lat, double lon, int is_kor,
+                                         wttr_async_location_cb_t cb, void *userp);
+extern int          wttr_async_action   (wttr_async_t *as, int fd, int events);
+extern int          wttr_async_pending  (wttr_async_t *as);
+
+//------------------------------------------------------------------------------
+// 여러 지역 동시 업데이트 (ctx[i] <- location[i])
+// max_inflight = 동시 요청 수 (0 이하 = 기본값), result[i] = 1(성공)/0(실패)
+// 요청 제한/재시도/circuit breaker 는 다른 요청과 같이 적용, budget 은 지역마다 적용
+// 반환값 = 성공한 지역 수
+//------------------------------------------------------------------------------
+extern int wttr_batch_update (wttr_ctx_t **ctx, const char **location, int *result,
+                              int cnt, int max_inflight);
+
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
@@ -17,77 +17,187 @@
 #include <string.h>
 
 #include <time.h>
+#include <unistd.h>
 
 //------------------------------------------------------------------------------
 #include "lib_weather.h"
 
 //------------------------------------------------------------------------------
 #if defined(__LIB_WEATHER_APP__)
+//------------------------------------------------------------------------------
+/* 위치 이름 buffer (UTF-8 한글 지역명은 WTTR_DATA_SIZE 보다 길 수 있음) */
+#define NAME_SIZE   256
+
+//------------------------------------------------------------------------------
+// 공유 메모리 이름 (WTTR_SHM, 기본값 WTTR_SHM_NAME)
+//------------------------------------------------------------------------------
+static const char *shm_name (void)
+{
+    const char *name = getenv ("WTTR_SHM");
+
+    return (name && name[0]) ? name : WTTR_SHM_NAME;
+}
+
+//------------------------------------------------------------------------------
+// daemon 모드 : interval 초마다 업데이트하여 공유 메모리에 게시 (종료하지 않음)
+//------------------------------------------------------------------------------
+static int shm_daemon (wttr_loc_t loc, int interval, int save)
+{
+    if (!weather_shm_open (shm_name ()))
+        return 1;
+
+    printf ("daemon : %s, %d sec\n", shm_name (), interval);
+    for (;;) {
+        int ret = wttr_ctx_update_loc (wttr_default_ctx (), loc, 0);
+
+        /* 변경이 없어도 다시 게시하여 게시 시간(updated)과 generation 을 갱신 (reader 가 기다리지 않도록) */
+        if (ret != WTTR_UPDATE_FAIL) {
+            char city[NAME_SIZE], country[NAME_SIZE];
+
+            /* 위치 이름은 cache 에 저장되므로 같은 좌표이면 network 를 사용하지 않음 */
+            get_location_json (get_wttr_float (eWTTR_LATITUDE), get_wttr_float (eWTTR_LONGITUDE),
+                city, country, 1);
+            get_location_json (get_wttr_float (eWTTR_LATITUDE), get_wttr_float (eWTTR_LONGITUDE),
+                city, country, 0);
+            weather_shm_publish ();
+            if (save && ret == WTTR_UPDATE_OK)
+                weather_snapshot_save ();
+        }
+        sleep (interval);
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// reader 모드 : 공유 메모리의 값을 출력, count 번 새 게시를 기다리며 반복
+//------------------------------------------------------------------------------
+static int shm_reader (int count)
+{
+    wttr_shm_t *shm = wttr_shm_attach (shm_name ());
+    unsigned int gen;
+
+    if (!shm) {
+        fprintf (stderr, "%s : attach error (daemon is not running)\n", shm_name ());
+        return 1;
+    }
+
+    gen = wttr_shm_generation (shm);
+    for (int i = 0; ; i++) {
+        char area[WTTR_DATA_SIZE], city[NAME_SIZE], country[NAME_SIZE];
+        char date_str[WTTR_DATE_STR_SIZE];
+        time_t updated;
+        int stale, pid = wttr_shm_info (shm, &updated, &stale);
+
+        if (wttr_shm_get_data_buf (shm, eWTTR_AREA_NAME, area, sizeof(area))) {
+            if (!wttr_shm_get_location (shm, 1, city, country, sizeof(city)))
+                city[0] = country[0] = '\0';
+            wttr_date_str (localtime (&updated), eWTTR_LANG_KO, date_str, sizeof(date_str));
+            printf ("[%u] %s (%s, %s), %d도, 습도 %d%%%s, %s 게시 (pid %d)\n",
+                gen, area, city, country,
+                wttr_shm_get_int (shm, eWTTR_TEMP), wttr_shm_get_int (shm, eWTTR_HUMIDUTY),
+                stale ? " [stale]" : "", date_str, pid);
+        }
+        else
+            printf ("[%u] no data (pid %d)\n", gen, pid);
+
+        if (i >= count)
+            break;
+        gen = wttr_shm_wait (shm, gen, -1);
+    }
+    wttr_shm_detach (shm);
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 int main(int argc, char *argv[]) {
 
-    char location [WTTR_DATA_SIZE];
+    wttr_loc_t loc;
+    int interval = 0;
+
+    /* -r [count] : 공유 메모리 reader, -d <interval> [location] : daemon */
+    if (argc > 1 && !strcmp (argv[1], "-r"))
+        return shm_reader ((argc > 2) ? atoi (argv[2]) : 0);
 
-    memset (location, 0, sizeof(location));
+    if (argc > 2 && !strcmp (argv[1], "-d")) {
+        if ((interval = atoi (argv[2])) <= 0) {
+            fprintf (stderr, "%s : interval error\n", argv[2]);
+            return 1;
+        }
+        argv += 2;
+        argc -= 2;
+    }
 
+    /* 지역은 한번만 정규화/인코딩하여 등록 (길이 제한 없음), 이후 handle 로 요청 */
     switch (argc) {
         /* 지역명 (한글, 영어 사용가능) */
-        case 2:     sprintf (location, "%s", strlen(argv[1]) ? argv[1] : "");   break;
+        case 2:     loc = wttr_loc_intern (argv[1]);                            break;
         /* 위치명 (위도, 경도 입력) */
-        case 3:     sprintf (location, "%s,%s", argv[1], argv[2]);              break;
+        case 3:     loc = wttr_loc_coord (atof (argv[1]), atof (argv[2]));      break;
         /* 현 위치 (IP위치 검색) */
-        default :   sprintf (location, "%s", "");                               break;
+        default :   loc = wttr_loc_intern ("");                                 break;
     }
+    if (loc == WTTR_LOC_INVALID) {
+        fprintf (stderr, "location error\n");
+        return 1;
+    }
+
+    /* 이전 실행에서 저장한 값을 먼저 표시 (WTTR_SNAPSHOT = snapshot 파일) */
+    const char *snap_path = getenv ("WTTR_SNAPSHOT");
+    time_t saved;
+
+    if (snap_path && weather_snapshot_open (snap_path) && get_wttr_stale (&saved)) {
+        char date_str[WTTR_DATE_STR_SIZE];
+
+        wttr_date_str (localtime (&saved), eWTTR_LANG_KO, date_str, sizeof(date_str));
+        printf ("[stale] %s, %s도 (%s 저장)\n",
+            get_wttr_data (eWTTR_AREA_NAME), get_wttr_data (eWTTR_TEMP), date_str);
+    }
+
+    if (interval)
+        return shm_daemon (loc, interval, snap_path != NULL);
 
-    if (update_weather_data (location)) {
-        char city[WTTR_DATA_SIZE], country[WTTR_DATA_SIZE];
+    if (wttr_ctx_update_loc (wttr_default_ctx (), loc, 0)) {
+        char city[NAME_SIZE], country[NAME_SIZE];
 
         /* 측정되어진 wttr 좌표 데이터*/
         printf ("Lati : %s, Longi : %s\n", get_wttr_data (eWTTR_LATITUDE), get_wttr_data (eWTTR_LONGITUDE));
 
         /* 좌표기준으로 위치 검색 */
         get_location_json (
-            atof(get_wttr_data (eWTTR_LATITUDE)),
-            atof(get_wttr_data (eWTTR_LONGITUDE)),
+            get_wttr_float (eWTTR_LATITUDE),
+            get_wttr_float (eWTTR_LONGITUDE),
             city, country, 1);
 
         printf ("Korean : city(%s), country(%s)\n", city, country);
 
         get_location_json (
-            atof(get_wttr_data (eWTTR_LATITUDE)),
-            atof(get_wttr_data (eWTTR_LONGITUDE)),
+            get_wttr_float (eWTTR_LATITUDE),
+            get_wttr_float (eWTTR_LONGITUDE),
             city, country, 0);
 
         printf ("English : city(%s), country(%s)\n", city, country);
 
+        /* 위치 이름도 snapshot 에 저장 */
+        if (snap_path)
+            weather_snapshot_save ();
+
         char kor_str[WTTR_DATA_SIZE];
 
         // void date_to_kor_buf (enum eDayItem d_item, void *i_time, char *k_str)
-        int_to_kor_buf (atoi(get_wttr_data (eWTTR_TEMP_FEEL)), kor_str);
+        int_to_kor_buf (get_wttr_int (eWTTR_TEMP_FEEL), kor_str);
         printf ("체감온도 : %s도씨\n", kor_str);
 
         {
             struct tm t;
+            char date_str[WTTR_DATE_STR_SIZE];
+
+            get_wttr_tm (&t);
+            // int wttr_date_str (const struct tm *t, int lang, char *buf, size_t size)
+            wttr_date_str (&t, eWTTR_LANG_KO, date_str, sizeof(date_str));
+            printf ("측정시간 : %s\n", date_str);
 
-            get_wttr_date (get_wttr_data (eWTTR_LOBS_DATE), &t);
-            // void date_to_kor     (enum eDayItem d_item, void *i_time, char *k_str)
-            printf ("측정시간 : ");
-            printf ("%s년 ", date_to_kor (eDAY_YEAR, (void *)&t));
-            printf ("%s월 ", date_to_kor (eDAY_MONTH, (void *)&t));
-            printf ("%s일 ", date_to_kor (eDAY_DAY, (void *)&t));
-            printf ("%s요일 ", date_to_kor (eDAY_W_DAY, (void *)&t));
-            printf ("%s ", date_to_kor (eDAY_AM_PM, (void *)&t));
-            printf ("%s시 ", date_to_kor (eDAY_HOUR, (void *)&t));
-            printf ("%s분\n", date_to_kor (eDAY_MIN, (void *)&t));
-
-            printf ("현재시간 : ");
-            printf ("%s년 ", date_to_kor (eDAY_YEAR, NULL));
-            printf ("%s월 ", date_to_kor (eDAY_MONTH, NULL));
-            printf ("%s일 ", date_to_kor (eDAY_DAY, NULL));
-            printf ("%s요일 ", date_to_kor (eDAY_W_DAY, NULL));
-            printf ("%s ", date_to_kor (eDAY_AM_PM, NULL));
-            printf ("%s시 ", date_to_kor (eDAY_HOUR, NULL));
-            printf ("%s분\n", date_to_kor (eDAY_MIN, NULL));
+            wttr_date_str (NULL, eWTTR_LANG_KO, date_str, sizeof(date_str));
+            printf ("현재시간 : %s\n", date_str);
         }
     }
     return 0;